@@ -1,306 +1,1802 @@
-/**
- *
- * Application
- *
- */
-
-#pragma once
-
-#include <app/bfs.h>
-
-#include <auxiliary/logger.h>
-#include <auxiliary/test.h>
-
-#include <memory>
-#include <cassert>
-
-/*
- *
- * TEST PARAMETERS
- * 
- * RUN FINAL TEST WITH DEFAULT VALUES.
- * 
- */
-static const int NUM_DATASET_LEVELS = 5; ///< Depth of the graph (default: 5)
-static const int NUM_DATASET_NODES  = 5; ///< Number of child nodes per node (default: 5)
-
-/**
- *
- * Breadth-First-Search Application
- *
- */
-class Application {
-	
-	public:
-		Application() { ; }
-
-	public:
-
-		/**
-		 *
-		 * Run application
-		 *
-		 * @return Returns 0 is search was successful, -1 in case of error.
-		 *
-		 */
-		int run() {
-
-			auto bfs = std::make_unique<BreadthFirstSearch>();
-			auto graph = createGraph(NUM_DATASET_LEVELS, NUM_DATASET_NODES);
-			bool status = performSearch(bfs, graph);
-		
-			return (status ? 1 : -1);
-		}
-
-	private:
-		/**
-		 * 
-		 * Create child nodes.
-		 * 
-		 * This method recursively creates child nodes of a node.
-		 * 
-		 * @param root Root node to create childs for
-		 * @param numNodes Number of child nodes per parent node to create
-		 * @param numLevels Depth of the recursion to create child nodes
-		 * @param level Internal level counter
-		 * @param idx Internal node index counter
-		 * 
-		 * IMPORTANT: This method is not thread-safe!
-		 * 
-		 */
-		void createChilds(GraphRef graph, NodeRef parent, int numNodes, int numLevels, int level) {
-		
-			char nameBuffer[64];
-		
-			for (int i=0; i<numNodes; i++) {
-		
-				sprintf(nameBuffer, "Node%d", (int) graph->size()-1);
-		
-				auto child = graph->addNode(nameBuffer);
-
-				if (nullptr != parent) {
-					graph->addEdge(parent, child);
-				}
-		
-				if (level  < numLevels)
-				{
-					createChilds(graph, child, numNodes, numLevels, level+1);
-				}
-			}
-		
-		}
-		
-		/**
-		 * 
-		 * Create dataset
-		 * 
-		 * This method creates a graph with a given depth and given
-		 * number of childs per parent node
-		 * 
-		 * @param levels Number of hierarchy levels (depth) of the graph
-		 * @param nodes Number of nodes per parent node
-		 * @return Returns a reference to the root node of the graph
-		 * 
-		 * IMPORTANT: This method is not thread-safe!
-		 * 
-		 */
-		GraphRef createGraph(int levels, int nodes) {
-		
-			Log::infof("creating dataset...");
-
-			auto graph = GraphRef(new Graph());
-
-			graph->addNode("root");
-		
-			for (int level=0; level<levels; level++) {
-				createChilds(graph, graph->getFirst(), nodes, levels, 0);
-			}
-
-			size_t numNodes = graph->size();
-			size_t numEdges = 0;
-
-			for (size_t edgeDistance = 2; edgeDistance < numNodes/2; edgeDistance *= 2) {
-
-				for (size_t index = 0; index < (numNodes - edgeDistance*2); index += edgeDistance*2) {
-					NodeRef node1 = graph->getNode(index);
-					assert(nullptr != node1);
-
-					NodeRef node2 = graph->getNode(index + edgeDistance);
-					assert(nullptr != node1);
-
-					graph->addEdge(node1, node2);
-					numEdges++;
-				
-				}
-			}
-		
-			Log::infof("created dataset with %d nodes, %d cross-level edges", (int) numNodes, (int) numEdges);
-		
-			return graph;
-		}
-		
-		/**
-		 * 
-		 * Perform search
-		 * 
-		 * This method performs multiple breadth-first-searches on a
-		 * given graph.
-		 * 
-		 * @param bfs Reference to breadth first search implementation
-		 * @param graph Reference to a given graph
-		 * @return Returns true if all search operations worked as expected,
-		 * false otherwise.
-		 * 
-		 */
-		bool performSearch(std::unique_ptr<BreadthFirstSearch>& bfs, GraphRef graph) {
-		
-			int absNodeCount = (int) graph->size();
-			int notFoundNodeCount = 0;
-		
-			{
-				Log::info("Searching existing...");
-		
-				auto tStart = std::chrono::high_resolution_clock::now();
-		
-				char nameBuffer[64];
-
-				int percent = -1;
-
-				for (int node = 0; node < absNodeCount; node += 23) {
-					sprintf(nameBuffer, "Node%d", node);
-
-					int nextPercent = (((node+1)*100)/absNodeCount);
-					if (nextPercent != percent) {
-						percent = nextPercent;
-						printf("\r%d%%", percent);
-						fflush (stdout);
-					}
-
-					if (nullptr == bfs->find(graph, nameBuffer)) {
-						printf("\nnot found: %s\n", nameBuffer);
-						bfs->find(graph, nameBuffer);
-						notFoundNodeCount++;
-					}
-				}
-
-				printf("\r             \r");
-		
-				auto tElapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
-				Log::infof("Search existing - elapsed time = %0.3f seconds", tElapsed);
-		
-				if (notFoundNodeCount > 0) {
-					Log::errorf("%d nodes have not been found!", notFoundNodeCount);
-					return false;
-				}
-			}
-		
-			{
-				Log::info("Searching for non-existing...");
-		
-				auto tStart = std::chrono::high_resolution_clock::now();
-				auto result = bfs->find(graph, "DOES_NOT_EXIST");
-				auto tElapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
-
-				Log::infof("Search for non-existing time = %0.3f seconds", tElapsed);
-				if (nullptr != result) {
-					Log::error("non-existing nodes have been found!");
-					return false;
-				}					
-					
-			}
-		
-			return true;
-		}
-
-};
-
-IMPLEMENT_TEST(minimalisticTest) {
-	
-	// create BFS object
-	auto bfs = std::make_unique<BreadthFirstSearch>();
-	testAssert(nullptr != bfs);
-
-	// create graph
-	auto graph = Graph::createInstance();
-	testAssert(nullptr != graph);
-
-	// check if everything is clean at the beginning
-	testAssert(graph->empty());
-	testAssert(graph->size() == 0);
-	testAssert(nullptr == graph->getNode(0));
-	testAssert(nullptr == graph->getFirst());
-
-	// add nodes
-	auto a = graph->addNode("A");
-	auto b = graph->addNode("B");
-	auto c = graph->addNode("C");
-	auto d = graph->addNode("D");
-	auto e = graph->addNode("E");
-	auto f = graph->addNode("F");
-	auto g = graph->addNode("G");
-	auto h = graph->addNode("H");
-
-	// check if the graph is filled
-	testAssert(!graph->empty());
-	testAssert(graph->size() == 8);
-
-	auto graphFirst = graph->getFirst();					// get first element
-	testAssert(nullptr != graphFirst);						// found an element
-	testAssert(0 == graphFirst->getId().compare("A"));		// really element "A"
-	auto graph0 = graph->getNode(0);						// get element 0
-	testAssert(nullptr != graph0);							// found an element
-	testAssert(0 == graph0->getId().compare("A"));			// really element "A"
-	testAssert(graphFirst.get() == graph0.get());			// point to the same object
-
-	graph->addEdge(a, d);									// add edges ...
-	testAssert(a->getConnections().size() == 1);			// ... and check connections
-	testAssert(d->getConnections().size() == 1);
-
-	graph->addEdge(a, e);
-	testAssert(a->getConnections().size() == 2);
-	testAssert(e->getConnections().size() == 1);
-
-	graph->addEdge(c, f);
-	testAssert(c->getConnections().size() == 1);
-	testAssert(f->getConnections().size() == 1);
-
-	graph->addEdge(c, g);
-	testAssert(c->getConnections().size() == 2);
-	testAssert(g->getConnections().size() == 1);
-
-	graph->addEdge(e, h);
-	testAssert(e->getConnections().size() == 2);
-	testAssert(h->getConnections().size() == 1);
-
-	graph->addEdge(a, g);
-	testAssert(a->getConnections().size() == 3);
-	testAssert(g->getConnections().size() == 2);
-
-	graph->addEdge(f, e);
-	testAssert(f->getConnections().size() == 2);
-	testAssert(e->getConnections().size() == 3);
-
-	graph->addEdge(b, g);
-	testAssert(b->getConnections().size() == 1);
-	testAssert(g->getConnections().size() == 3);
-
-	// check if node is found
-	auto result = bfs->find(graph, "H");					
-	testAssert(nullptr != result);
-
-	// check if found node is the correct one
-	if (nullptr != result) {
-		testAssert(0 == h->getId().compare(result->getId()));
-	}
-
-	// check if non-existing node is not found
-	testAssert(nullptr == bfs->find(graph, "DOES_NOT_EXIST"));
-
-	// check cleanup
-	graph->clear();
-	testAssert(graph->empty());
-	testAssert(graph->size() == 0);
-	testAssert(nullptr == graph->getNode(0));
-	testAssert(nullptr == graph->getFirst());
-
-}
+/**
+ *
+ * Application
+ *
+ */
+
+#pragma once
+
+#include <app/benchmark.h>
+#include <app/bfs.h>
+#include <app/concurrent.h>
+#include <app/generator.h>
+#include <app/graphfile.h>
+#include <app/importer.h>
+#include <app/partition.h>
+#include <app/query_service.h>
+#include <app/reorder.h>
+
+#include <auxiliary/logger.h>
+#include <auxiliary/test.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/*
+ *
+ * TEST PARAMETERS
+ * 
+ * RUN FINAL TEST WITH DEFAULT VALUES.
+ * 
+ */
+static const int NUM_DATASET_LEVELS = 5; ///< Depth of the graph (default: 5)
+static const int NUM_DATASET_NODES  = 5; ///< Number of child nodes per node (default: 5)
+
+/**
+ *
+ * Breadth-First-Search Application
+ *
+ */
+class Application {
+	
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param levels Depth of the dataset
+		 * @param nodes Number of child nodes per node of the dataset
+		 *
+		 */
+		Application(int levels = NUM_DATASET_LEVELS, int nodes = NUM_DATASET_NODES)
+			: m_levels(levels), m_nodes(nodes) {
+		}
+
+	public:
+
+		/**
+		 *
+		 * Run application
+		 *
+		 * @return Returns 0 is search was successful, -1 in case of error.
+		 *
+		 */
+		int run() {
+
+			auto bfs = std::make_unique<BreadthFirstSearch>();
+			bfs->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+			bfs->setNumThreads(0);
+
+			auto graph = createGraph(m_levels, m_nodes);
+			if (nullptr == graph) {
+				return -1;
+			}
+			bool status = performSearch(bfs, graph);
+		
+			return (status ? 1 : -1);
+		}
+
+	private:
+		/**
+		 * 
+		 * Create dataset
+		 * 
+		 * This method creates a graph with a given depth and given
+		 * number of childs per parent node, see TreeTopology.
+		 * 
+		 * @param levels Number of hierarchy levels (depth) of the graph
+		 * @param nodes Number of nodes per parent node
+		 * @return Returns a reference to the created graph, or nullptr if
+		 * the dataset is too large
+		 * 
+		 */
+		GraphRef createGraph(int levels, int nodes) {
+		
+			LOG_INFOF("creating dataset...");
+
+			DatasetGenerator generator;
+			generator.setTree((size_t) levels, (size_t) nodes);
+
+			auto snapshot = generator.generate();
+			if (nullptr == snapshot) {
+				return nullptr;
+			}
+
+			// nodes in search order, so traversals walk memory front to back
+			auto graph = Graph::createInstance(*NodeReordering(NodeReordering::OrderBfs).apply(*snapshot));
+			graph->enableIdIndex(true);
+
+			LOG_INFOF("created dataset with %d nodes, %d cross-level edges",
+				(int) graph->size(), (int) TreeTopology((size_t) levels, (size_t) nodes).numCrossEdges());
+		
+			return graph;
+		}
+		
+		/**
+		 * 
+		 * Perform search
+		 * 
+		 * This method performs multiple breadth-first-searches on a
+		 * given graph.
+		 * 
+		 * @param bfs Reference to breadth first search implementation
+		 * @param graph Reference to a given graph
+		 * @return Returns true if all search operations worked as expected,
+		 * false otherwise.
+		 * 
+		 */
+		bool performSearch(std::unique_ptr<BreadthFirstSearch>& bfs, GraphRef graph) {
+		
+			int absNodeCount = (int) graph->size();
+			int notFoundNodeCount = 0;
+		
+			{
+				LOG_INFO("Searching existing...");
+		
+				auto tStart = std::chrono::high_resolution_clock::now();
+		
+				char nameBuffer[64];
+
+				int percent = -1;
+
+				for (int node = 0; node < absNodeCount; node += 23) {
+					sprintf(nameBuffer, "Node%d", node);
+
+					int nextPercent = (((node+1)*100)/absNodeCount);
+					if (nextPercent != percent) {
+						percent = nextPercent;
+						printf("\r%d%%", percent);
+						fflush (stdout);
+					}
+
+					if (nullptr == bfs->find(graph, nameBuffer)) {
+						printf("\nnot found: %s\n", nameBuffer);
+						bfs->find(graph, nameBuffer);
+						notFoundNodeCount++;
+					}
+				}
+
+				printf("\r             \r");
+		
+				auto tElapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+				LOG_INFOF("Search existing - elapsed time = %0.3f seconds", tElapsed);
+		
+				if (notFoundNodeCount > 0) {
+					LOG_ERRORF("%d nodes have not been found!", notFoundNodeCount);
+					return false;
+				}
+			}
+		
+			{
+				LOG_INFO("Searching for non-existing...");
+		
+				auto tStart = std::chrono::high_resolution_clock::now();
+				auto result = bfs->find(graph, "DOES_NOT_EXIST");
+				auto tElapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+				LOG_INFOF("Search for non-existing time = %0.3f seconds", tElapsed);
+				if (nullptr != result) {
+					LOG_ERROR("non-existing nodes have been found!");
+					return false;
+				}					
+					
+			}
+		
+			return true;
+		}
+
+	private:
+		int m_levels;
+		int m_nodes;
+
+};
+
+/**
+ * 
+ * Create the test dataset
+ * 
+ * @param levels Number of hierarchy levels, see TreeTopology
+ * @param fanout Number of children per node
+ * @return Returns a tree with power-of-two cross-level edges, shaped
+ * like the application dataset
+ * 
+ */
+static GraphRef createTestTree(size_t levels, size_t fanout) {
+	DatasetGenerator generator;
+	generator.setTree(levels, fanout);
+	return Graph::createInstance(*generator.generate());
+}
+
+/**
+ * 
+ * Add the power-of-two cross-level edges of the test dataset
+ * 
+ * @param graph Graph whose nodes are connected, in index order
+ * 
+ */
+static void addCrossEdges(Graph& graph) {
+	size_t numNodes = graph.size();
+	for (size_t distance = 2; distance < numNodes / 2; distance *= 2) {
+		for (size_t index = 0; index < numNodes - distance * 2; index += distance * 2) {
+			graph.addEdge(graph.getNode(index), graph.getNode(index + distance));
+		}
+	}
+}
+
+/**
+ * 
+ * Reference BFS
+ * 
+ * @param graph Graph to be traversed
+ * @param source Start node
+ * @param order Receives the reached nodes in visiting order, or null
+ * @return Returns the hop distance of every node from the source, or
+ * UNREACHABLE_DEPTH for nodes that cannot be reached
+ * 
+ */
+static std::vector<uint32_t> referenceDepths(const CsrGraph& graph, NodeIndex source = 0, std::vector<NodeIndex>* order = nullptr) {
+	std::vector<uint32_t> depth(graph.size(), UNREACHABLE_DEPTH);
+	std::vector<NodeIndex> queue(1, source);
+	depth[source] = 0;
+	for (size_t head = 0; head < queue.size(); head++) {
+		for (const NodeIndex* it = graph.neighborsBegin(queue[head]); it != graph.neighborsEnd(queue[head]); ++it) {
+			if (UNREACHABLE_DEPTH != depth[*it]) continue;
+			depth[*it] = depth[queue[head]] + 1;
+			queue.push_back(*it);
+		}
+	}
+	if (nullptr != order) {
+		order->swap(queue);
+	}
+	return depth;
+}
+
+/**
+ * 
+ * Compare two snapshots
+ * 
+ * @return Returns true if both have the same identifiers and adjacency
+ * lists in the same order, false otherwise.
+ * 
+ */
+static bool sameGraph(CsrGraphRef a, CsrGraphRef b) {
+	if (nullptr == a || nullptr == b || a->size() != b->size() || a->numTargets() != b->numTargets()) {
+		return false;
+	}
+	for (NodeIndex node = 0; node < a->size(); node++) {
+		if (a->getId(node) != b->getId(node)) return false;
+		if (!std::equal(a->neighborsBegin(node), a->neighborsEnd(node), b->neighborsBegin(node))) return false;
+	}
+	return true;
+}
+
+IMPLEMENT_TEST(minimalisticTest) {
+	
+	// create BFS object
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	testAssert(nullptr != bfs);
+
+	// create graph
+	auto graph = Graph::createInstance();
+	testAssert(nullptr != graph);
+
+	// check if everything is clean at the beginning
+	testAssert(graph->empty());
+	testAssert(graph->size() == 0);
+	testAssert(nullptr == graph->getNode(0));
+	testAssert(nullptr == graph->getFirst());
+
+	// add nodes
+	auto a = graph->addNode("A");
+	auto b = graph->addNode("B");
+	auto c = graph->addNode("C");
+	auto d = graph->addNode("D");
+	auto e = graph->addNode("E");
+	auto f = graph->addNode("F");
+	auto g = graph->addNode("G");
+	auto h = graph->addNode("H");
+
+	// check if the graph is filled
+	testAssert(!graph->empty());
+	testAssert(graph->size() == 8);
+
+	auto graphFirst = graph->getFirst();					// get first element
+	testAssert(nullptr != graphFirst);						// found an element
+	testAssert(0 == graphFirst->getId().compare("A"));		// really element "A"
+	auto graph0 = graph->getNode(0);						// get element 0
+	testAssert(nullptr != graph0);							// found an element
+	testAssert(0 == graph0->getId().compare("A"));			// really element "A"
+	testAssert(graphFirst.get() == graph0.get());			// point to the same object
+
+	graph->addEdge(a, d);									// add edges ...
+	testAssert(a->getConnections().size() == 1);			// ... and check connections
+	testAssert(d->getConnections().size() == 1);
+
+	graph->addEdge(a, e);
+	testAssert(a->getConnections().size() == 2);
+	testAssert(e->getConnections().size() == 1);
+
+	graph->addEdge(c, f);
+	testAssert(c->getConnections().size() == 1);
+	testAssert(f->getConnections().size() == 1);
+
+	graph->addEdge(c, g);
+	testAssert(c->getConnections().size() == 2);
+	testAssert(g->getConnections().size() == 1);
+
+	graph->addEdge(e, h);
+	testAssert(e->getConnections().size() == 2);
+	testAssert(h->getConnections().size() == 1);
+
+	graph->addEdge(a, g);
+	testAssert(a->getConnections().size() == 3);
+	testAssert(g->getConnections().size() == 2);
+
+	graph->addEdge(f, e);
+	testAssert(f->getConnections().size() == 2);
+	testAssert(e->getConnections().size() == 3);
+
+	graph->addEdge(b, g);
+	testAssert(b->getConnections().size() == 1);
+	testAssert(g->getConnections().size() == 3);
+
+	// check if node is found
+	auto result = bfs->find(graph, "H");					
+	testAssert(nullptr != result);
+
+	// check if found node is the correct one
+	if (nullptr != result) {
+		testAssert(0 == h->getId().compare(result->getId()));
+	}
+
+	// check if non-existing node is not found
+	testAssert(nullptr == bfs->find(graph, "DOES_NOT_EXIST"));
+
+	// check cleanup
+	graph->clear();
+	testAssert(graph->empty());
+	testAssert(graph->size() == 0);
+	testAssert(nullptr == graph->getNode(0));
+	testAssert(nullptr == graph->getFirst());
+
+}
+
+IMPLEMENT_TEST(csrSnapshotTest) {
+
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	auto graph = Graph::createInstance();
+
+	// empty graph gives an empty snapshot
+	auto emptySnapshot = graph->freeze();
+	testAssert(nullptr != emptySnapshot);
+	testAssert(emptySnapshot->empty());
+	testAssert(INVALID_NODE_INDEX == bfs->find(emptySnapshot, "A"));
+
+	auto a = graph->addNode("A");
+	auto b = graph->addNode("B");
+	auto c = graph->addNode("C");
+	auto d = graph->addNode("D");
+	auto e = graph->addNode("E");
+
+	graph->addEdge(a, b);
+	graph->addEdge(a, c);
+	graph->addEdge(c, d);
+
+	auto snapshot = graph->freeze();
+	testAssert(snapshot.get() == graph->freeze().get());	// cached until modified
+	testAssert(snapshot->size() == 5);
+	testAssert(snapshot->numTargets() == 6);
+	testAssert(snapshot->degree(0) == 2);
+	testAssert(snapshot->degree(4) == 0);
+	testAssert(*snapshot->neighborsBegin(2) == 0);			// C: A then D, in insertion order
+	testAssert(*(snapshot->neighborsBegin(2) + 1) == 3);
+	testAssert(0 == snapshot->getId(3).compare("D"));
+
+	// CSR and pointer based search agree
+	testAssert(3 == bfs->find(snapshot, "D"));
+	testAssert(d == bfs->find(graph, "D"));
+	testAssert(INVALID_NODE_INDEX == bfs->find(snapshot, "E"));	// not reachable from root
+	testAssert(nullptr == bfs->find(graph, "E"));
+
+	// modification invalidates the snapshot
+	graph->addEdge(d, e);
+	auto snapshot2 = graph->freeze();
+	testAssert(snapshot.get() != snapshot2.get());
+	testAssert(4 == bfs->find(snapshot2, "E"));
+	testAssert(snapshot->numTargets() == 6);					// old snapshot is immutable
+
+	// concurrent readers share one snapshot
+	graph->addEdge(b, e);
+	std::vector<CsrGraphRef> frozen(4);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < frozen.size(); t++) {
+		threads.emplace_back([&graph, &frozen, t] { frozen[t] = graph->freeze(); });
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	testAssert(frozen[0] != snapshot2 && std::all_of(frozen.begin(), frozen.end(), [&frozen](const CsrGraphRef& other) {
+		return other == frozen[0];
+	}));
+
+}
+
+IMPLEMENT_TEST(directionOptimizingTest) {
+
+	// small version of the application dataset
+	auto graph = createTestTree(3, 3);
+	auto snapshot = graph->freeze();
+
+	auto topDown = std::make_unique<BreadthFirstSearch>();
+	auto hybrid = std::make_unique<BreadthFirstSearch>();
+	hybrid->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+
+	auto eager = std::make_unique<BreadthFirstSearch>();	// bottom-up from the first level on
+	eager->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+	eager->setDirectionThresholds(1e9, 1e9);
+
+	int mismatches = 0;
+	for (size_t i = 0; i < graph->size(); i++) {
+		const std::string& id = snapshot->getId((NodeIndex) i);
+		NodeIndex expected = topDown->find(snapshot, id);
+		if (expected != hybrid->find(snapshot, id)) mismatches++;
+		if (expected != eager->find(snapshot, id)) mismatches++;
+	}
+	testAssert(0 == mismatches);
+
+	testAssert(INVALID_NODE_INDEX == hybrid->find(snapshot, "DOES_NOT_EXIST"));
+	testAssert(INVALID_NODE_INDEX == eager->find(snapshot, "DOES_NOT_EXIST"));
+	testAssert(graph->getNode(snapshot->findById("Node123")) == eager->find(graph, "Node123"));
+
+}
+
+IMPLEMENT_TEST(parallelSearchTest) {
+
+	auto graph = createTestTree(4, 5);
+
+	// duplicate ids on the widest level, the serial order decides
+	std::vector<uint32_t> depth = referenceDepths(*graph->freeze());
+	std::vector<size_t> width;
+	for (uint32_t d : depth) {
+		if (width.size() <= d) width.resize(d + 1, 0);
+		width[d]++;
+	}
+	uint32_t widest = (uint32_t) (std::max_element(width.begin(), width.end()) - width.begin());
+	size_t first = 0;
+	size_t last = 0;
+	for (size_t i = 0; i < depth.size(); i++) {
+		if (depth[i] != widest) continue;
+		if (0 == first) first = i;
+		last = i;
+	}
+
+	auto dupA = graph->addNode("DUP");
+	auto dupB = graph->addNode("DUP");
+	graph->addEdge(graph->getNode(last), dupA);
+	graph->addEdge(graph->getNode(first), dupB);
+
+	auto snapshot = graph->freeze();
+
+	auto serial = std::make_unique<BreadthFirstSearch>();
+	auto parallel = std::make_unique<BreadthFirstSearch>();
+	parallel->setNumThreads(4);
+	auto parallelHybrid = std::make_unique<BreadthFirstSearch>();
+	parallelHybrid->setNumThreads(4);
+	parallelHybrid->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+
+	int mismatches = 0;
+	for (size_t i = 0; i < graph->size(); i += 7) {
+		const std::string& id = snapshot->getId((NodeIndex) i);
+		NodeIndex expected = serial->find(snapshot, id);
+		if (expected != parallel->find(snapshot, id)) mismatches++;
+		if (expected != parallelHybrid->find(snapshot, id)) mismatches++;
+	}
+	testAssert(0 == mismatches);
+
+	auto dup = serial->find(graph, "DUP");
+	testAssert(dup == dupA || dup == dupB);
+	testAssert(parallel->find(graph, "DUP") == dup);
+	testAssert(parallelHybrid->find(graph, "DUP") == dup);
+	testAssert(nullptr == parallel->find(graph, "DOES_NOT_EXIST"));
+
+}
+
+IMPLEMENT_TEST(batchSearchTest) {
+
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	auto graph = Graph::createInstance();
+
+	graph->addNode("root");
+	for (int i = 1; i < 1000; i++) {
+		auto child = graph->addNode("Node" + std::to_string(i % 900));	// ids 1..99 appear twice
+		graph->addEdge(graph->getNode((i - 1) / 3), child);
+	}
+	graph->addNode("UNREACHABLE");
+
+	std::vector<std::string> ids;
+	for (int i = 0; i < 1000; i += 11) {
+		ids.push_back("Node" + std::to_string(i));
+	}
+	ids.push_back("Node5");				// same id twice in one batch
+	ids.push_back("DOES_NOT_EXIST");
+	ids.push_back("UNREACHABLE");
+	ids.push_back("root");
+
+	auto results = bfs->findMany(graph, ids);
+	testAssert(results.size() == ids.size());
+
+	int mismatches = 0;
+	for (size_t i = 0; i < ids.size(); i++) {
+		if (results[i] != bfs->find(graph, ids[i])) mismatches++;
+	}
+	testAssert(0 == mismatches);
+	testAssert(nullptr == results[ids.size() - 2]);
+	testAssert(graph->getFirst() == results[ids.size() - 1]);
+
+	testAssert(bfs->findMany(graph, std::vector<std::string>()).empty());
+
+}
+
+IMPLEMENT_TEST(idIndexTest) {
+
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	auto graph = Graph::createInstance();
+
+	// without index duplicates are allowed, lookups scan
+	auto a = graph->addNode("A");
+	auto a2 = graph->addNode("A");
+	testAssert(nullptr != a2);
+	testAssert(a == graph->findById("A"));
+	testAssert(nullptr == graph->findById("B"));
+
+	// enabling keeps the first of the existing duplicates
+	graph->enableIdIndex(true);
+	testAssert(graph->hasIdIndex());
+	testAssert(a == graph->findById("A"));
+
+	// with index duplicates are rejected
+	auto b = graph->addNode("B");
+	testAssert(nullptr != b);
+	testAssert(nullptr == graph->addNode("B"));
+	testAssert(graph->size() == 3);
+	testAssert(b == graph->findById("B"));
+
+	for (int i = 0; i < 1000; i++) {
+		graph->addEdge(b, graph->addNode("Node" + std::to_string(i)));
+	}
+	graph->addEdge(a, b);
+	testAssert(graph->findById("Node999")->getIndex() == 1002);
+	testAssert(bfs->find(graph, "Node999") == graph->findById("Node999"));
+	testAssert(nullptr == bfs->find(graph, "DOES_NOT_EXIST"));
+
+	auto snapshot = graph->freeze();
+	testAssert(0 == snapshot->findById("A"));
+	testAssert(1002 == snapshot->findById("Node999"));
+	testAssert(!snapshot->contains("DOES_NOT_EXIST"));
+
+	graph->clear();
+	testAssert(nullptr == graph->findById("A"));
+	testAssert(nullptr != graph->addNode("A"));
+
+}
+
+IMPLEMENT_TEST(stringPoolTest) {
+
+	StringPool pool;
+	auto a = pool.intern("Node1");
+	auto b = pool.intern("Node2");
+	testAssert(a != b);
+	testAssert(a == pool.intern("Node1"));				// interned once
+	testAssert(pool.size() == 2);
+	testAssert(b == pool.lookup("Node2"));
+	testAssert(INVALID_STRING_HANDLE == pool.lookup("Node3"));
+	testAssert(0 == pool.str(a).compare("Node1"));
+	testAssert(pool.equals(b, "Node2"));
+	testAssert(pool.intern("") != a);						// empty strings are fine
+	testAssert(INVALID_STRING_HANDLE == pool.intern("Node4", (size_t) UINT32_MAX));	// lengths past 32 bits fail
+	testAssert(pool.size() == 3);
+
+	// nodes of a graph share the graph pool and compare by handle
+	auto graph = Graph::createInstance();
+	auto n1 = graph->addNode("X");
+	auto n2 = graph->addNode("X");
+	testAssert(n1->getIdHandle() == n2->getIdHandle());
+	testAssert(n1->getIdPool() == n2->getIdPool());
+	testAssert(n1->equals(n2));
+	testAssert(n1->equals(Node::createInstance("X")));	// different pools compare by content
+	testAssert(!n1->equals(Node::createInstance("Y")));
+	testAssert(INVALID_STRING_HANDLE == graph->lookupId("Y"));
+
+	// cleared graphs start a new pool, existing nodes stay valid
+	graph->clear();
+	testAssert(0 == n1->getId().compare("X"));
+	testAssert(INVALID_STRING_HANDLE == graph->lookupId("X"));
+
+}
+
+IMPLEMENT_TEST(nodeStorageTest) {
+
+	auto graph = Graph::createInstance();
+
+	auto a = graph->addNode("A");
+	auto b = graph->addNode("B");
+	auto c = graph->addNode("C");
+	testAssert(a.get() + 1 == b.get());						// nodes are contiguous
+	testAssert(b.get() + 1 == c.get());
+	testAssert(a.get() == graph->getNode(0).get());			// handles are stable
+
+	for (int i = 0; i < 100; i++) {
+		graph->addEdge(a, b);								// adjacency grows in the arena
+	}
+	graph->addEdge(a, c);
+	testAssert(a->getConnections().size() == 101);
+	testAssert(a->getConnections()[100] == c.get());
+	testAssert(b->getConnections()[99] == a.get());
+
+	// growing connections do not break up nodes created in between
+	auto d = graph->addNode("D");
+	graph->addEdge(c, d);
+	auto e = graph->addNode("E");
+	graph->addEdge(d, e);
+	auto f = graph->addNode("F");
+	testAssert(c.get() + 1 == d.get());
+	testAssert(d.get() + 1 == e.get());
+	testAssert(e.get() + 1 == f.get());
+
+	// edges to nodes of other graphs are rejected
+	auto other = Node::createInstance("X");
+	graph->addEdge(a, other);
+	testAssert(a->getConnections().size() == 101);
+	testAssert(other->getConnections().empty());
+
+	// references keep a cleared graph's nodes alive
+	graph->clear();
+	testAssert(0 == a->getId().compare("A"));
+	testAssert(a->getConnections()[100] == c.get());
+	testAssert(graph->empty());
+
+}
+
+IMPLEMENT_TEST(shortestPathTest) {
+
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	auto graph = createTestTree(3, 5);
+	const NodeIndex numTree = (NodeIndex) graph->size();
+
+	auto island = graph->addNode("ISLAND");
+	auto snapshot = graph->freeze();
+
+	int wrongDistance = 0;
+	int invalidPath = 0;
+	for (NodeIndex from = 0; from < numTree; from += 397) {
+		auto dist = referenceDepths(*snapshot, from);
+		for (NodeIndex to = 1; to < numTree; to += 131) {
+			auto result = bfs->shortestPath(snapshot, from, to);
+			if (result.distance != (int) dist[to]) wrongDistance++;
+			if (result.path.size() != (size_t) result.distance + 1 || result.path.front() != from || result.path.back() != to) {
+				invalidPath++;
+				continue;
+			}
+			for (size_t i = 1; i < result.path.size(); i++) {
+				if (std::find(snapshot->neighborsBegin(result.path[i - 1]), snapshot->neighborsEnd(result.path[i - 1]), result.path[i])
+						== snapshot->neighborsEnd(result.path[i - 1])) {
+					invalidPath++;
+				}
+			}
+		}
+	}
+	testAssert(0 == wrongDistance);
+	testAssert(0 == invalidPath);
+
+	auto self = bfs->shortestPath(graph, graph->getFirst(), graph->getFirst());
+	testAssert(0 == self.distance);
+	testAssert(1 == self.path.size());
+
+	auto none = bfs->shortestPath(graph, graph->getFirst(), island);
+	testAssert(!none.found());
+	testAssert(none.path.empty());
+
+	auto path = bfs->shortestPath(graph, graph->getNode(7), graph->getNode(2300));
+	testAssert(path.found());
+	testAssert(path.path.front() == graph->getNode(7));
+	testAssert(path.path.back() == graph->getNode(2300));
+
+}
+
+IMPLEMENT_TEST(workspaceTest) {
+
+	BfsWorkspace workspace;
+
+	workspace.reset(4);
+	testAssert(workspace.visit(2));
+	testAssert(!workspace.visit(2));
+	testAssert(workspace.isVisited(2));
+
+	// a new traversal forgets the visited nodes without clearing them
+	workspace.reset(4);
+	testAssert(!workspace.isVisited(2));
+	testAssert(workspace.empty());
+
+	// the ring keeps working when it wraps around
+	workspace.reset(3);
+	for (NodeIndex node = 0; node < 3; node++) {
+		workspace.push(node);
+	}
+	testAssert(0 == workspace.pop());
+	workspace.push(0);
+	testAssert(1 == workspace.pop());
+	testAssert(2 == workspace.pop());
+	testAssert(0 == workspace.pop());
+	testAssert(workspace.empty());
+
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	auto small = Graph::createInstance();
+	auto large = Graph::createInstance();
+
+	small->addNode("root");
+	large->addNode("root");
+	for (int i = 1; i < 2000; i++) {
+		auto node = large->addNode("Node" + std::to_string(i));
+		large->addEdge(large->getNode((i - 1) / 3), node);
+		if (i < 50) {
+			auto other = small->addNode("Node" + std::to_string(i));
+			small->addEdge(small->getNode(i - 1), other);
+		}
+	}
+
+	// one workspace shared by queries on graphs of different sizes
+	BfsWorkspace& shared = BfsWorkspace::forThread();
+	int mismatches = 0;
+	for (int i = 0; i < 2000; i += 37) {
+		std::string id = "Node" + std::to_string(i);
+		for (const GraphRef& graph : { large, small }) {
+			auto expected = graph->findById(id);
+			if (bfs->find(graph, id, shared) != expected) mismatches++;
+			if (bfs->find(graph, id) != expected) mismatches++;
+			NodeIndex index = bfs->find(graph->freeze(), id, shared);
+			if ((nullptr == expected) ? INVALID_NODE_INDEX != index : expected->getIndex() != index) mismatches++;
+		}
+	}
+	testAssert(0 == mismatches);
+	testAssert(&shared == &BfsWorkspace::forThread());
+
+}
+
+IMPLEMENT_TEST(graphFileTest) {
+
+	TempFile temp("graphfile_test.bin");
+	const std::string& path = temp.path();
+
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	auto graph = Graph::createInstance();
+
+	graph->addNode("root");
+	for (int i = 1; i < 1500; i++) {
+		auto node = graph->addNode("Node" + std::to_string(i % 1000));
+		graph->addEdge(graph->getNode((i - 1) / 4), node);
+	}
+	auto snapshot = graph->freeze();
+
+	testAssert(GraphFile::write(graph, path));
+
+	auto mapped = GraphFile::open(path);
+	testAssert(nullptr != mapped);
+	testAssert(mapped->size() == snapshot->size());
+	testAssert(mapped->numTargets() == snapshot->numTargets());
+
+	int mismatches = 0;
+	for (NodeIndex node = 0; node < snapshot->size(); node++) {
+		if (mapped->getId(node) != snapshot->getId(node)) mismatches++;
+		if (!std::equal(snapshot->neighborsBegin(node), snapshot->neighborsEnd(node), mapped->neighborsBegin(node))) mismatches++;
+	}
+	for (int i = 0; i < 1100; i += 7) {
+		std::string id = "Node" + std::to_string(i);
+		if (mapped->findById(id) != snapshot->findById(id)) mismatches++;
+		if (bfs->find(mapped, id) != bfs->find(snapshot, id)) mismatches++;
+	}
+	testAssert(0 == mismatches);
+	testAssert(!mapped->contains("missing"));
+
+	// the mapping outlives the file name and the graph it was written from
+	std::remove(path.c_str());
+	graph->clear();
+	testAssert(INVALID_NODE_INDEX != bfs->find(mapped, "Node999"));
+
+	// a flipped payload byte fails the checksum, but not the header check
+	auto corrupt = [&path, &snapshot](long pos, int whence, size_t count, int value) {
+		testAssert(GraphFile::write(*snapshot, path));
+		FILE* file = fopen(path.c_str(), "r+b");
+		fseek(file, pos, whence);
+		for (size_t i = 0; i < count; i++) {
+			fputc(value, file);
+		}
+		fclose(file);
+	};
+	corrupt(-1, SEEK_END, 1, 0x5a);
+	testAssert(nullptr == GraphFile::open(path));
+	testAssert(nullptr != GraphFile::open(path, false));
+
+	// without the checksum, falling offsets and an index without empty slots are still rejected
+	corrupt(sizeof(GraphFile::Header) + 8, SEEK_SET, 1, 0x5a);
+	testAssert(nullptr == GraphFile::open(path, false));
+
+	GraphFile::Header header;
+	FILE* file = fopen(path.c_str(), "rb");
+	testAssert(1 == fread(&header, sizeof(header), 1, file));
+	fclose(file);
+	size_t slots = sizeof(header) + 8 * ((header.numNodes + 1) + (header.numTargets + 1) / 2 + (header.numNodes + 1) / 2);
+	corrupt((long) slots, SEEK_SET, header.numSlots * sizeof(HashIndex::Slot), 0);
+	testAssert(nullptr == GraphFile::open(path, false));
+
+	std::remove(path.c_str());
+	testAssert(nullptr == GraphFile::open(path));
+
+}
+
+IMPLEMENT_TEST(importerTest) {
+
+	TempFile temp("importer_test.txt");
+	const std::string& path = temp.path();
+
+	// reference graph built through the node API, in order of first appearance
+	auto graph = Graph::createInstance();
+	auto nodeOf = [&graph](const std::string& id) {
+		auto node = graph->findById(id);
+		return (nullptr != node) ? node : graph->addNode(id);
+	};
+	auto connect = [&graph, &nodeOf](const std::string& source, const std::string& target) {
+		auto node = nodeOf(source);
+		graph->addEdge(node, nodeOf(target));
+	};
+
+	FILE* file = fopen(path.c_str(), "wb");
+	fprintf(file, "# comment line\n");
+	for (int i = 1; i < 12000; i++) {
+		std::string source = (i % 3) ? "n" + std::to_string(i / 3) : std::to_string(i / 7);
+		std::string target = "n" + std::to_string(i);
+		if (i % 5) {
+			fprintf(file, "%s %s\n", source.c_str(), target.c_str());
+			connect(source, target);
+		} else {
+			// adjacency list line with tabs and a windows line ending
+			std::string other = std::to_string(i + 1);
+			fprintf(file, "%s\t%s  %s\r\n", source.c_str(), target.c_str(), other.c_str());
+			connect(source, target);
+			connect(source, other);
+		}
+	}
+	fprintf(file, "lonely\n%%another comment\nn7 n7\nlast n1");
+	nodeOf("lonely");
+	connect("n7", "n7");
+	connect("last", "n1");
+	fclose(file);
+
+	auto expected = graph->freeze();
+
+	EdgeListImporter serial(1);
+	testAssert(sameGraph(expected, serial.import(path)));
+
+	// small blocks split lines across reads, more threads split blocks into slices
+	EdgeListImporter parallel(4);
+	testAssert(sameGraph(expected, parallel.import(path)));
+	parallel.setBlockSize(7);
+	testAssert(sameGraph(expected, parallel.import(path)));
+
+	auto imported = serial.import(path);
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	testAssert(imported->contains("lonely"));
+	testAssert(imported->getId(imported->findById("last")) == "last");
+	testAssert(expected->findById("n42") == bfs->find(imported, "n42"));
+
+	std::remove(path.c_str());
+	testAssert(nullptr == serial.import(path));
+
+}
+
+IMPLEMENT_TEST(generatorTest) {
+
+	// reference built node by node, the way the application used to
+	auto buildTree = [](int levels, int nodes) {
+		auto graph = Graph::createInstance();
+		std::function<void(NodeRef, int)> createChilds = [&](NodeRef parent, int level) {
+			for (int i = 0; i < nodes; i++) {
+				auto child = graph->addNode("Node" + std::to_string(graph->size() - 1));
+				graph->addEdge(parent, child);
+				if (level < levels) {
+					createChilds(child, level + 1);
+				}
+			}
+		};
+		graph->addNode("root");
+		for (int level = 0; level < levels; level++) {
+			createChilds(graph->getFirst(), 0);
+		}
+		addCrossEdges(*graph);
+		return graph->freeze();
+	};
+
+	DatasetGenerator serial(1);
+	DatasetGenerator parallel(4);
+
+	int mismatches = 0;
+	for (int levels = 0; levels <= 4; levels++) {
+		for (int nodes = 0; nodes <= 6; nodes += 3) {
+			auto expected = buildTree(levels, nodes);
+			serial.setTree(levels, nodes);
+			parallel.setTree(levels, nodes);
+			if (serial.numNodes() != expected->size() || serial.numEdges() * 2 != expected->numTargets()) mismatches++;
+			if (!sameGraph(expected, serial.generate())) mismatches++;
+			if (!sameGraph(expected, parallel.generate())) mismatches++;
+		}
+	}
+	testAssert(0 == mismatches);
+	testAssert(TreeTopology(5, 5).numNodes() == 97651);
+	testAssert(TreeTopology::nodeId(0) == "root");
+	testAssert(TreeTopology::nodeId(1235) == "Node1234");
+
+	// random graphs only depend on the seed
+	serial.setRmat(12, 8);
+	parallel.setRmat(12, 8);
+	auto rmat = serial.generate();
+	testAssert(rmat->size() == 4096);
+	testAssert(rmat->numTargets() == 2 * 8 * 4096);
+	testAssert(sameGraph(rmat, parallel.generate()));
+	testAssert(rmat->degree(0) > rmat->degree(4095));		// skewed towards low indices
+
+	serial.setUniform(5000, 20000);
+	parallel.setUniform(5000, 20000);
+	auto uniform = serial.generate();
+	testAssert(uniform->numTargets() == 40000);
+	testAssert(sameGraph(uniform, parallel.generate()));
+	parallel.setSeed(2);
+	testAssert(!sameGraph(uniform, parallel.generate()));
+
+	serial.setUniform(0, 0);
+	testAssert(nullptr == serial.generate());
+
+	// a graph copied from a snapshot freezes back into the same snapshot
+	auto tree = buildTree(2, 4);
+	testAssert(sameGraph(tree, Graph::createInstance(*tree)->freeze()));
+
+}
+
+IMPLEMENT_TEST(reorderTest) {
+
+	DatasetGenerator generator(1);
+	generator.setTree(3, 4);
+	auto original = generator.generate();
+
+	// a second component, unreachable from the root
+	auto graph = Graph::createInstance(*original);
+	auto island = graph->addNode("ISLAND");
+	graph->addEdge(island, graph->addNode("SHORE"));
+	auto snapshot = graph->freeze();
+
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+
+	for (auto order : { NodeReordering::OrderBfs, NodeReordering::OrderRcm, NodeReordering::OrderDegree }) {
+		NodeReordering reordering(order);
+		auto reordered = reordering.apply(*snapshot);
+		testAssert(reordered->size() == snapshot->size());
+		testAssert(reordered->numTargets() == snapshot->numTargets());
+		testAssert(0 == reordering.toOriginal(0));
+
+		int mismatches = 0;
+		for (NodeIndex node = 0; node < reordered->size(); node++) {
+			NodeIndex original = reordering.toOriginal(node);
+			if (reordering.toReordered(original) != node) mismatches++;
+			if (reordered->getId(node) != snapshot->getId(original)) mismatches++;
+			if (reordered->degree(node) != snapshot->degree(original)) mismatches++;
+			for (size_t i = 0; i < reordered->degree(node); i++) {
+				if (reordering.toOriginal(reordered->neighborsBegin(node)[i]) != snapshot->neighborsBegin(original)[i]) mismatches++;
+			}
+			const std::string& id = snapshot->getId(original);
+			if (reordered->findById(id) != node) mismatches++;
+			NodeIndex found = bfs->find(reordered, id);
+			if ((INVALID_NODE_INDEX == found) ? INVALID_NODE_INDEX != bfs->find(snapshot, id) : reordering.toOriginal(found) != bfs->find(snapshot, id)) mismatches++;
+		}
+		testAssert(0 == mismatches);
+	}
+
+	// BFS order numbers nodes the way a search visits them
+	NodeReordering bfsOrder;
+	auto ordered = bfsOrder.apply(*snapshot);
+	std::vector<NodeIndex> queue;
+	referenceDepths(*ordered, 0, &queue);
+	bool inOrder = true;
+	for (size_t i = 0; i < queue.size(); i++) {
+		if (queue[i] != i) inOrder = false;
+	}
+	testAssert(inOrder);
+	testAssert(ordered->getId((NodeIndex) ordered->size() - 2) == "ISLAND");
+
+	auto reorderedGraph = bfsOrder.apply(graph);
+	testAssert(reorderedGraph->size() == graph->size());
+	testAssert(reorderedGraph->findById("SHORE")->getIndex() == ordered->findById("SHORE"));
+	testAssert(nullptr != bfs->find(reorderedGraph, "Node42"));
+
+}
+
+IMPLEMENT_TEST(simdScanTest) {
+
+	std::vector<uint32_t> values(100);
+	std::vector<uint32_t> indices(100);
+	for (uint32_t i = 0; i < 100; i++) {
+		values[i] = i * 7;
+		indices[i] = 99 - i;
+	}
+	values[60] = 21;										// second occurrence of the key of position 3
+
+	DatasetGenerator generator(1);
+	generator.setTree(3, 6);
+	auto snapshot = generator.generate();
+	auto topDown = std::make_unique<BreadthFirstSearch>();
+	auto hybrid = std::make_unique<BreadthFirstSearch>();
+	hybrid->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+	auto parallel = std::make_unique<BreadthFirstSearch>();
+	parallel->setNumThreads(4);
+
+	Simd::level_t supported = Simd::supportedLevel();
+	int mismatches = 0;
+
+	for (auto level : { Simd::LevelScalar, Simd::LevelSse2, Simd::LevelAvx2 }) {
+		Simd::setLevel(level);
+		testAssert(Simd::getLevel() <= supported);
+
+		for (uint32_t length = 0; length <= 100; length += 3) {
+			for (uint32_t key : { 0u, 21u, 14u * 7u, 693u, 5u }) {
+				size_t expected = std::find(values.begin(), values.begin() + length, key) - values.begin();
+				if (Simd::find(values.data(), length, key) != expected) mismatches++;
+
+				size_t expectedIndexed = length;
+				for (size_t i = 0; i < length; i++) {
+					if (values[indices[i]] == key) { expectedIndexed = i; break; }
+				}
+				if (Simd::findIndexed(values.data(), values.size(), indices.data(), length, key) != expectedIndexed) mismatches++;
+			}
+		}
+
+		for (NodeIndex node = 0; node < snapshot->size(); node += 17) {
+			const std::string& id = snapshot->getId(node);
+			if (topDown->find(snapshot, id) != hybrid->find(snapshot, id)) mismatches++;
+			if (topDown->find(snapshot, id) != parallel->find(snapshot, id)) mismatches++;
+		}
+	}
+	testAssert(0 == mismatches);
+
+	Simd::setLevel(supported);
+
+}
+
+IMPLEMENT_TEST(implicitGraphTest) {
+
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+
+	DatasetGenerator generator(1);
+	generator.setTree(3, 4);
+	auto snapshot = generator.generate();
+	auto graph = Graph::createInstance(*snapshot);
+	auto implicit = ImplicitTreeGraph::createInstance(3, 4);
+	testAssert(nullptr != implicit);
+	testAssert(implicit->size() == snapshot->size());
+
+	int mismatches = 0;
+	for (NodeIndex node = 0; node < snapshot->size(); node++) {
+		std::vector<NodeIndex> neighbors;
+		implicit->forEachNeighbor(node, [&neighbors](NodeIndex other) { neighbors.push_back(other); });
+		if (neighbors.size() != implicit->degree(node)) mismatches++;
+		if (!std::equal(neighbors.begin(), neighbors.end(), snapshot->neighborsBegin(node), snapshot->neighborsEnd(node))) mismatches++;
+
+		const std::string& id = snapshot->getId(node);
+		if (implicit->getId(node) != id || implicit->findById(id) != node) mismatches++;
+
+		// the same engine on all three representations
+		NodeIndex expected = bfs->find(snapshot, id);
+		if (bfs->find(implicit, id) != expected) mismatches++;
+		if (BreadthFirstSearch::findTopDown(*graph, id, BfsWorkspace::forThread()) != expected) mismatches++;
+	}
+	testAssert(0 == mismatches);
+
+	for (const char* id : { "DOES_NOT_EXIST", "Node", "Node01", "Node-1", "node1", "Node99999999999", "Node1020" }) {
+		testAssert(!implicit->contains(id));
+		testAssert(INVALID_NODE_INDEX == bfs->find(implicit, id));
+	}
+	testAssert(implicit->contains("Node0"));
+	testAssert(implicit->contains("Node1019"));
+
+	// sizes without any stored adjacency
+	auto large = ImplicitTreeGraph::createInstance(5, 6);
+	testAssert(large->size() == 279931);
+	testAssert(279930 == bfs->find(large, "Node279929"));
+	testAssert(nullptr == ImplicitTreeGraph::createInstance(12, 12));
+
+}
+
+IMPLEMENT_TEST(benchmarkTest) {
+
+	TempFile temp("benchmark_test.csv");
+	const std::string& path = temp.path();
+
+	const char* args[] = { "--topology", "tree", "--levels", "3", "--fanout", "4", "--queries", "200",
+						   "--miss-ratio", "0.25", "--warmup", "0", "--repeat", "2", "--format", "csv", "--output", path.c_str() };
+	BenchmarkConfig config;
+	testAssert(Benchmark::parseArguments(18, (char**) args, config));
+	testAssert(config.levels == 3 && config.queries == 200 && config.format == "csv");
+
+	const char* bad[] = { "--levels" };
+	BenchmarkConfig ignored;
+	testAssertFalse(Benchmark::parseArguments(1, (char**) bad, ignored));
+
+	// malformed and out of range values are rejected like unknown arguments
+	for (const char* value : { "abc", "3x", "-1", "", " 3", "0", "99999999999999999999999" }) {
+		const char* levels[] = { "--levels", value };
+		testAssertFalse(Benchmark::parseArguments(2, (char**) levels, ignored));
+	}
+	const char* threads[] = { "--threads", "100000" };
+	testAssertFalse(Benchmark::parseArguments(2, (char**) threads, ignored));
+	const char* ratio[] = { "--miss-ratio", "1.5" };
+	testAssertFalse(Benchmark::parseArguments(2, (char**) ratio, ignored));
+	const char* batch[] = { "--batch-size", "0" };
+	testAssertFalse(Benchmark::parseArguments(2, (char**) batch, ignored));
+
+	// the same query mix gives the same work on every engine and representation
+	uint64_t edges = 0;
+	size_t found = 0;
+	int mismatches = 0;
+	for (const char* engine : { "topdown", "hybrid", "batch", "graph" }) {
+		config.engine = engine;
+		for (const char* topology : { "tree", "implicit" }) {
+			if (0 == strcmp(topology, "implicit") && 0 != strcmp(engine, "topdown")) continue;
+			config.topology = topology;
+			Benchmark benchmark(config);
+			testAssert(benchmark.run());
+			const Benchmark::Result& result = benchmark.getResult();
+			if (result.numQueries != 400 || result.numNodes != 1021) mismatches++;
+			if (0 == edges) {
+				edges = result.edgesTraversed;
+				found = result.numFound;
+			}
+			if (result.edgesTraversed != edges || result.numFound != found) mismatches++;
+			if (result.p50 > result.p99 || result.queriesPerSecond <= 0.0) mismatches++;
+		}
+	}
+	testAssert(0 == mismatches);
+	testAssert(found > 200 && found < 400);					// about a quarter of the queries miss
+
+	FILE* file = fopen(path.c_str(), "r");
+	testAssert(nullptr != file);
+	int lines = 0;
+	for (int ch = fgetc(file); EOF != ch; ch = fgetc(file)) {
+		lines += ('\n' == ch) ? 1 : 0;
+	}
+	fclose(file);
+	testAssert(2 == lines);									// header and one row
+	std::remove(path.c_str());
+
+	// sorted lists visit nodes in another order, the found nodes are the same
+	config.engine = "compressed";
+	config.topology = "tree";
+	Benchmark compressed(config);
+	testAssert(compressed.run() && compressed.getResult().numFound == found);
+	std::remove(path.c_str());
+
+	config.engine = "hybrid";
+	config.topology = "implicit";
+	testAssertFalse(Benchmark(config).run());
+	config.topology = "tree";
+	config.format = "jsn";
+	testAssertFalse(Benchmark(config).run());
+
+}
+
+#if BFS_INSTRUMENTATION
+IMPLEMENT_TEST(searchStatsTest) {
+
+	class CountingObserver : public SearchObserver {
+		public:
+			void onLevel(const LevelStats& level) override {
+				levels++;
+				discovered += level.discovered;
+			}
+			void onSearchEnd(const SearchStats& stats) override {
+				searches++;
+				result = stats.result;
+			}
+		public:
+			size_t levels{0};
+			size_t discovered{0};
+			size_t searches{0};
+			NodeIndex result{INVALID_NODE_INDEX};
+	};
+
+	auto graph = createTestTree(3, 3);
+	const size_t numTree = graph->size();
+	graph->addNode("UNREACHABLE");	// known id, so the search traverses everything
+	auto snapshot = graph->freeze();
+
+	auto plain = std::make_unique<BreadthFirstSearch>();
+	plain->find(snapshot, "UNREACHABLE");
+	testAssert(plain->getStats().levels.empty());			// not collected by default
+
+	auto topDown = std::make_unique<BreadthFirstSearch>();
+	topDown->setCollectStats(true);
+	testAssert(nullptr == topDown->find(graph, "UNREACHABLE"));
+	SearchStats stats = topDown->getStats();
+	testAssert(stats.nodesVisited == numTree);
+	testAssert(stats.edgesScanned == snapshot->numTargets());
+	testAssert(stats.depth + 1 == stats.levels.size());
+	testAssert(stats.levels[0].frontierSize == 1 && 0 == stats.directionSwitches);
+	testAssert(INVALID_NODE_INDEX == stats.result);
+
+	// the same traversal shape on every engine
+	auto hybrid = std::make_unique<BreadthFirstSearch>();
+	hybrid->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+	hybrid->setDirectionThresholds(1e-9, 1e9);				// bottom-up once no unexplored edges are left
+	hybrid->setCollectStats(true);
+	auto parallel = std::make_unique<BreadthFirstSearch>();
+	parallel->setNumThreads(4);
+	parallel->setCollectStats(true);
+	auto batch = std::make_unique<BreadthFirstSearch>();
+	batch->setCollectStats(true);
+
+	hybrid->find(snapshot, "UNREACHABLE");
+	parallel->find(snapshot, "UNREACHABLE");
+	batch->findMany(snapshot, { "UNREACHABLE", "Node7" });
+
+	int mismatches = 0;
+	for (const SearchStats* other : { &hybrid->getStats(), &parallel->getStats(), &batch->getStats() }) {
+		if (other->nodesVisited != stats.nodesVisited) mismatches++;
+		if (0 == other->directionSwitches && other->edgesScanned != stats.edgesScanned) mismatches++;
+		if (other->levels.size() != stats.levels.size()) mismatches++;
+		for (size_t i = 0; i < other->levels.size() && i < stats.levels.size(); i++) {
+			if (other->levels[i].frontierSize != stats.levels[i].frontierSize) mismatches++;
+			if (other->levels[i].discovered != stats.levels[i].discovered) mismatches++;
+		}
+	}
+	testAssert(0 == mismatches);
+
+	// bottom-up levels are flagged and switches counted
+	auto eager = std::make_unique<BreadthFirstSearch>();
+	eager->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+	eager->setDirectionThresholds(1e9, 1.0);				// bottom-up for single levels
+	eager->setCollectStats(true);
+	eager->find(snapshot, "UNREACHABLE");
+	testAssert(eager->getStats().levels[0].bottomUp);
+	testAssert(eager->getStats().directionSwitches > 0);
+	testAssert(eager->getStats().nodesVisited == numTree);
+	testAssert(eager->getStats().edgesScanned > 0);
+
+	// hits report the result, a root hit scans no edges
+	NodeIndex node3 = snapshot->findById("Node3");
+	testAssert(node3 == topDown->find(snapshot, "Node3"));
+	testAssert(node3 == topDown->getStats().result);
+	testAssert(0 == topDown->find(snapshot, "root"));
+	testAssert(0 == topDown->getStats().edgesScanned && 1 == topDown->getStats().nodesVisited);
+
+	// the observer works without collection
+	CountingObserver observer;
+	plain->setObserver(&observer);
+	plain->find(snapshot, "UNREACHABLE");
+	testAssert(1 == observer.searches && INVALID_NODE_INDEX == observer.result);
+	testAssert(observer.levels == stats.levels.size());
+	testAssert(observer.discovered + 1 == stats.nodesVisited);
+	plain->find(snapshot, "Node9");
+	testAssert(2 == observer.searches && snapshot->findById("Node9") == observer.result);
+	plain->setObserver(nullptr);
+
+}
+#endif
+
+IMPLEMENT_TEST(concurrentGraphTest) {
+
+	struct Counted {
+		explicit Counted(std::atomic<int>& alive) : alive(alive) { alive++; }
+		~Counted() { alive--; }
+		std::atomic<int>& alive;
+	};
+
+	// an active reader keeps retired objects alive
+	std::atomic<int> alive{0};
+	{
+		EpochDomain domain;
+		{
+			EpochDomain::Guard guard(domain);
+			domain.retire(new Counted(alive));
+			testAssert(0 == domain.reclaim() && 1 == alive);
+		}
+		testAssert(1 == domain.reclaim() && 0 == alive);
+
+		domain.retire(new Counted(alive));
+		EpochDomain::Guard late(domain);					// entered after the retire
+		testAssert(1 == domain.reclaim() && 0 == alive);
+	}
+
+	auto initial = Graph::createInstance();
+	initial->addNode("root");
+	auto graph = ConcurrentGraph::createInstance(initial);
+	auto first = graph->snapshot();
+
+	static const int NUM_BATCHES = 200;
+	static const int BATCH_SIZE = 10;
+
+	// readers search while the writer publishes chains of nodes below the root
+	std::atomic<bool> done{false};
+	std::atomic<int> errors{0};
+	std::atomic<int> searches{0};
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; t++) {
+		readers.emplace_back([&] {
+			auto bfs = std::make_unique<BreadthFirstSearch>();
+			while (!done.load()) {
+				uint64_t version = 0;
+				CsrGraphRef snapshot = graph->snapshot(version);
+				if (snapshot->size() != 1 + version * BATCH_SIZE) errors++;		// batches are published as a whole
+				if (0 == version) continue;
+
+				NodeIndex last = (NodeIndex) (snapshot->size() - 1);
+				if (last != bfs->find(snapshot, "Node" + std::to_string(last))) errors++;
+				searches++;
+			}
+		});
+	}
+
+	for (int batch = 0; batch < NUM_BATCHES; batch++) {
+		graph->update([](Graph& writer) {
+			for (int i = 0; i < BATCH_SIZE; i++) {
+				NodeRef node = writer.addNode("Node" + std::to_string(writer.size()));
+				writer.addEdge(writer.getNode(node->getIndex() - 1), node);
+			}
+		});
+	}
+	while (searches.load() < 100) {
+		std::this_thread::yield();
+	}
+	done = true;
+	for (auto& reader : readers) {
+		reader.join();
+	}
+
+	testAssert(0 == errors);
+	testAssert(graph->getVersion() == NUM_BATCHES);
+	testAssert(graph->snapshot()->size() == 1 + NUM_BATCHES * BATCH_SIZE);
+	testAssert(first->size() == 1);						// held snapshots never change
+
+	graph->update([](Graph&) { });						// nothing is retired without readers
+	testAssert(0 == graph->numRetired());
+
+}
+
+IMPLEMENT_TEST(queryCacheTest) {
+
+	auto graph = Graph::createInstance();
+	graph->addNode("root");
+	for (int i = 1; i < 100; i++) {
+		auto child = graph->addNode("Node" + std::to_string(i));
+		graph->addEdge(graph->getNode((i - 1) / 3), child);
+	}
+	auto unreachable = graph->addNode("UNREACHABLE");
+
+	auto cache = QueryCache::createInstance(1000, 4);
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	bfs->setQueryCache(cache);
+
+	// hits and misses are cached
+	testAssert(graph->getNode(42) == bfs->find(graph, "Node42"));
+	testAssert(graph->getNode(42) == bfs->find(graph, "Node42"));
+	testAssert(nullptr == bfs->find(graph, "UNREACHABLE"));
+	testAssert(nullptr == bfs->find(graph, "UNREACHABLE"));
+	testAssert(2 == cache->getHits() && 2 == cache->getMisses());
+
+	// every modification invalidates the cached results
+	uint64_t version = graph->getVersion();
+	graph->addEdge(graph->getNode(99), unreachable);
+	testAssert(graph->getVersion() != version);
+	testAssert(unreachable == bfs->find(graph, "UNREACHABLE"));
+	testAssert(unreachable == bfs->find(graph, "UNREACHABLE"));
+	testAssert(3 == cache->getHits());
+
+	// results of other graphs are kept apart
+	auto other = Graph::createInstance();
+	other->addNode("Node42");
+	testAssert(other->getUid() != graph->getUid());
+	testAssert(other->getFirst() == bfs->find(other, "Node42"));
+
+	// the least recently used entry is evicted
+	QueryCache small(3, 1);
+	for (NodeIndex i = 0; i < 3; i++) {
+		small.insert(QueryKey{1, 1, 0, "Node" + std::to_string(i)}, i);
+	}
+	NodeIndex result = INVALID_NODE_INDEX;
+	testAssert(small.lookup(QueryKey{1, 1, 0, "Node0"}, result) && 0 == result);
+	small.insert(QueryKey{1, 1, 0, "Node3"}, 3);
+	testAssert(3 == small.size());
+	testAssertFalse(small.lookup(QueryKey{1, 1, 0, "Node1"}, result));
+	testAssert(small.lookup(QueryKey{1, 1, 0, "Node0"}, result));
+	testAssertFalse(small.lookup(QueryKey{1, 2, 0, "Node0"}, result));
+
+	graph->clear();
+	testAssert(nullptr == bfs->find(graph, "Node42"));
+
+}
+
+IMPLEMENT_TEST(distanceIndexTest) {
+
+	auto graph = Graph::createInstance();
+	graph->enableIdIndex(true);
+	graph->addNode("root");
+	for (int i = 1; i < 2000; i++) {
+		auto child = graph->addNode("Node" + std::to_string(i));
+		graph->addEdge(graph->getNode((i - 1) / 2), child);
+	}
+	graph->enableDistanceIndex(true);
+	auto isolated = graph->addNode("ISOLATED");
+
+	testAssert(0 == graph->depthOf("root"));
+	testAssert(10 == graph->depthOf("Node1999"));
+	testAssert(-1 == graph->depthOf("ISOLATED"));
+	testAssert(-1 == graph->depthOf("DOES_NOT_EXIST"));
+	testAssert(graph->isWithin("Node6", 2));
+	testAssertFalse(graph->isWithin("Node7", 2));
+
+	// a shortcut only updates the region that got closer
+	graph->addEdge(graph->getNode(1), graph->getNode(1999));
+	testAssert(2 == graph->depthOf("Node1999"));
+	testAssert(3 == graph->depthOf("Node999"));
+	testAssert(graph->getDistanceIndex().getLastUpdateSize() < 20);
+
+	graph->addEdge(graph->getNode(1999), isolated);
+	testAssert(3 == graph->depthOf("ISOLATED"));
+	graph->addEdge(graph->getNode(1999), graph->getNode(2));
+	testAssert(0 == graph->getDistanceIndex().getLastUpdateSize());	// no distance changed
+
+	// random edges agree with a full recompute
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	for (uint64_t i = 0; i < 200; i++) {
+		graph->addEdge(graph->getNode(HashIndex::hashKey(2 * i) % graph->size()),
+					   graph->getNode(HashIndex::hashKey(2 * i + 1) % graph->size()));
+	}
+	auto snapshot = graph->freeze();
+	int mismatches = 0;
+	for (NodeIndex i = 0; i < graph->size(); i += 13) {
+		int expected = bfs->shortestPath(snapshot, 0, i).distance;
+		if (expected != graph->depthOf(snapshot->getId(i))) mismatches++;
+	}
+	testAssert(0 == mismatches);
+
+	graph->clear();
+	testAssert(-1 == graph->depthOf("root"));
+	graph->addNode("root");
+	testAssert(0 == graph->depthOf("root"));
+
+}
+
+IMPLEMENT_TEST(queryServiceTest) {
+
+	auto graph = Graph::createInstance();
+	graph->addNode("root");
+	for (int i = 1; i < 5000; i++) {
+		auto child = graph->addNode("Node" + std::to_string(i % 4000));	// duplicates, the BFS order decides
+		graph->addEdge(graph->getNode((i - 1) / 4), child);
+	}
+	graph->addNode("UNREACHABLE");
+	auto snapshot = graph->freeze();
+
+	auto service = QueryService::createInstance(snapshot, 2);
+	service->setBatching(32, std::chrono::microseconds(1000));
+
+	// many clients at once get the answers of single searches
+	std::atomic<int> mismatches{0};
+	std::vector<std::thread> clients;
+	for (int t = 0; t < 4; t++) {
+		clients.emplace_back([&, t] {
+			auto bfs = std::make_unique<BreadthFirstSearch>();
+			std::vector<std::string> ids;
+			std::vector<std::future<NodeIndex>> results;
+			for (int i = 0; i < 500; i++) {
+				ids.push_back((0 == i % 50) ? "UNREACHABLE" : "Node" + std::to_string((i * 7 + t) % 4100));
+				results.push_back(service->submit(ids.back()));
+			}
+			for (size_t i = 0; i < ids.size(); i++) {
+				if (results[i].get() != bfs->find(snapshot, ids[i])) mismatches++;
+			}
+		});
+	}
+	for (auto& client : clients) {
+		client.join();
+	}
+	testAssert(0 == mismatches);
+	testAssert(2000 == service->getNumQueries());
+	testAssert(service->getNumBatches() < service->getNumQueries());
+
+	// a full batch does not wait for the delay
+	service->setBatching(10, std::chrono::microseconds(10000000));
+	uint64_t batches = service->getNumBatches();
+	std::vector<std::future<NodeIndex>> results;
+	for (int i = 0; i < 10; i++) {
+		results.push_back(service->submit("Node" + std::to_string(i + 1)));
+	}
+	int wrong = 0;
+	for (int i = 0; i < 10; i++) {
+		if ((NodeIndex) (i + 1) != results[i].get()) wrong++;
+	}
+	testAssert(0 == wrong);
+	testAssert(batches + 1 == service->getNumBatches());
+
+	// a single query waits at most for the delay, callbacks run on the pool
+	service->setBatching(1000, std::chrono::microseconds(2000));
+	std::promise<NodeIndex> done;
+	service->submit("Node3999", [&done](NodeIndex result) {
+		done.set_value(result);
+	});
+	auto future = done.get_future();
+	testAssert(std::future_status::ready == future.wait_for(std::chrono::seconds(5)));
+	testAssert(3999 == future.get());
+
+	// pending queries are answered when the service goes away
+	auto pending = service->submit("Node5");
+	service.reset();
+	testAssert(5 == pending.get());
+
+	// a failing batch hands its exception to the futures and still lets the service go away
+	auto failing = std::make_shared<QueryService>([]() -> CsrGraphRef { throw std::runtime_error("no snapshot"); },
+												  ThreadPool::createInstance(2));
+	auto failed = failing->submit("Node5");
+	failing.reset();
+	bool thrown = false;
+	try {
+		failed.get();
+	} catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	testAssert(thrown);
+
+}
+
+IMPLEMENT_TEST(compressedGraphTest) {
+
+	DatasetGenerator generator;
+	generator.setTree(4, 5);
+	auto snapshot = NodeReordering(NodeReordering::OrderBfs).apply(*generator.generate());
+	auto compressed = CompressedGraph::createInstance(*snapshot);
+	testAssert(nullptr != compressed);
+	testAssert(compressed->size() == snapshot->size() && compressed->numTargets() == snapshot->numTargets());
+
+	// lists decode to the sorted snapshot lists
+	auto sameLists = [](const CsrGraph& csr, const CompressedGraph& graph) {
+		int mismatches = 0;
+		std::vector<NodeIndex> expected;
+		std::vector<NodeIndex> decoded;
+		for (NodeIndex node = 0; node < csr.size(); node++) {
+			expected.assign(csr.neighborsBegin(node), csr.neighborsEnd(node));
+			std::sort(expected.begin(), expected.end());
+			decoded.clear();
+			graph.forEachNeighbor(node, [&decoded](NodeIndex other) {
+				decoded.push_back(other);
+			});
+			if (decoded != expected || graph.degree(node) != csr.degree(node)) mismatches++;
+			if (graph.getId(node) != csr.getId(node)) mismatches++;
+		}
+		return mismatches;
+	};
+	testAssert(0 == sameLists(*snapshot, *compressed));
+	testAssert(compressed->adjacencyBytes() * 2 < snapshot->adjacencyBytes());
+
+	// multi-edges, self loops and backward first neighbors
+	DatasetGenerator rmat;
+	rmat.setRmat(12, 8);
+	auto random = rmat.generate();
+	testAssert(0 == sameLists(*random, *CompressedGraph::createInstance(*random)));
+
+	// identifiers are unique, so the search order does not change results
+	auto bfs = std::make_unique<BreadthFirstSearch>();
+	int mismatches = 0;
+	for (NodeIndex node = 0; node < snapshot->size(); node += 17) {
+		if (node != bfs->find(compressed, snapshot->getId(node))) mismatches++;
+	}
+	testAssert(0 == mismatches);
+	testAssert(INVALID_NODE_INDEX == bfs->find(compressed, "DOES_NOT_EXIST"));
+
+	auto empty = CompressedGraph::createInstance(*Graph::createInstance()->freeze());
+	testAssert(empty->empty() && INVALID_NODE_INDEX == bfs->find(empty, "root"));
+
+}
+
+IMPLEMENT_TEST(partitionedGraphTest) {
+
+	// results match a local search up to the choice among equal identifiers on the same level
+	auto mismatches = [](CsrGraphRef snapshot, PartitionedGraph& partitioned) {
+		std::vector<uint32_t> depth = referenceDepths(*snapshot);
+		auto bfs = std::make_unique<BreadthFirstSearch>();
+		int count = 0;
+		for (NodeIndex node = 0; node < snapshot->size(); node += 61) {
+			std::string id = snapshot->getId(node);
+			NodeIndex expected = bfs->find(snapshot, id);
+			NodeIndex found = partitioned.find(id);
+			if (INVALID_NODE_INDEX == expected || INVALID_NODE_INDEX == found) {
+				count += (expected != found) ? 1 : 0;
+			} else if (snapshot->getId(found) != id || depth[found] != depth[expected]) {
+				count++;
+			}
+		}
+		return count + ((INVALID_NODE_INDEX != partitioned.find("DOES_NOT_EXIST")) ? 1 : 0);
+	};
+
+	DatasetGenerator generator;
+	generator.setTree(4, 5);
+	auto tree = generator.generate();
+
+	auto range = PartitionedGraph::createInstance(*tree, 3, PartitionedGraph::PartitionRange);
+	testAssert(nullptr != range && 3 == range->numShards() && range->size() == tree->size());
+	testAssert(0 == mismatches(tree, *range));
+
+	auto hash = PartitionedGraph::createInstance(*tree, 4, PartitionedGraph::PartitionHash);
+	testAssert(nullptr != hash && 0 == mismatches(tree, *hash));
+
+	// unreachable nodes, multi-edges and self loops
+	DatasetGenerator rmat;
+	rmat.setRmat(12, 8);
+	auto random = rmat.generate();
+	testAssert(0 == mismatches(random, *PartitionedGraph::createInstance(*random, 4, PartitionedGraph::PartitionHash)));
+	testAssert(0 == mismatches(random, *PartitionedGraph::createInstance(*random, 1)));
+
+	// more shards than nodes leaves some of them empty
+	auto graph = Graph::createInstance();
+	auto root = graph->addNode("root");
+	graph->addEdge(root, graph->addNode("child"));
+	graph->addNode("unconnected");
+	auto small = PartitionedGraph::createInstance(graph, 5);
+	testAssert(nullptr != small && small->isHealthy());
+	testAssert(0 == small->find("root") && 1 == small->find("child"));
+	testAssert(INVALID_NODE_INDEX == small->find("unconnected") && small->isHealthy());
+
+	auto empty = PartitionedGraph::createInstance(Graph::createInstance(), 2);
+	testAssert(nullptr != empty && INVALID_NODE_INDEX == empty->find("root"));
+	testAssert(nullptr == PartitionedGraph::createInstance(*tree, 0));
+
+}
+
+IMPLEMENT_TEST(asyncLogTest) {
+
+	TempFile temp("asynclog_test.txt");
+	const std::string& path = temp.path();
+	FILE* file = fopen(path.c_str(), "w");
+	testAssert(nullptr != file);
+
+	// a small ring and several producers, full rings drop records instead of blocking
+	const size_t numThreads = 4;
+	const size_t numRecords = 2000;
+	uint64_t written = 0;
+	uint64_t dropped = 0;
+	{
+		AsyncLogWriter writer(file, 64);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < numThreads; t++) {
+			threads.emplace_back([&writer, t] {
+				for (size_t i = 0; i < numRecords; i++) {
+					writer.write(Log::LevelTest, ("record " + std::to_string(t) + " " + std::to_string(i)).c_str());
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		writer.flush();
+		written = writer.getNumWritten();
+		dropped = writer.getNumDropped();
+	}
+	fclose(file);
+	testAssert(written + dropped == numThreads * numRecords && written >= 64);
+
+	// every written record is one complete line, records of a thread keep their order
+	file = fopen(path.c_str(), "r");
+	testAssert(nullptr != file);
+	char line[MAX_LOG_RECORD + 16];
+	uint64_t lines = 0;
+	std::vector<long> last(numThreads, -1);
+	bool ordered = true;
+	while (nullptr != fgets(line, sizeof(line), file)) {
+		unsigned thread = 0;
+		long index = 0;
+		if (2 != sscanf(line, "[TEST] record %u %ld", &thread, &index)) continue;
+		lines++;
+		ordered = ordered && thread < numThreads && index > last[thread];
+		if (thread < numThreads) last[thread] = index;
+	}
+	fclose(file);
+	std::remove(path.c_str());
+	testAssert(lines == written && ordered);
+
+	// records longer than a slot are truncated
+	file = fopen(path.c_str(), "w");
+	{
+		AsyncLogWriter writer(file);
+		testAssert(writer.write(Log::LevelTest, std::string(4 * MAX_LOG_RECORD, 'x').c_str()));
+	}
+	fclose(file);
+	file = fopen(path.c_str(), "r");
+	std::vector<char> text(8 * MAX_LOG_RECORD, 0);
+	size_t length = fread(text.data(), 1, text.size(), file);
+	fclose(file);
+	std::remove(path.c_str());
+	testAssert(length == std::strlen("[TEST] ") + MAX_LOG_RECORD - 1 + 1);
+
+	// the log switches back and forth between both backends
+	Log::setAsync(true);
+	testAssert(Log::isAsync());
+	Log::testf("written by the %s writer", "asynchronous");
+	Log::setAsync(false);
+	testAssert(!Log::isAsync() && 0 == Log::getNumDropped());
+	testAssert(Log::isEnabled(Log::LevelTest) == (Log::LevelTest >= BFS_LOG_LEVEL));
+
+	// the macros only build their arguments for enabled levels
+	int evaluated = 0;
+	auto message = [&evaluated] { evaluated++; return std::string("not logged"); };
+	Log::loglevel_t level = Log::getLogLevel();
+	Log::setLogLevel(Log::LevelTest);
+	LOG_DEBUG(message());
+	LOG_WARNF("%s", message().c_str());
+	LOG_ERROR("also " + message());
+	Log::setLogLevel(level);
+	testAssert(0 == evaluated);
+
+}
+
+IMPLEMENT_TEST(duplicateIdTest) {
+
+	// every node at depth d is named "Dd", so each query has many matches on one level
+	DatasetGenerator generator;
+	generator.setRmat(13, 16);
+	auto random = generator.generate();
+
+	std::vector<NodeIndex> queue;
+	std::vector<uint32_t> depth = referenceDepths(*random, 0, &queue);
+
+	StringPool pool;
+	std::vector<uint64_t> offsets(1, 0);
+	std::vector<NodeIndex> targets;
+	std::vector<StringHandle> ids;
+	for (NodeIndex node = 0; node < random->size(); node++) {
+		targets.insert(targets.end(), random->neighborsBegin(node), random->neighborsEnd(node));
+		offsets.push_back(targets.size());
+		ids.push_back(pool.intern("D" + std::to_string((int) depth[node])));
+	}
+	std::vector<char> idData(pool.data(), pool.data() + pool.bytes());
+	auto snapshot = CsrGraph::createInstance(std::move(offsets), std::move(targets), std::move(idData), std::move(ids));
+
+	auto topDown = std::make_unique<BreadthFirstSearch>();
+	auto hybrid = std::make_unique<BreadthFirstSearch>();
+	hybrid->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+	hybrid->setCollectStats(true);
+	auto parallel = std::make_unique<BreadthFirstSearch>();
+	parallel->setNumThreads(4);
+	parallel->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+
+	std::vector<std::string> names;
+	for (uint32_t d = 0; d <= depth[queue.back()]; d++) {
+		names.push_back("D" + std::to_string(d));
+	}
+	std::vector<NodeIndex> batch = topDown->findMany(snapshot, names);
+
+	// the first node of every level in serial order
+	int mismatches = 0;
+#if BFS_INSTRUMENTATION
+	bool bottomUp = false;
+#endif
+	for (size_t d = 0; d < names.size(); d++) {
+		NodeIndex expected = *std::find_if(queue.begin(), queue.end(), [&depth, d](NodeIndex node) { return depth[node] == d; });
+		if (expected != topDown->find(snapshot, names[d])) mismatches++;
+		if (expected != hybrid->find(snapshot, names[d])) mismatches++;
+#if BFS_INSTRUMENTATION
+		bottomUp = bottomUp || hybrid->getStats().directionSwitches > 0;
+#endif
+		if (expected != parallel->find(snapshot, names[d])) mismatches++;
+		if (expected != batch[d]) mismatches++;
+	}
+	testAssert(0 == mismatches);
+#if BFS_INSTRUMENTATION
+	testAssert(bottomUp);									// the hybrid engine has run bottom-up steps
+#endif
+
+}
@@ -0,0 +1,596 @@
+/*
+ *
+ * Benchmark
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+#include <auxiliary/logger.h>
+
+#include <app/bfs.h>
+#include <app/generator.h>
+#include <app/graph_traits.h>
+#include <app/implicit.h>
+#include <app/partition.h>
+#include <app/reorder.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const size_t MAX_BENCHMARK_THREADS = 1024;	///< Upper bound of --threads, i.e. search threads or shard processes
+static const size_t MAX_BENCHMARK_SCALE = 31;		///< Upper bound of --scale, node indexes have 32 bits
+static const size_t MAX_BENCHMARK_EDGE_FACTOR = 1024;	///< Upper bound of --edge-factor
+
+/**
+ *
+ * Benchmark configuration
+ *
+ */
+struct BenchmarkConfig {
+
+	std::string  topology{"tree"};      ///< tree, rmat, uniform or implicit
+	size_t       levels{5};             ///< Tree depth
+	size_t       fanout{5};             ///< Tree fan-out
+	size_t       scale{16};             ///< R-MAT scale
+	size_t       edgeFactor{16};        ///< R-MAT edges per node
+	uint64_t     nodes{100000};         ///< Uniform node count
+	uint64_t     edges{1000000};        ///< Uniform edge count
+	std::string  reorder{"none"};       ///< none, bfs, rcm or degree
+	std::string  engine{"topdown"};     ///< topdown, hybrid, batch, graph, compressed or partitioned
+	size_t       threads{1};            ///< Search threads or shard processes, zero selects the hardware threads
+	size_t       queries{1000};         ///< Queries per repetition
+	double       missRatio{0.0};        ///< Fraction of queries for identifiers that do not exist
+	size_t       batchSize{64};         ///< Queries per call of the batch engine
+	size_t       warmup{1};             ///< Unmeasured repetitions
+	size_t       repetitions{5};        ///< Measured repetitions
+	uint64_t     seed{1};               ///< Seed of random topologies and the query mix
+	std::string  format{"text"};        ///< text, json or csv
+	std::string  output;                ///< Output file, empty for stdout
+
+};
+
+/**
+ *
+ * Benchmark
+ *
+ * This class generates a graph, runs a query mix against one search
+ * engine and reports latency percentiles and throughput. All inputs come
+ * from a BenchmarkConfig, usually parsed from the command line, so runs
+ * of different builds can be repeated and compared:
+ *
+ *     BreadthFirstSearch --bench --topology rmat --scale 18 --engine hybrid
+ *                        --threads 4 --format json --output result.json
+ *
+ * Every repetition sends the same queries. Latencies are taken per call,
+ * i.e. per query, or per batch for the batch engine. Traversed edges are
+ * counted the way a top-down search scans them: the adjacency of every
+ * node dequeued before the match, all edges reachable from the root for
+ * a miss, and none for identifiers that the id index rejects up front.
+ *
+ */
+class Benchmark {
+
+	public:
+		/**
+		 *
+		 * Summary of the measured repetitions
+		 *
+		 */
+		struct Result {
+			size_t                numNodes{0};
+			size_t                numTargets{0};
+			size_t                numCalls{0};
+			size_t                numQueries{0};
+			size_t                numFound{0};
+			uint64_t              edgesTraversed{0};
+			double                seconds{0.0};
+			double                p50{0.0};
+			double                p99{0.0};
+			double                mean{0.0};
+			double                queriesPerSecond{0.0};
+			double                edgesPerSecond{0.0};
+			std::vector<double>   repetitionSeconds;
+		};
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param config Benchmark configuration
+		 *
+		 */
+		explicit Benchmark(const BenchmarkConfig& config = BenchmarkConfig())
+			: m_config(config) {
+		}
+
+	public:
+		/**
+		 *
+		 * Parse command line arguments
+		 *
+		 * Arguments are "--name value" pairs named like the members of
+		 * BenchmarkConfig, with dashes instead of camel case.
+		 *
+		 * @param argc Number of arguments
+		 * @param argv Arguments, without the program name and mode flag
+		 * @param config Configuration receiving the values
+		 * @return Returns true on success, false if an argument is
+		 * unknown, lacks a value, or its value is malformed or out of
+		 * range.
+		 *
+		 */
+		static bool parseArguments(int argc, char* argv[], BenchmarkConfig& config) {
+			for (int i = 0; i < argc; i += 2) {
+				if (i + 1 >= argc) {
+					LOG_ERRORF("missing value for %s", argv[i]);
+					return false;
+				}
+
+				std::string name = argv[i];
+				const char* value = argv[i + 1];
+				bool valid = true;
+
+				if (name == "--topology")         config.topology = value;
+				else if (name == "--levels")      valid = parseCount(name, value, 1, UINT32_MAX, config.levels);
+				else if (name == "--fanout")      valid = parseCount(name, value, 1, UINT32_MAX, config.fanout);
+				else if (name == "--scale")       valid = parseCount(name, value, 1, MAX_BENCHMARK_SCALE, config.scale);
+				else if (name == "--edge-factor") valid = parseCount(name, value, 1, MAX_BENCHMARK_EDGE_FACTOR, config.edgeFactor);
+				else if (name == "--nodes")       valid = parseCount(name, value, 1, UINT32_MAX, config.nodes);
+				else if (name == "--edges")       valid = parseCount(name, value, 0, UINT64_MAX, config.edges);
+				else if (name == "--reorder")     config.reorder = value;
+				else if (name == "--engine")      config.engine = value;
+				else if (name == "--threads")     valid = parseCount(name, value, 0, MAX_BENCHMARK_THREADS, config.threads);
+				else if (name == "--queries")     valid = parseCount(name, value, 1, UINT32_MAX, config.queries);
+				else if (name == "--miss-ratio")  valid = parseRatio(name, value, config.missRatio);
+				else if (name == "--batch-size")  valid = parseCount(name, value, 1, UINT32_MAX, config.batchSize);
+				else if (name == "--warmup")      valid = parseCount(name, value, 0, UINT32_MAX, config.warmup);
+				else if (name == "--repeat")      valid = parseCount(name, value, 1, UINT32_MAX, config.repetitions);
+				else if (name == "--seed")        valid = parseCount(name, value, 0, UINT64_MAX, config.seed);
+				else if (name == "--format")      config.format = value;
+				else if (name == "--output")      config.output = value;
+				else {
+					LOG_ERRORF("unknown benchmark argument %s", name.c_str());
+					return false;
+				}
+
+				if (!valid) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/**
+		 *
+		 * Run the benchmark and write the report
+		 *
+		 * @return Returns true on success, false if the configuration is
+		 * invalid or the report cannot be written.
+		 *
+		 */
+		bool run() {
+			if (!prepare()) {
+				return false;
+			}
+
+			Result result;
+			result.numNodes = m_numNodes;
+			result.numTargets = m_numTargets;
+
+			std::vector<double> latencies;
+
+			for (size_t rep = 0; rep < m_config.warmup + m_config.repetitions; rep++) {
+				bool measured = rep >= m_config.warmup;
+				latencies.clear();
+
+				auto tStart = std::chrono::steady_clock::now();
+				runQueries(latencies);
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tStart).count();
+
+				if (!measured) continue;
+
+				result.seconds += seconds;
+				result.repetitionSeconds.push_back(seconds);
+				result.numCalls += latencies.size();
+				result.numQueries += m_queries.size();
+				m_allLatencies.insert(m_allLatencies.end(), latencies.begin(), latencies.end());
+
+				for (size_t i = 0; i < m_queries.size(); i++) {
+					result.edgesTraversed += edgesFor(i);
+					result.numFound += (INVALID_NODE_INDEX != m_results[i]) ? 1 : 0;
+				}
+			}
+
+			std::sort(m_allLatencies.begin(), m_allLatencies.end());
+			result.p50 = percentile(0.50);
+			result.p99 = percentile(0.99);
+			for (double latency : m_allLatencies) {
+				result.mean += latency / (double) m_allLatencies.size();
+			}
+			if (result.seconds > 0.0) {
+				result.queriesPerSecond = (double) result.numQueries / result.seconds;
+				result.edgesPerSecond = (double) result.edgesTraversed / result.seconds;
+			}
+
+			m_result = result;
+			return writeReport(result);
+		}
+
+		const Result& getResult() const {
+			return m_result;
+		}
+
+	private:
+		/**
+		 *
+		 * Parse an unsigned decimal argument value
+		 *
+		 * @return Returns true if the whole value is a number within
+		 * [min, max], false otherwise.
+		 *
+		 */
+		template <typename T>
+		static bool parseCount(const std::string& name, const char* value, uint64_t min, uint64_t max, T& result) {
+			max = std::min<uint64_t>(max, std::numeric_limits<T>::max());
+
+			char* end = nullptr;
+			errno = 0;
+			unsigned long long parsed = std::isdigit((unsigned char) value[0]) ? std::strtoull(value, &end, 10) : 0;
+			if (nullptr == end || '\0' != *end || ERANGE == errno || parsed < min || parsed > max) {
+				LOG_ERRORF("invalid value %s for %s, expected a number from %llu to %llu",
+							value, name.c_str(), (unsigned long long) min, (unsigned long long) max);
+				return false;
+			}
+
+			result = (T) parsed;
+			return true;
+		}
+
+		/**
+		 *
+		 * Parse a ratio argument value
+		 *
+		 * @return Returns true if the whole value is a number within
+		 * [0, 1], false otherwise.
+		 *
+		 */
+		static bool parseRatio(const std::string& name, const char* value, double& result) {
+			char* end = nullptr;
+			double parsed = std::strtod(value, &end);
+			if (end == value || '\0' != *end || !(parsed >= 0.0 && parsed <= 1.0)) {
+				LOG_ERRORF("invalid value %s for %s, expected a number from 0 to 1", value, name.c_str());
+				return false;
+			}
+
+			result = parsed;
+			return true;
+		}
+
+		/**
+		 *
+		 * Build the graph, the engine and the query mix
+		 *
+		 */
+		bool prepare() {
+			const BenchmarkConfig& c = m_config;
+
+			if (c.engine != "topdown" && c.engine != "hybrid" && c.engine != "batch" && c.engine != "graph" && c.engine != "compressed" && c.engine != "partitioned") {
+				LOG_ERRORF("unknown engine %s", c.engine.c_str());
+				return false;
+			}
+
+			if (c.format != "text" && c.format != "json" && c.format != "csv") {
+				LOG_ERRORF("unknown report format %s", c.format.c_str());
+				return false;
+			}
+
+			if (c.topology == "implicit") {
+				if (c.engine != "topdown") {
+					LOG_ERROR("implicit graphs only support the topdown engine");
+					return false;
+				}
+				m_implicit = ImplicitTreeGraph::createInstance(c.levels, c.fanout);
+				if (nullptr == m_implicit) {
+					return false;
+				}
+				m_numNodes = m_implicit->size();
+				indexTraversal(*m_implicit);
+			} else {
+				DatasetGenerator generator;
+				generator.setSeed(c.seed);
+
+				if (c.topology == "tree") {
+					generator.setTree(c.levels, c.fanout);
+				} else if (c.topology == "rmat") {
+					generator.setRmat(c.scale, c.edgeFactor);
+				} else if (c.topology == "uniform") {
+					generator.setUniform(c.nodes, c.edges);
+				} else {
+					LOG_ERRORF("unknown topology %s", c.topology.c_str());
+					return false;
+				}
+
+				m_snapshot = generator.generate();
+				if (nullptr == m_snapshot) {
+					return false;
+				}
+
+				if (c.reorder != "none") {
+					NodeReordering reordering;
+					if (c.reorder == "bfs") {
+						reordering.setOrder(NodeReordering::OrderBfs);
+					} else if (c.reorder == "rcm") {
+						reordering.setOrder(NodeReordering::OrderRcm);
+					} else if (c.reorder == "degree") {
+						reordering.setOrder(NodeReordering::OrderDegree);
+					} else {
+						LOG_ERRORF("unknown reordering %s", c.reorder.c_str());
+						return false;
+					}
+					m_snapshot = reordering.apply(*m_snapshot);
+				}
+
+				if (c.engine == "graph") {
+					m_graph = Graph::createInstance(*m_snapshot);
+					m_graph->enableIdIndex(true);
+				}
+
+				if (c.engine == "partitioned") {
+					size_t numShards = (0 != c.threads) ? c.threads : std::max(1u, std::thread::hardware_concurrency());
+					m_partitioned = PartitionedGraph::createInstance(*m_snapshot, numShards);
+					if (nullptr == m_partitioned) {
+						return false;
+					}
+				}
+
+				m_numNodes = m_snapshot->size();
+				m_numTargets = m_snapshot->numTargets();
+
+				// sorted lists change the traversal order
+				if (c.engine == "compressed") {
+					m_compressed = CompressedGraph::createInstance(*m_snapshot);
+					if (nullptr == m_compressed) {
+						return false;
+					}
+					indexTraversal(*m_compressed);
+				} else {
+					indexTraversal(*m_snapshot);
+				}
+			}
+
+			m_bfs = std::make_unique<BreadthFirstSearch>();
+			m_bfs->setNumThreads(c.threads);
+			if (c.engine == "hybrid") {
+				m_bfs->setStrategy(BreadthFirstSearch::StrategyDirectionOptimizing);
+			}
+
+			// the query mix only depends on the seed
+			m_queries.clear();
+			m_exists.clear();
+			uint64_t state = HashIndex::hashKey(c.seed);
+			for (size_t i = 0; i < c.queries; i++) {
+				state = HashIndex::hashKey(state + i);
+				bool miss = (double) (state >> 11) * (1.0 / 9007199254740992.0) < c.missRatio;
+				uint64_t pick = HashIndex::hashKey(state ^ 0x5bd1e995) % m_numNodes;
+
+				if (miss) {
+					m_queries.push_back("MISSING" + std::to_string(pick));
+					m_exists.push_back(0);
+				} else {
+					m_queries.push_back(nullptr != m_implicit ? m_implicit->getId((NodeIndex) pick) : m_snapshot->getId((NodeIndex) pick));
+					m_exists.push_back(1);
+				}
+			}
+			m_results.assign(m_queries.size(), INVALID_NODE_INDEX);
+			m_allLatencies.clear();
+
+			return true;
+		}
+
+		/**
+		 *
+		 * Run all queries once, recording results and per-call latencies
+		 *
+		 */
+		void runQueries(std::vector<double>& latencies) {
+			typedef std::chrono::steady_clock Clock;
+
+			if (m_config.engine == "batch") {
+				std::vector<std::string> batch;
+				for (size_t first = 0; first < m_queries.size(); first += m_config.batchSize) {
+					size_t last = std::min(m_queries.size(), first + m_config.batchSize);
+					batch.assign(m_queries.begin() + first, m_queries.begin() + last);
+
+					auto tStart = Clock::now();
+					auto indices = m_bfs->findMany(m_snapshot, batch);
+					latencies.push_back(std::chrono::duration<double>(Clock::now() - tStart).count());
+
+					std::copy(indices.begin(), indices.end(), m_results.begin() + first);
+				}
+				return;
+			}
+
+			for (size_t i = 0; i < m_queries.size(); i++) {
+				auto tStart = Clock::now();
+
+				NodeIndex index;
+				if (nullptr != m_implicit) {
+					index = m_bfs->find(m_implicit, m_queries[i]);
+				} else if (nullptr != m_compressed) {
+					index = m_bfs->find(m_compressed, m_queries[i]);
+				} else if (nullptr != m_partitioned) {
+					index = m_partitioned->find(m_queries[i]);
+				} else if (nullptr != m_graph) {
+					NodeRef node = m_bfs->find(m_graph, m_queries[i]);
+					index = (nullptr != node) ? node->getIndex() : INVALID_NODE_INDEX;
+				} else {
+					index = m_bfs->find(m_snapshot, m_queries[i]);
+				}
+
+				latencies.push_back(std::chrono::duration<double>(Clock::now() - tStart).count());
+				m_results[i] = index;
+			}
+		}
+
+		/**
+		 *
+		 * Record the BFS position of every node reachable from the root and
+		 * the number of adjacency entries scanned before it is dequeued
+		 *
+		 */
+		template <typename G>
+		void indexTraversal(const G& graph) {
+			typedef GraphTraits<G> Traits;
+
+			size_t numNodes = Traits::size(graph);
+			m_position.assign(numNodes, INVALID_NODE_INDEX);
+			m_edgesBefore.assign(1, 0);
+
+			if (0 == numNodes) {
+				return;
+			}
+
+			std::vector<NodeIndex> queue(1, 0);
+			m_position[0] = 0;
+			uint64_t scanned = 0;
+
+			for (size_t head = 0; head < queue.size(); head++) {
+				Traits::forEachNeighbor(graph, queue[head], [&](NodeIndex other) {
+					scanned++;
+					if (INVALID_NODE_INDEX != m_position[other]) return;
+					m_position[other] = (NodeIndex) queue.size();
+					queue.push_back(other);
+				});
+				m_edgesBefore.push_back(scanned);
+			}
+
+			if (0 == m_numTargets) {
+				m_numTargets = (size_t) scanned;
+			}
+		}
+
+		/**
+		 *
+		 * Get number of edges a top-down search scans for a query
+		 *
+		 */
+		uint64_t edgesFor(size_t query) const {
+			NodeIndex result = m_results[query];
+			if (INVALID_NODE_INDEX != result && INVALID_NODE_INDEX != m_position[result]) {
+				return m_edgesBefore[m_position[result]];
+			}
+			return m_exists[query] ? m_edgesBefore.back() : 0;
+		}
+
+		double percentile(double fraction) const {
+			if (m_allLatencies.empty()) {
+				return 0.0;
+			}
+			size_t rank = (size_t) (fraction * (double) m_allLatencies.size() + 0.999999);
+			return m_allLatencies[std::min(m_allLatencies.size(), std::max<size_t>(rank, 1)) - 1];
+		}
+
+		/**
+		 *
+		 * Write the report in the configured format
+		 *
+		 */
+		bool writeReport(const Result& r) const {
+			const BenchmarkConfig& c = m_config;
+
+			FILE* out = stdout;
+			if (!c.output.empty()) {
+				out = fopen(c.output.c_str(), "w");
+				if (nullptr == out) {
+					LOG_ERRORF("cannot write benchmark report %s", c.output.c_str());
+					return false;
+				}
+			}
+
+			if (c.format == "json") {
+				fprintf(out, "{\n");
+				fprintf(out, "  \"config\": {\"topology\": \"%s\", \"levels\": %zu, \"fanout\": %zu, \"scale\": %zu, \"edgeFactor\": %zu, "
+							 "\"nodes\": %llu, \"edges\": %llu, \"reorder\": \"%s\", \"engine\": \"%s\", \"threads\": %zu, "
+							 "\"queries\": %zu, \"missRatio\": %g, \"batchSize\": %zu, \"warmup\": %zu, \"repetitions\": %zu, \"seed\": %llu},\n",
+					escape(c.topology).c_str(), c.levels, c.fanout, c.scale, c.edgeFactor,
+					(unsigned long long) c.nodes, (unsigned long long) c.edges, escape(c.reorder).c_str(), escape(c.engine).c_str(), c.threads,
+					c.queries, c.missRatio, c.batchSize, c.warmup, c.repetitions, (unsigned long long) c.seed);
+				fprintf(out, "  \"graph\": {\"nodes\": %zu, \"adjacency\": %zu},\n", r.numNodes, r.numTargets);
+				fprintf(out, "  \"result\": {\"calls\": %zu, \"queries\": %zu, \"found\": %zu, \"edgesTraversed\": %llu, \"seconds\": %.6f, "
+							 "\"p50\": %.9f, \"p99\": %.9f, \"mean\": %.9f, \"queriesPerSecond\": %.1f, \"edgesPerSecond\": %.1f},\n",
+					r.numCalls, r.numQueries, r.numFound, (unsigned long long) r.edgesTraversed, r.seconds,
+					r.p50, r.p99, r.mean, r.queriesPerSecond, r.edgesPerSecond);
+				fprintf(out, "  \"repetitions\": [");
+				for (size_t i = 0; i < r.repetitionSeconds.size(); i++) {
+					fprintf(out, "%s%.6f", (0 == i) ? "" : ", ", r.repetitionSeconds[i]);
+				}
+				fprintf(out, "]\n}\n");
+			} else if (c.format == "csv") {
+				fprintf(out, "topology,levels,fanout,scale,edge_factor,nodes,edges,reorder,engine,threads,queries,miss_ratio,batch_size,"
+							 "graph_nodes,graph_adjacency,calls,found,edges_traversed,seconds,p50,p99,mean,queries_per_second,edges_per_second\n");
+				fprintf(out, "%s,%zu,%zu,%zu,%zu,%llu,%llu,%s,%s,%zu,%zu,%g,%zu,%zu,%zu,%zu,%zu,%llu,%.6f,%.9f,%.9f,%.9f,%.1f,%.1f\n",
+					c.topology.c_str(), c.levels, c.fanout, c.scale, c.edgeFactor, (unsigned long long) c.nodes, (unsigned long long) c.edges,
+					c.reorder.c_str(), c.engine.c_str(), c.threads, c.queries, c.missRatio, c.batchSize,
+					r.numNodes, r.numTargets, r.numCalls, r.numFound, (unsigned long long) r.edgesTraversed, r.seconds,
+					r.p50, r.p99, r.mean, r.queriesPerSecond, r.edgesPerSecond);
+			} else {
+				fprintf(out, "graph:       %s, %zu nodes, %zu adjacency entries, reorder %s\n", c.topology.c_str(), r.numNodes, r.numTargets, c.reorder.c_str());
+				fprintf(out, "engine:      %s, %zu threads\n", c.engine.c_str(), c.threads);
+				fprintf(out, "queries:     %zu per repetition, %zu found, %zu warm-up + %zu measured repetitions\n",
+					c.queries, r.numFound / std::max<size_t>(1, c.repetitions), c.warmup, c.repetitions);
+				fprintf(out, "latency:     p50 %.3f us, p99 %.3f us, mean %.3f us per call\n", r.p50 * 1e6, r.p99 * 1e6, r.mean * 1e6);
+				fprintf(out, "throughput:  %.0f queries/s, %.0f edges/s\n", r.queriesPerSecond, r.edgesPerSecond);
+			}
+
+			bool ok = !ferror(out);
+			if (stdout != out) {
+				ok = (0 == fclose(out)) && ok;
+			}
+			return ok;
+		}
+
+		static std::string escape(const std::string& str) {
+			std::string escaped;
+			for (char ch : str) {
+				if ('"' == ch || '\\' == ch) escaped.push_back('\\');
+				escaped.push_back(ch);
+			}
+			return escaped;
+		}
+
+	private:
+		BenchmarkConfig                      m_config;
+		Result                               m_result;
+
+		CsrGraphRef                          m_snapshot;
+		GraphRef                             m_graph;
+		ImplicitTreeGraphRef                 m_implicit;
+		CompressedGraphRef                   m_compressed;
+		PartitionedGraphRef                  m_partitioned;
+		size_t                               m_numNodes{0};
+		size_t                               m_numTargets{0};
+		std::unique_ptr<BreadthFirstSearch>  m_bfs;
+
+		std::vector<std::string>             m_queries;
+		std::vector<uint8_t>                 m_exists;
+		std::vector<NodeIndex>               m_results;
+		std::vector<double>                  m_allLatencies;
+		std::vector<NodeIndex>               m_position;     ///< BFS position per node, INVALID_NODE_INDEX if unreachable
+		std::vector<uint64_t>                m_edgesBefore;  ///< Adjacency entries scanned before a BFS position is dequeued
+
+};
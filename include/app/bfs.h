@@ -1,41 +1,544 @@
-/*
- *
- * Breadth First Search (BFS)
- *
- */
-
-#pragma once
-
-#include <app/graph.h>
-
-#include <string>
-
-/**
- * 
- *  Breadth-first-search (BFS) implementation
- * 
- */
-class BreadthFirstSearch {
-    
-    public:
-        /**
-         * 
-         * Find a named node.
-         * 
-         * This method performs a BFS and returns the first node with
-         * a given identifier.
-         * 
-         * @param root Root node to start the search.
-         * @param id Identifier to be found.
-         * @return Returns the found node, or null in case no node
-         * has been found.
-         * 
-         */
-        NodeRef find(GraphRef graph, const std::string& id) {
-
-			// @TODO: Implement
-			return nullptr;
-
-        }
-
-};
+/*
+ *
+ * Breadth First Search (BFS)
+ *
+ */
+
+#pragma once
+
+#include <app/bfs_batch.h>
+#include <app/bfs_bidirectional.h>
+#include <app/bfs_hybrid.h>
+#include <app/bfs_parallel.h>
+#include <app/bfs_stats.h>
+#include <app/bfs_topdown.h>
+#include <app/bfs_workspace.h>
+#include <app/compressed.h>
+#include <app/graph.h>
+#include <app/graph_traits.h>
+#include <app/implicit.h>
+#include <app/query_cache.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * 
+ *  Breadth-first-search (BFS) implementation
+ * 
+ *  If several nodes share the searched identifier, every strategy,
+ *  thread count and findMany() return the one a serial top-down BFS
+ *  from node 0 reaches first.
+ * 
+ */
+class BreadthFirstSearch {
+
+    public:
+        BreadthFirstSearch() {
+            m_hybrid.setTrace(&m_trace);
+            m_parallel.setTrace(&m_trace);
+            m_batch.setTrace(&m_trace);
+        }
+
+        // the engines point to m_trace
+        BreadthFirstSearch(const BreadthFirstSearch&) = delete;
+        BreadthFirstSearch& operator=(const BreadthFirstSearch&) = delete;
+
+    public:
+        /**
+         *
+         * Search strategy
+         *
+         */
+        typedef enum {
+            StrategyTopDown = 0,            ///< Classic queue based top-down BFS
+            StrategyDirectionOptimizing = 1 ///< Switch between top-down and bottom-up steps
+        } strategy_t;
+
+    public:
+        /**
+         *
+         * Set search strategy
+         *
+         * The pointer based search on a Graph only implements the
+         * top-down strategy; other strategies search the CSR snapshot
+         * returned by Graph::freeze().
+         *
+         * @param strategy Strategy used by subsequent searches
+         *
+         */
+        void setStrategy(strategy_t strategy) {
+            m_strategy = strategy;
+        }
+
+        strategy_t getStrategy() const {
+            return m_strategy;
+        }
+
+        /**
+         *
+         * Set direction switching thresholds
+         *
+         * @param alpha Switch to bottom-up once the frontier edges exceed
+         * the unexplored edges divided by alpha
+         * @param beta Switch back to top-down once the frontier holds fewer
+         * than the number of nodes divided by beta
+         *
+         */
+        void setDirectionThresholds(double alpha, double beta) {
+            m_hybrid.setThresholds(alpha, beta);
+        }
+
+        /**
+         *
+         * Set number of search threads
+         *
+         * With more than one thread every level of the search is split
+         * into chunks that run on a work-stealing thread pool (see
+         * ParallelSearch), on the CSR snapshot returned by Graph::freeze().
+         *
+         * @param numThreads Number of threads, zero selects the number
+         * of hardware threads
+         *
+         */
+        void setNumThreads(size_t numThreads) {
+            m_parallel.setNumThreads(numThreads);
+        }
+
+        size_t getNumThreads() const {
+            return m_parallel.getNumThreads();
+        }
+
+        /**
+         *
+         * Set thread pool
+         *
+         * Shares a pool with other traversals, so its workers stay
+         * parked between queries instead of being spawned per search.
+         *
+         * @param pool Thread pool, or null to search on the calling thread
+         *
+         */
+        void setThreadPool(ThreadPoolRef pool) {
+            m_parallel.setThreadPool(pool);
+        }
+
+        ThreadPoolRef getThreadPool() const {
+            return m_parallel.getThreadPool();
+        }
+
+        /**
+         *
+         * Enable collection of search statistics
+         *
+         * Every find() and findMany() call then records nodes visited,
+         * edges scanned, and size, direction and time of every level,
+         * see getStats(). Searches answered without a traversal (e.g.
+         * misses rejected by the id index) report no levels.
+         *
+         * @param enabled True to collect statistics
+         *
+         */
+        void setCollectStats(bool enabled) {
+            m_trace.setCollectStats(enabled);
+        }
+
+        /**
+         *
+         * Get statistics of the last search
+         *
+         * @return Returns the statistics of the last find() or findMany()
+         * call while collection or an observer was enabled.
+         *
+         */
+        const SearchStats& getStats() const {
+            return m_trace.getStats();
+        }
+
+        /**
+         *
+         * Set search observer
+         *
+         * The observer is called after every level and at the end of
+         * every search. Building with BFS_INSTRUMENTATION=0 removes all
+         * calls.
+         *
+         * @param observer Observer, or null to remove it; it must outlive
+         * the searches
+         *
+         */
+        void setObserver(SearchObserver* observer) {
+            m_trace.setObserver(observer);
+        }
+
+        /**
+         *
+         * Set query result cache
+         *
+         * find() on a Graph then answers repeated queries, hits and
+         * misses, from the cache until the graph version changes (see
+         * Graph::getVersion()). A cache may be shared by searches on
+         * several threads.
+         *
+         * @param cache Cache, or null to search every query
+         *
+         */
+        void setQueryCache(QueryCacheRef cache) {
+            m_cache = cache;
+        }
+
+        QueryCacheRef getQueryCache() const {
+            return m_cache;
+        }
+
+    public:
+        /**
+         * 
+         * Find a named node.
+         * 
+         * This method performs a BFS and returns the first node with
+         * a given identifier.
+         * 
+         * @param root Root node to start the search.
+         * @param id Identifier to be found.
+         * @return Returns the found node, or null in case no node
+         * has been found.
+         * 
+         */
+        NodeRef find(GraphRef graph, const std::string& id) {
+			return find(graph, id, m_workspace);
+        }
+
+        /**
+         * 
+         * Find a named node using a caller provided workspace.
+         * 
+         * Serial top-down searches keep their visited set and queue in
+         * the workspace, so repeated queries do not allocate. Other
+         * strategies use their own state and ignore it.
+         * 
+         * @param graph Graph to be searched.
+         * @param id Identifier to be found.
+         * @param workspace Workspace, e.g. BfsWorkspace::forThread().
+         * @return Returns the found node, or null in case no node
+         * has been found.
+         * 
+         */
+        NodeRef find(GraphRef graph, const std::string& id, BfsWorkspace& workspace) {
+
+			m_trace.begin();
+			NodeIndex index = INVALID_NODE_INDEX;
+
+			if (nullptr == graph || graph->empty()) {
+				// nothing to search
+			} else if (graph->hasIdIndex() && nullptr == graph->findById(id)) {
+				// the id index answers misses without a traversal
+			} else if (nullptr != m_cache) {
+				// every search starts at node 0
+				QueryKey key{graph->getUid(), graph->getVersion(), 0, id};
+				if (!m_cache->lookup(key, index)) {
+					index = search(*graph, id, workspace);
+					m_cache->insert(key, index);
+				}
+			} else {
+				index = search(*graph, id, workspace);
+			}
+
+			m_trace.end(index);
+			return (INVALID_NODE_INDEX != index) ? graph->getNode(index) : nullptr;
+
+        }
+
+        /**
+         * 
+         * Find a named node in a CSR snapshot.
+         * 
+         * This method performs a BFS starting at node 0 of the snapshot
+         * and returns the index of the first node with a given identifier.
+         * 
+         * @param graph CSR snapshot to be searched.
+         * @param id Identifier to be found.
+         * @return Returns the index of the found node, or
+         * INVALID_NODE_INDEX in case no node has been found.
+         * 
+         */
+        NodeIndex find(CsrGraphRef graph, const std::string& id) {
+			return find(graph, id, m_workspace);
+        }
+
+        /**
+         * 
+         * Find a named node in a CSR snapshot using a caller provided
+         * workspace.
+         * 
+         * @param graph CSR snapshot to be searched.
+         * @param id Identifier to be found.
+         * @param workspace Workspace for serial top-down searches.
+         * @return Returns the index of the found node, or
+         * INVALID_NODE_INDEX in case no node has been found.
+         * 
+         */
+        NodeIndex find(CsrGraphRef graph, const std::string& id, BfsWorkspace& workspace) {
+
+			m_trace.begin();
+			NodeIndex index = (nullptr != graph) ? search(*graph, id, workspace) : INVALID_NODE_INDEX;
+			m_trace.end(index);
+			return index;
+
+        }
+
+        /**
+         * 
+         * Find a named node in an implicit graph.
+         * 
+         * Implicit graphs are always searched top-down on the calling
+         * thread; the other strategies need a CSR snapshot.
+         * 
+         * @param graph Implicit graph to be searched.
+         * @param id Identifier to be found.
+         * @return Returns the index of the found node, or
+         * INVALID_NODE_INDEX in case no node has been found.
+         * 
+         */
+        NodeIndex find(ImplicitTreeGraphRef graph, const std::string& id) {
+			return find(graph, id, m_workspace);
+        }
+
+        NodeIndex find(ImplicitTreeGraphRef graph, const std::string& id, BfsWorkspace& workspace) {
+
+			m_trace.begin();
+			NodeIndex index = (nullptr != graph) ? findTopDown(*graph, id, workspace, &m_trace) : INVALID_NODE_INDEX;
+			m_trace.end(index);
+			return index;
+
+        }
+
+        /**
+         * 
+         * Find a named node in a compressed graph.
+         * 
+         * Compressed graphs are searched top-down on the calling thread,
+         * decoding every adjacency list as it is expanded.
+         * 
+         * @param graph Compressed graph to be searched.
+         * @param id Identifier to be found.
+         * @return Returns the index of the found node, or
+         * INVALID_NODE_INDEX in case no node has been found.
+         * 
+         */
+        NodeIndex find(CompressedGraphRef graph, const std::string& id) {
+			return find(graph, id, m_workspace);
+        }
+
+        NodeIndex find(CompressedGraphRef graph, const std::string& id, BfsWorkspace& workspace) {
+
+			m_trace.begin();
+			NodeIndex index = (nullptr != graph) ? findTopDown(*graph, id, workspace, &m_trace) : INVALID_NODE_INDEX;
+			m_trace.end(index);
+			return index;
+
+        }
+
+        /**
+         * 
+         * Find a named node in any graph type with a top-down search.
+         * 
+         * The traversal is instantiated per graph type through
+         * GraphTraits, so neighbor and match checks are inlined.
+         * 
+         * @param graph Graph to be searched, e.g. a Graph, CsrGraph,
+         * CompressedGraph or ImplicitTreeGraph.
+         * @param id Identifier to be found.
+         * @param workspace Workspace holding the visited set and queue.
+         * @param trace Trace receiving the level statistics, or null.
+         * @return Returns the index of the first node with the given
+         * identifier in BFS order from node 0, or INVALID_NODE_INDEX in
+         * case no node has been found.
+         * 
+         */
+        template <typename G>
+        static NodeIndex findTopDown(const G& graph, const std::string& id, BfsWorkspace& workspace,
+                                     SearchTrace* trace = nullptr) {
+
+			// prepare the key once, nodes are matched without string compares
+			typename GraphTraits<G>::Key key;
+			if (0 == GraphTraits<G>::size(graph) || !GraphTraits<G>::lookupKey(graph, id, key)) {
+				return INVALID_NODE_INDEX;
+			}
+
+			return TopDownSearch::find(graph, key, workspace, trace);
+
+        }
+
+        /**
+         * 
+         * Find a batch of named nodes.
+         * 
+         * This method answers all queries with a single traversal of
+         * the CSR snapshot returned by Graph::freeze(). Every query
+         * gets the node that find() would return.
+         * 
+         * @param graph Graph to be searched.
+         * @param ids Identifiers to be found.
+         * @return Returns one node per identifier, null for identifiers
+         * that have not been found.
+         * 
+         */
+        std::vector<NodeRef> findMany(GraphRef graph, const std::vector<std::string>& ids) {
+
+			std::vector<NodeRef> results(ids.size());
+
+			if (nullptr == graph || graph->empty()) {
+				m_trace.begin();
+				m_trace.end(INVALID_NODE_INDEX);
+				return results;
+			}
+
+			auto indices = findMany(graph->freeze(), ids);
+			for (size_t i = 0; i < indices.size(); i++) {
+				if (INVALID_NODE_INDEX != indices[i]) {
+					results[i] = graph->getNode(indices[i]);
+				}
+			}
+
+			return results;
+
+        }
+
+        /**
+         * 
+         * Find a batch of named nodes in a CSR snapshot.
+         * 
+         * @param graph CSR snapshot to be searched.
+         * @param ids Identifiers to be found.
+         * @return Returns one node index per identifier, INVALID_NODE_INDEX
+         * for identifiers that have not been found.
+         * 
+         */
+        std::vector<NodeIndex> findMany(CsrGraphRef graph, const std::vector<std::string>& ids) {
+
+			m_trace.begin();
+
+			std::vector<NodeIndex> results = (nullptr != graph)
+				? m_batch.find(*graph, ids)
+				: std::vector<NodeIndex>(ids.size(), INVALID_NODE_INDEX);
+
+			// the stats of a batch report no single result
+			m_trace.end(INVALID_NODE_INDEX);
+			return results;
+
+        }
+
+        /**
+         * 
+         * Find a shortest path between two nodes.
+         * 
+         * This method runs a bidirectional BFS on the CSR snapshot
+         * returned by Graph::freeze().
+         * 
+         * @param graph Graph to be searched.
+         * @param fromNode Start node, must belong to the graph.
+         * @param toNode End node, must belong to the graph.
+         * @return Returns the hop distance and the nodes of the path, or
+         * a distance of -1 if the nodes are not connected.
+         * 
+         */
+        PathResult<NodeRef> shortestPath(GraphRef graph, NodeRef fromNode, NodeRef toNode) {
+
+			PathResult<NodeRef> result;
+
+			if (nullptr == graph || nullptr == fromNode || nullptr == toNode) {
+				return result;
+			}
+
+			if (graph->getNode(fromNode->getIndex()) != fromNode || graph->getNode(toNode->getIndex()) != toNode) {
+				LOG_ERROR("cannot search path because node belongs to another graph");
+				return result;
+			}
+
+			auto indices = m_bidirectional.find(*graph->freeze(), fromNode->getIndex(), toNode->getIndex());
+
+			result.distance = indices.distance;
+			result.path.reserve(indices.path.size());
+			for (NodeIndex index : indices.path) {
+				result.path.push_back(graph->getNode(index));
+			}
+
+			return result;
+
+        }
+
+        /**
+         * 
+         * Find a shortest path between two nodes of a CSR snapshot.
+         * 
+         * @param graph CSR snapshot to be searched.
+         * @param fromNode Index of the start node.
+         * @param toNode Index of the end node.
+         * @return Returns the hop distance and the node indices of the
+         * path, or a distance of -1 if the nodes are not connected.
+         * 
+         */
+        PathResult<NodeIndex> shortestPath(CsrGraphRef graph, NodeIndex fromNode, NodeIndex toNode) {
+
+			if (nullptr == graph) {
+				return PathResult<NodeIndex>();
+			}
+
+			return m_bidirectional.find(*graph, fromNode, toNode);
+
+        }
+
+    private:
+        /**
+         *
+         * Dispatch a search of a graph to the engine of the strategy
+         *
+         */
+        NodeIndex search(const Graph& graph, const std::string& id, BfsWorkspace& workspace) {
+
+			if (StrategyTopDown != m_strategy || m_parallel.getNumThreads() > 1) {
+				return search(*graph.freeze(), id, workspace);
+			}
+
+			return findTopDown(graph, id, workspace, &m_trace);
+
+        }
+
+        /**
+         *
+         * Dispatch a search of a CSR snapshot to the engine of the strategy
+         *
+         */
+        NodeIndex search(const CsrGraph& graph, const std::string& id, BfsWorkspace& workspace) {
+
+			if (graph.empty() || !graph.contains(id)) {
+				return INVALID_NODE_INDEX;
+			}
+
+			if (m_parallel.getNumThreads() > 1) {
+				m_parallel.setDirectionOptimizing(StrategyDirectionOptimizing == m_strategy,
+												  m_hybrid.getAlpha(), m_hybrid.getBeta());
+				return m_parallel.find(graph, id);
+			}
+
+			if (StrategyDirectionOptimizing == m_strategy) {
+				return m_hybrid.find(graph, id);
+			}
+
+			return findTopDown(graph, id, workspace, &m_trace);
+
+        }
+
+    private:
+        strategy_t                  m_strategy{StrategyTopDown};
+        DirectionOptimizingSearch   m_hybrid;
+        ParallelSearch              m_parallel{1};
+        BatchSearch                 m_batch;
+        BidirectionalSearch         m_bidirectional;
+        BfsWorkspace                m_workspace;
+        SearchTrace                 m_trace;
+        QueryCacheRef               m_cache;
+
+};
@@ -0,0 +1,144 @@
+/*
+ *
+ * Batched Breadth First Search
+ *
+ */
+
+#pragma once
+
+#include <app/bfs_stats.h>
+#include <app/bfs_workspace.h>
+#include <app/csr.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ *
+ * Batched BFS engine
+ *
+ * This class answers a batch of find queries with a single traversal.
+ * Multi-source BFS tracks a bitset of queries per node, because every
+ * query may start somewhere else. All queries of a batch start at the
+ * graph root here, so those bitsets would be identical for every node;
+ * the engine therefore walks the graph once and resolves each visited
+ * node against a hash table of the pending query id handles. Every edge is
+ * scanned at most once per batch, and the traversal stops as soon as
+ * every query has been answered. Identifiers missing from the snapshot's
+ * id index are answered up front and never keep the traversal going.
+ *
+ * Each query gets the node that a single find() would return, i.e. the
+ * first match in top-down BFS order.
+ *
+ */
+class BatchSearch {
+
+	public:
+		/**
+		 *
+		 * Set trace receiving the level statistics
+		 *
+		 * @param trace Trace, or null to disable instrumentation
+		 *
+		 */
+		void setTrace(SearchTrace* trace) {
+			m_trace = trace;
+		}
+
+		/**
+		 *
+		 * Find a batch of named nodes.
+		 *
+		 * @param graph CSR snapshot to be searched.
+		 * @param ids Identifiers to be found.
+		 * @return Returns one node index per identifier, INVALID_NODE_INDEX
+		 * for identifiers that have not been found.
+		 *
+		 */
+		std::vector<NodeIndex> find(const CsrGraph& graph, const std::vector<std::string>& ids) {
+
+			std::vector<NodeIndex> results(ids.size(), INVALID_NODE_INDEX);
+
+			if (graph.empty() || ids.empty()) {
+				return results;
+			}
+
+			// queries with the same id are chained through m_nextQuery
+			m_pending.clear();
+			m_pending.reserve(ids.size());
+			m_nextQuery.assign(ids.size(), SIZE_MAX);
+
+			size_t numPending = 0;
+			for (size_t query = ids.size(); query-- > 0; ) {
+				if (!graph.contains(ids[query])) continue;
+
+				auto inserted = m_pending.emplace(graph.lookupId(ids[query]), query);
+				if (!inserted.second) {
+					m_nextQuery[query] = inserted.first->second;
+					inserted.first->second = query;
+				} else {
+					numPending++;
+				}
+			}
+
+			if (0 == numPending) {
+				return results;
+			}
+
+			m_workspace.reset(graph.size());
+			m_workspace.visit(0);
+			m_workspace.push(0);
+
+			bool tracing = nullptr != m_trace && m_trace->enabled();
+			if (tracing) {
+				m_trace->root();
+			}
+
+			QueueLevelCounter levels(m_trace);
+
+			while (!m_workspace.empty()) {
+				NodeIndex node = m_workspace.pop();
+				if (tracing) {
+					levels.pop();
+				}
+
+				auto it = m_pending.find(graph.getIdHandle(node));
+				if (it != m_pending.end()) {
+					for (size_t query = it->second; SIZE_MAX != query; query = m_nextQuery[query]) {
+						results[query] = node;
+					}
+					m_pending.erase(it);
+
+					if (0 == --numPending) {
+						break;
+					}
+				}
+
+				const NodeIndex* end = graph.neighborsEnd(node);
+				for (const NodeIndex* next = graph.neighborsBegin(node); next != end; ++next) {
+					bool discovered = m_workspace.visit(*next);
+					if (discovered) {
+						m_workspace.push(*next);
+					}
+					if (tracing) {
+						levels.scan(discovered);
+					}
+				}
+			}
+
+			if (tracing) {
+				levels.finish();
+			}
+
+			return results;
+		}
+
+	private:
+		std::unordered_map<StringHandle, size_t>   m_pending;
+		std::vector<size_t>                        m_nextQuery;
+		BfsWorkspace                               m_workspace;
+		SearchTrace*                               m_trace{nullptr};
+
+};
@@ -0,0 +1,160 @@
+/*
+ *
+ * Bidirectional Breadth First Search
+ *
+ */
+
+#pragma once
+
+#include <app/csr.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+static const uint32_t UNVISITED_DEPTH = UINT32_MAX;	///< Depth of nodes not reached by a search side
+
+/**
+ *
+ * Result of a path query
+ *
+ */
+template <typename T>
+struct PathResult {
+
+	int             distance{-1};   ///< Number of hops, -1 if the nodes are not connected
+	std::vector<T>  path;           ///< Nodes of the path, including both end points
+
+	bool found() const {
+		return distance >= 0;
+	}
+
+};
+
+/**
+ *
+ * Bidirectional BFS engine
+ *
+ * This class finds a shortest path between two nodes by growing one BFS
+ * from each end. Every step expands a whole level of the side with the
+ * smaller frontier. Once a level touches the other side, the shortest
+ * connection found on that level is returned. On graphs with a high
+ * branching factor both searches stay far smaller than a single BFS
+ * covering the full distance.
+ *
+ * Edges are undirected (see Graph::addEdge()), so both sides use the
+ * same adjacency.
+ *
+ */
+class BidirectionalSearch {
+
+	public:
+		/**
+		 *
+		 * Find a shortest path
+		 *
+		 * @param graph CSR snapshot to be searched.
+		 * @param from Index of the start node.
+		 * @param to Index of the end node.
+		 * @return Returns the distance and the path, or a result with a
+		 * distance of -1 if the nodes are not connected.
+		 *
+		 */
+		PathResult<NodeIndex> find(const CsrGraph& graph, NodeIndex from, NodeIndex to) {
+
+			PathResult<NodeIndex> result;
+
+			if (from >= graph.size() || to >= graph.size()) {
+				return result;
+			}
+
+			if (from == to) {
+				result.distance = 0;
+				result.path.push_back(from);
+				return result;
+			}
+
+			size_t numNodes = graph.size();
+
+			for (int side = 0; side < 2; side++) {
+				m_parent[side].assign(numNodes, INVALID_NODE_INDEX);
+				m_depth[side].assign(numNodes, UNVISITED_DEPTH);
+				m_frontier[side].clear();
+			}
+
+			m_parent[0][from] = from;
+			m_depth[0][from] = 0;
+			m_frontier[0].push_back(from);
+
+			m_parent[1][to] = to;
+			m_depth[1][to] = 0;
+			m_frontier[1].push_back(to);
+
+			while (!m_frontier[0].empty() && !m_frontier[1].empty()) {
+
+				int side = (m_frontier[0].size() <= m_frontier[1].size()) ? 0 : 1;
+				int other = 1 - side;
+
+				uint32_t bestLength = UNVISITED_DEPTH;
+				NodeIndex bestNear = INVALID_NODE_INDEX;
+				NodeIndex bestFar = INVALID_NODE_INDEX;
+
+				m_next.clear();
+
+				for (NodeIndex node : m_frontier[side]) {
+					uint32_t depth = m_depth[side][node];
+
+					const NodeIndex* end = graph.neighborsEnd(node);
+					for (const NodeIndex* it = graph.neighborsBegin(node); it != end; ++it) {
+						NodeIndex neighbor = *it;
+
+						if (UNVISITED_DEPTH != m_depth[other][neighbor]) {
+							uint32_t length = depth + 1 + m_depth[other][neighbor];
+							if (length < bestLength) {
+								bestLength = length;
+								bestNear = node;
+								bestFar = neighbor;
+							}
+						}
+
+						if (UNVISITED_DEPTH != m_depth[side][neighbor]) continue;
+
+						m_depth[side][neighbor] = depth + 1;
+						m_parent[side][neighbor] = node;
+						m_next.push_back(neighbor);
+					}
+				}
+
+				if (UNVISITED_DEPTH != bestLength) {
+					// orient the meeting edge from the start side to the end side
+					NodeIndex nearFrom = (0 == side) ? bestNear : bestFar;
+					NodeIndex nearTo = (0 == side) ? bestFar : bestNear;
+
+					for (NodeIndex node = nearFrom; ; node = m_parent[0][node]) {
+						result.path.push_back(node);
+						if (node == from) break;
+					}
+					std::reverse(result.path.begin(), result.path.end());
+
+					for (NodeIndex node = nearTo; ; node = m_parent[1][node]) {
+						result.path.push_back(node);
+						if (node == to) break;
+					}
+
+					result.distance = (int) bestLength;
+					return result;
+				}
+
+				m_frontier[side].swap(m_next);
+			}
+
+			return result;
+		}
+
+	private:
+		std::vector<NodeIndex>   m_parent[2];
+		std::vector<uint32_t>    m_depth[2];
+		std::vector<NodeIndex>   m_frontier[2];
+		std::vector<NodeIndex>   m_next;
+
+};
@@ -0,0 +1,281 @@
+/*
+ *
+ * Direction-optimizing Breadth First Search
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/simd.h>
+
+#include <app/bfs_stats.h>
+#include <app/bfs_topdown.h>
+#include <app/csr.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ *
+ * Direction-optimizing BFS engine
+ *
+ * This class implements a BFS that switches between top-down frontier
+ * expansion and bottom-up scans. A bottom-up step visits every unvisited
+ * node and stops scanning its neighbors as soon as one of them is part of
+ * the frontier, which saves most edge checks when the frontier is large.
+ *
+ * Switching follows the usual heuristic: go bottom-up once the edges
+ * leaving the frontier exceed (unexplored edges / alpha), and go back
+ * top-down once the frontier shrinks below (nodes / beta).
+ *
+ * Nodes are not matched one by one while a level is expanded. Once the
+ * next frontier is complete, the identifier handles of all its nodes are
+ * compared with the searched handle in one SIMD scan (see Simd).
+ *
+ * Bottom-up steps collect the next frontier in index order instead of
+ * the top-down order. If a level reached that way holds more than one
+ * match, the serial search order decides which one is returned, so the
+ * result equals the one of a top-down search.
+ *
+ */
+class DirectionOptimizingSearch {
+
+	public:
+		static constexpr double DEFAULT_ALPHA = 14.0;	///< Top-down to bottom-up threshold
+		static constexpr double DEFAULT_BETA  = 24.0;	///< Bottom-up to top-down threshold
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param alpha Top-down to bottom-up switching threshold
+		 * @param beta Bottom-up to top-down switching threshold
+		 *
+		 */
+		DirectionOptimizingSearch(double alpha = DEFAULT_ALPHA, double beta = DEFAULT_BETA) {
+			setThresholds(alpha, beta);
+		}
+
+	public:
+		/**
+		 *
+		 * Set switching thresholds
+		 *
+		 * @param alpha Top-down to bottom-up switching threshold, larger
+		 * values switch to bottom-up earlier
+		 * @param beta Bottom-up to top-down switching threshold, larger
+		 * values stay bottom-up longer
+		 *
+		 */
+		void setThresholds(double alpha, double beta) {
+			m_alpha = (alpha > 0.0) ? alpha : DEFAULT_ALPHA;
+			m_beta = (beta > 0.0) ? beta : DEFAULT_BETA;
+		}
+
+		double getAlpha() const {
+			return m_alpha;
+		}
+
+		double getBeta() const {
+			return m_beta;
+		}
+
+		/**
+		 *
+		 * Set trace receiving the level statistics
+		 *
+		 * @param trace Trace, or null to disable instrumentation
+		 *
+		 */
+		void setTrace(SearchTrace* trace) {
+			m_trace = trace;
+		}
+
+		/**
+		 *
+		 * Find a named node.
+		 *
+		 * This method performs a direction-optimizing BFS starting at
+		 * node 0 and returns a node with the given identifier at the
+		 * shallowest depth.
+		 *
+		 * @param graph CSR snapshot to be searched.
+		 * @param id Identifier to be found.
+		 * @return Returns the index of the found node, or
+		 * INVALID_NODE_INDEX in case no node has been found.
+		 *
+		 */
+		NodeIndex find(const CsrGraph& graph, const std::string& id) {
+
+			if (graph.empty()) {
+				return INVALID_NODE_INDEX;
+			}
+
+			// intern once, nodes are matched by handle
+			StringHandle key = graph.lookupId(id);
+			if (INVALID_STRING_HANDLE == key) {
+				return INVALID_NODE_INDEX;
+			}
+
+			size_t numNodes = graph.size();
+
+			m_visited.assign(numNodes, 0);
+			m_frontierBits.assign((numNodes + 63) / 64, 0);
+			m_frontier.clear();
+			m_next.clear();
+
+			m_visited[0] = 1;
+			m_frontier.push_back(0);
+
+			bool tracing = nullptr != m_trace && m_trace->enabled();
+			if (tracing) {
+				m_trace->root();
+			}
+
+			if (graph.getIdHandle(0) == key) {
+				return 0;
+			}
+
+			uint64_t edgesToCheck = graph.numTargets() - graph.degree(0);
+			uint64_t frontierEdges = graph.degree(0);
+			bool bottomUp = false;
+			bool serialOrder = true;
+
+			while (!m_frontier.empty()) {
+
+				if (!bottomUp) {
+					bottomUp = (double) frontierEdges > (double) edgesToCheck / m_alpha;
+				} else {
+					bottomUp = (double) m_frontier.size() >= (double) numNodes / m_beta;
+				}
+
+				m_next.clear();
+				m_scanned = 0;
+
+				NodeIndex found = bottomUp
+					? stepBottomUp(graph, key, tracing)
+					: stepTopDown(graph, key);
+
+				// once a bottom-up step has reordered the frontier, several matches need the serial order
+				serialOrder = serialOrder && !bottomUp;
+				if (INVALID_NODE_INDEX != found && !serialOrder && hasSecondMatch(graph, key)) {
+					found = TopDownSearch::find(graph, key, BfsWorkspace::forThread());
+				}
+
+				if (tracing) {
+					m_trace->level(m_frontier.size(), m_next.size(), bottomUp ? m_scanned : frontierEdges, bottomUp);
+				}
+
+				if (INVALID_NODE_INDEX != found) {
+					return found;
+				}
+
+				frontierEdges = 0;
+				for (NodeIndex node : m_next) {
+					frontierEdges += graph.degree(node);
+				}
+				edgesToCheck -= (frontierEdges < edgesToCheck) ? frontierEdges : edgesToCheck;
+
+				m_frontier.swap(m_next);
+			}
+
+			return INVALID_NODE_INDEX;
+		}
+
+	private:
+		/**
+		 *
+		 * Expand the frontier by visiting the neighbors of all frontier nodes.
+		 *
+		 */
+		NodeIndex stepTopDown(const CsrGraph& graph, StringHandle key) {
+
+			for (NodeIndex node : m_frontier) {
+				const NodeIndex* end = graph.neighborsEnd(node);
+				for (const NodeIndex* it = graph.neighborsBegin(node); it != end; ++it) {
+					if (m_visited[*it]) continue;
+					m_visited[*it] = 1;
+					m_next.push_back(*it);
+				}
+			}
+
+			return match(graph, key);
+		}
+
+		/**
+		 *
+		 * Expand the frontier by letting every unvisited node look for a
+		 * parent in the frontier. While tracing, the checked adjacency
+		 * entries are counted in m_scanned.
+		 *
+		 */
+		NodeIndex stepBottomUp(const CsrGraph& graph, StringHandle key, bool tracing) {
+
+			std::fill(m_frontierBits.begin(), m_frontierBits.end(), 0);
+			for (NodeIndex node : m_frontier) {
+				m_frontierBits[node >> 6] |= (uint64_t) 1 << (node & 63);
+			}
+
+			size_t numNodes = graph.size();
+
+			for (NodeIndex node = 0; node < numNodes; node++) {
+				if (m_visited[node]) continue;
+
+				const NodeIndex* begin = graph.neighborsBegin(node);
+				const NodeIndex* end = graph.neighborsEnd(node);
+				const NodeIndex* it = begin;
+				for (; it != end; ++it) {
+					if (0 == (m_frontierBits[*it >> 6] & ((uint64_t) 1 << (*it & 63)))) continue;
+
+					m_visited[node] = 1;
+					m_next.push_back(node);
+					break;
+				}
+
+				if (tracing) {
+					m_scanned += (uint64_t) (it - begin) + ((it != end) ? 1 : 0);
+				}
+			}
+
+			return match(graph, key);
+		}
+
+		/**
+		 *
+		 * Find the first node of the next frontier with a given identifier handle
+		 *
+		 */
+		NodeIndex match(const CsrGraph& graph, StringHandle key) const {
+			size_t pos = Simd::findIndexed(graph.idHandles(), graph.size(), m_next.data(), m_next.size(), key);
+			return (pos < m_next.size()) ? m_next[pos] : INVALID_NODE_INDEX;
+		}
+
+		/**
+		 *
+		 * Check if the next frontier holds more than one node with a given identifier handle
+		 *
+		 */
+		bool hasSecondMatch(const CsrGraph& graph, StringHandle key) const {
+			size_t first = Simd::findIndexed(graph.idHandles(), graph.size(), m_next.data(), m_next.size(), key);
+			if (first + 1 >= m_next.size()) {
+				return false;
+			}
+			size_t second = Simd::findIndexed(graph.idHandles(), graph.size(), m_next.data() + first + 1, m_next.size() - first - 1, key);
+			return first + 1 + second < m_next.size();
+		}
+
+	private:
+		double                   m_alpha{DEFAULT_ALPHA};
+		double                   m_beta{DEFAULT_BETA};
+		SearchTrace*             m_trace{nullptr};
+		uint64_t                 m_scanned{0};
+
+		std::vector<uint8_t>     m_visited;
+		std::vector<uint64_t>    m_frontierBits;
+		std::vector<NodeIndex>   m_frontier;
+		std::vector<NodeIndex>   m_next;
+
+};
@@ -0,0 +1,399 @@
+/*
+ *
+ * Parallel Breadth First Search
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/simd.h>
+#include <auxiliary/threadpool.h>
+
+#include <app/bfs_hybrid.h>
+#include <app/bfs_stats.h>
+#include <app/bfs_topdown.h>
+#include <app/csr.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ *
+ * Parallel level-synchronous BFS engine
+ *
+ * This class splits every BFS level into chunks that run on a
+ * work-stealing thread pool. Top-down levels claim nodes through an
+ * atomic visited bitmap and collect the next frontier in per-chunk
+ * buffers that are concatenated at the end of the level. Bottom-up
+ * levels (see DirectionOptimizingSearch) split the node range instead
+ * and need no atomics on the claim path.
+ *
+ * Levels are cut into more chunks than there are threads, so idle
+ * workers can steal the remaining chunks of a skewed frontier. Every
+ * chunk matches the nodes it has claimed in one SIMD scan (see Simd).
+ *
+ * The node set of every level does not depend on the thread schedule,
+ * so the shallowest matching level is always found. If that level holds
+ * more than one match, the serial search order decides which one is
+ * returned.
+ *
+ */
+class ParallelSearch {
+
+	public:
+		static const size_t MIN_NODES_PER_CHUNK = 512;	///< Levels smaller than this are not split
+		static const size_t CHUNKS_PER_THREAD = 8;		///< Chunks per thread available for stealing
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param numThreads Number of threads, zero selects the number of hardware threads
+		 *
+		 */
+		ParallelSearch(size_t numThreads = 0) {
+			setNumThreads(numThreads);
+		}
+
+	public:
+		/**
+		 *
+		 * Set number of threads
+		 *
+		 * @param numThreads Number of threads, zero selects the number of hardware threads
+		 *
+		 */
+		void setNumThreads(size_t numThreads) {
+			if (0 == numThreads) {
+				numThreads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			if (numThreads == getNumThreads()) {
+				return;
+			}
+			m_pool = (numThreads > 1) ? ThreadPool::createInstance(numThreads) : nullptr;
+		}
+
+		/**
+		 *
+		 * Set thread pool
+		 *
+		 * @param pool Pool to share with other traversals, or null to
+		 * search on the calling thread only
+		 *
+		 */
+		void setThreadPool(ThreadPoolRef pool) {
+			m_pool = pool;
+		}
+
+		ThreadPoolRef getThreadPool() const {
+			return m_pool;
+		}
+
+		size_t getNumThreads() const {
+			return (nullptr != m_pool) ? m_pool->size() : 1;
+		}
+
+		/**
+		 *
+		 * Enable bottom-up levels
+		 *
+		 * @param enabled True to switch between top-down and bottom-up levels
+		 * @param alpha Top-down to bottom-up switching threshold
+		 * @param beta Bottom-up to top-down switching threshold
+		 *
+		 */
+		void setDirectionOptimizing(bool enabled, double alpha, double beta) {
+			m_directionOptimizing = enabled;
+			m_alpha = alpha;
+			m_beta = beta;
+		}
+
+		/**
+		 *
+		 * Set trace receiving the level statistics
+		 *
+		 * @param trace Trace, or null to disable instrumentation
+		 *
+		 */
+		void setTrace(SearchTrace* trace) {
+			m_trace = trace;
+		}
+
+		/**
+		 *
+		 * Find a named node.
+		 *
+		 * @param graph CSR snapshot to be searched.
+		 * @param id Identifier to be found.
+		 * @return Returns the index of the found node, or
+		 * INVALID_NODE_INDEX in case no node has been found.
+		 *
+		 */
+		NodeIndex find(const CsrGraph& graph, const std::string& id) {
+
+			if (graph.empty()) {
+				return INVALID_NODE_INDEX;
+			}
+
+			// intern once, nodes are matched by handle
+			StringHandle key = graph.lookupId(id);
+			if (INVALID_STRING_HANDLE == key) {
+				return INVALID_NODE_INDEX;
+			}
+
+			bool tracing = nullptr != m_trace && m_trace->enabled();
+			if (tracing) {
+				m_trace->root();
+			}
+
+			if (graph.getIdHandle(0) == key) {
+				return 0;
+			}
+
+			size_t numNodes = graph.size();
+			size_t numWords = (numNodes + 63) / 64;
+
+			if (numWords > m_numVisitedWords) {
+				m_visited.reset(new std::atomic<uint64_t>[numWords]);
+				m_numVisitedWords = numWords;
+			}
+			for (size_t i = 0; i < numWords; i++) {
+				m_visited[i].store(0, std::memory_order_relaxed);
+			}
+
+			m_frontier.clear();
+			m_frontier.push_back(0);
+			m_visited[0].store(1, std::memory_order_relaxed);
+
+			uint64_t edgesToCheck = graph.numTargets() - graph.degree(0);
+			uint64_t frontierEdges = graph.degree(0);
+			bool bottomUp = false;
+
+			while (!m_frontier.empty()) {
+
+				if (m_directionOptimizing) {
+					if (!bottomUp) {
+						bottomUp = (double) frontierEdges > (double) edgesToCheck / m_alpha;
+					} else {
+						bottomUp = (double) m_frontier.size() >= (double) numNodes / m_beta;
+					}
+				}
+
+				if (bottomUp) {
+					stepBottomUp(graph, key, tracing);
+				} else {
+					stepTopDown(graph, key);
+				}
+
+				// merge per-chunk results in chunk order
+				size_t numMatches = 0;
+				NodeIndex match = INVALID_NODE_INDEX;
+				size_t nextSize = 0;
+				uint64_t scanned = 0;
+
+				for (size_t t = 0; t < m_numChunks; t++) {
+					nextSize += m_local[t].size();
+					numMatches += m_matches[t].size();
+					scanned += m_scanned[t];
+					if (INVALID_NODE_INDEX == match && !m_matches[t].empty()) {
+						match = m_matches[t].front();
+					}
+				}
+
+				if (tracing) {
+					m_trace->level(m_frontier.size(), nextSize, bottomUp ? scanned : frontierEdges, bottomUp);
+				}
+
+				if (1 == numMatches) {
+					return match;
+				}
+				if (numMatches > 1) {
+					// several matches on the same level, let the serial order decide
+					return TopDownSearch::find(graph, key, BfsWorkspace::forThread());
+				}
+
+				m_frontier.resize(nextSize);
+				frontierEdges = 0;
+
+				size_t pos = 0;
+				for (size_t t = 0; t < m_numChunks; t++) {
+					std::copy(m_local[t].begin(), m_local[t].end(), m_frontier.begin() + pos);
+					pos += m_local[t].size();
+				}
+				for (NodeIndex node : m_frontier) {
+					frontierEdges += graph.degree(node);
+				}
+				edgesToCheck -= std::min(frontierEdges, edgesToCheck);
+			}
+
+			return INVALID_NODE_INDEX;
+		}
+
+	private:
+		/**
+		 *
+		 * Run a function on a number of chunks on the thread pool
+		 *
+		 */
+		template <typename Fn>
+		void runChunks(size_t numChunks, const Fn& fn) {
+			if (nullptr != m_pool) {
+				m_pool->parallelFor(numChunks, fn);
+			} else {
+				for (size_t chunk = 0; chunk < numChunks; chunk++) {
+					fn(chunk);
+				}
+			}
+		}
+
+		/**
+		 *
+		 * Split a level of a given size into chunks and reset the chunk buffers
+		 *
+		 */
+		size_t prepareChunks(size_t work) {
+			size_t maxChunks = getNumThreads() * CHUNKS_PER_THREAD;
+			m_numChunks = std::max((size_t) 1, std::min(maxChunks, work / MIN_NODES_PER_CHUNK));
+
+			if (m_local.size() < m_numChunks) {
+				m_local.resize(m_numChunks);
+				m_matches.resize(m_numChunks);
+				m_scanned.resize(m_numChunks);
+			}
+			for (size_t t = 0; t < m_numChunks; t++) {
+				m_local[t].clear();
+				m_matches[t].clear();
+				m_scanned[t] = 0;
+			}
+
+			return m_numChunks;
+		}
+
+		/**
+		 *
+		 * Expand the frontier top-down, claiming nodes in the atomic bitmap
+		 *
+		 */
+		void stepTopDown(const CsrGraph& graph, StringHandle key) {
+			size_t frontierSize = m_frontier.size();
+			size_t chunks = prepareChunks(frontierSize);
+
+			runChunks(chunks, [&](size_t chunk) {
+				std::vector<NodeIndex>& local = m_local[chunk];
+				std::vector<NodeIndex>& matches = m_matches[chunk];
+
+				size_t begin = frontierSize * chunk / chunks;
+				size_t end = frontierSize * (chunk + 1) / chunks;
+
+				for (size_t i = begin; i < end; i++) {
+					NodeIndex node = m_frontier[i];
+					const NodeIndex* last = graph.neighborsEnd(node);
+
+					for (const NodeIndex* it = graph.neighborsBegin(node); it != last; ++it) {
+						std::atomic<uint64_t>& word = m_visited[*it >> 6];
+						uint64_t bit = (uint64_t) 1 << (*it & 63);
+
+						if (word.load(std::memory_order_relaxed) & bit) continue;
+						if (word.fetch_or(bit, std::memory_order_relaxed) & bit) continue;
+
+						local.push_back(*it);
+					}
+				}
+
+				collectMatches(graph, key, local, matches);
+			});
+		}
+
+		/**
+		 *
+		 * Expand the frontier bottom-up, splitting the node range. While
+		 * tracing, every chunk counts its checked adjacency entries.
+		 *
+		 */
+		void stepBottomUp(const CsrGraph& graph, StringHandle key, bool tracing) {
+			size_t numNodes = graph.size();
+			size_t numWords = (numNodes + 63) / 64;
+
+			m_frontierBits.assign(numWords, 0);
+			for (NodeIndex node : m_frontier) {
+				m_frontierBits[node >> 6] |= (uint64_t) 1 << (node & 63);
+			}
+
+			size_t chunks = prepareChunks(numNodes);
+
+			runChunks(chunks, [&](size_t chunk) {
+				std::vector<NodeIndex>& local = m_local[chunk];
+				std::vector<NodeIndex>& matches = m_matches[chunk];
+				uint64_t scanned = 0;
+
+				// word aligned ranges, so every bitmap word has a single writer
+				size_t begin = std::min(numNodes, (numWords * chunk / chunks) * 64);
+				size_t end = std::min(numNodes, (numWords * (chunk + 1) / chunks) * 64);
+
+				for (size_t node = begin; node < end; node++) {
+					std::atomic<uint64_t>& word = m_visited[node >> 6];
+					uint64_t bit = (uint64_t) 1 << (node & 63);
+
+					if (word.load(std::memory_order_relaxed) & bit) continue;
+
+					const NodeIndex* first = graph.neighborsBegin((NodeIndex) node);
+					const NodeIndex* last = graph.neighborsEnd((NodeIndex) node);
+					const NodeIndex* it = first;
+					for (; it != last; ++it) {
+						if (0 == (m_frontierBits[*it >> 6] & ((uint64_t) 1 << (*it & 63)))) continue;
+
+						word.store(word.load(std::memory_order_relaxed) | bit, std::memory_order_relaxed);
+						local.push_back((NodeIndex) node);
+						break;
+					}
+
+					if (tracing) {
+						scanned += (uint64_t) (it - first) + ((it != last) ? 1 : 0);
+					}
+				}
+
+				m_scanned[chunk] = scanned;
+
+				collectMatches(graph, key, local, matches);
+			});
+		}
+
+		/**
+		 *
+		 * Scan the nodes a chunk has claimed for a given identifier handle
+		 *
+		 */
+		static void collectMatches(const CsrGraph& graph, StringHandle key,
+								   const std::vector<NodeIndex>& local, std::vector<NodeIndex>& matches) {
+			size_t pos = 0;
+			while (pos < local.size()) {
+				pos += Simd::findIndexed(graph.idHandles(), graph.size(), local.data() + pos, local.size() - pos, key);
+				if (pos < local.size()) {
+					matches.push_back(local[pos++]);
+				}
+			}
+		}
+
+	private:
+		ThreadPoolRef                               m_pool;
+		size_t                                      m_numChunks{1};
+		bool                                        m_directionOptimizing{false};
+		double                                      m_alpha{DirectionOptimizingSearch::DEFAULT_ALPHA};
+		double                                      m_beta{DirectionOptimizingSearch::DEFAULT_BETA};
+		SearchTrace*                                m_trace{nullptr};
+
+		std::unique_ptr<std::atomic<uint64_t>[]>    m_visited;
+		size_t                                      m_numVisitedWords{0};
+		std::vector<uint64_t>                       m_frontierBits;
+		std::vector<NodeIndex>                      m_frontier;
+		std::vector<std::vector<NodeIndex>>         m_local;
+		std::vector<std::vector<NodeIndex>>         m_matches;
+		std::vector<uint64_t>                       m_scanned;
+
+};
@@ -0,0 +1,304 @@
+/*
+ *
+ * Breadth First Search statistics
+ *
+ */
+
+#pragma once
+
+#include <app/node.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Set BFS_INSTRUMENTATION to 0 to compile all tracing out of the search
+ * engines; SearchTrace::enabled() then is a constant false.
+ */
+#ifndef BFS_INSTRUMENTATION
+#  define BFS_INSTRUMENTATION 1
+#endif
+
+/**
+ *
+ * Statistics of one BFS level
+ *
+ */
+struct LevelStats {
+
+	size_t     depth{0};            ///< Depth of the expanded frontier, the root is at depth 0
+	size_t     frontierSize{0};     ///< Nodes expanded on this level
+	size_t     discovered{0};       ///< Nodes added to the next frontier
+	uint64_t   edgesScanned{0};     ///< Adjacency entries looked at
+	bool       bottomUp{false};     ///< True if the level ran bottom-up
+	double     seconds{0.0};        ///< Time spent on the level
+
+};
+
+/**
+ *
+ * Statistics of one search
+ *
+ */
+struct SearchStats {
+
+	NodeIndex                result{INVALID_NODE_INDEX};   ///< Found node, INVALID_NODE_INDEX for a miss
+	size_t                   nodesVisited{0};              ///< Nodes reached, including the root
+	uint64_t                 edgesScanned{0};              ///< Adjacency entries looked at
+	size_t                   depth{0};                     ///< Deepest level expanded
+	size_t                   directionSwitches{0};         ///< Changes between top-down and bottom-up levels
+	double                   seconds{0.0};                 ///< Time of the traversal
+	std::vector<LevelStats>  levels;                       ///< One entry per expanded level
+
+	void clear() {
+		result = INVALID_NODE_INDEX;
+		nodesVisited = 0;
+		edgesScanned = 0;
+		depth = 0;
+		directionSwitches = 0;
+		seconds = 0.0;
+		levels.clear();
+	}
+
+};
+
+/**
+ *
+ * Search observer
+ *
+ * Callbacks a search engine invokes while tracing is enabled, e.g. to
+ * export traversal shapes to a dashboard. The default implementations
+ * do nothing.
+ *
+ */
+class SearchObserver {
+
+	public:
+		virtual ~SearchObserver() {
+		}
+
+		/**
+		 *
+		 * Called when a level has been expanded
+		 *
+		 */
+		virtual void onLevel(const LevelStats& level) {
+			(void) level;
+		}
+
+		/**
+		 *
+		 * Called when a search ends, with the complete statistics
+		 *
+		 */
+		virtual void onSearchEnd(const SearchStats& stats) {
+			(void) stats;
+		}
+
+};
+
+/**
+ *
+ * Search trace
+ *
+ * Records the statistics of the running search for the engines. Stats
+ * are only gathered while they are collected or an observer is set;
+ * engines check enabled() once per search and skip all counting
+ * otherwise.
+ *
+ */
+class SearchTrace {
+
+	public:
+		/**
+		 *
+		 * Enable collection of statistics
+		 *
+		 * @param enabled True to keep the statistics of the last search
+		 *
+		 */
+		void setCollectStats(bool enabled) {
+			m_collect = enabled;
+		}
+
+		void setObserver(SearchObserver* observer) {
+			m_observer = observer;
+		}
+
+		SearchObserver* getObserver() const {
+			return m_observer;
+		}
+
+		/**
+		 *
+		 * Check if the running search is traced
+		 *
+		 */
+		bool enabled() const {
+			return BFS_INSTRUMENTATION && (m_collect || nullptr != m_observer);
+		}
+
+		/**
+		 *
+		 * Get statistics of the last traced search
+		 *
+		 */
+		const SearchStats& getStats() const {
+			return m_stats;
+		}
+
+		/**
+		 *
+		 * Start a search
+		 *
+		 */
+		void begin() {
+			if (!enabled()) return;
+
+			m_stats.clear();
+			m_start = Clock::now();
+			m_levelStart = m_start;
+		}
+
+		/**
+		 *
+		 * Record that the traversal visited the root
+		 *
+		 */
+		void root() {
+			if (!enabled()) return;
+
+			m_stats.nodesVisited = 1;
+		}
+
+		/**
+		 *
+		 * Record an expanded level
+		 *
+		 * @param frontierSize Nodes expanded on the level
+		 * @param discovered Nodes added to the next frontier
+		 * @param edgesScanned Adjacency entries looked at
+		 * @param bottomUp True if the level ran bottom-up
+		 *
+		 */
+		void level(size_t frontierSize, size_t discovered, uint64_t edgesScanned, bool bottomUp = false) {
+			if (!enabled()) return;
+
+			Clock::time_point now = Clock::now();
+
+			LevelStats stats;
+			stats.depth = m_stats.levels.size();
+			stats.frontierSize = frontierSize;
+			stats.discovered = discovered;
+			stats.edgesScanned = edgesScanned;
+			stats.bottomUp = bottomUp;
+			stats.seconds = std::chrono::duration<double>(now - m_levelStart).count();
+			m_levelStart = now;
+
+			if (!m_stats.levels.empty() && m_stats.levels.back().bottomUp != bottomUp) {
+				m_stats.directionSwitches++;
+			}
+
+			m_stats.nodesVisited += discovered;
+			m_stats.edgesScanned += edgesScanned;
+			m_stats.depth = stats.depth;
+			m_stats.levels.push_back(stats);
+
+			if (nullptr != m_observer) {
+				m_observer->onLevel(stats);
+			}
+		}
+
+		/**
+		 *
+		 * End the search
+		 *
+		 * @param result Found node, INVALID_NODE_INDEX for a miss
+		 *
+		 */
+		void end(NodeIndex result) {
+			if (!enabled()) return;
+
+			m_stats.result = result;
+			m_stats.seconds = std::chrono::duration<double>(Clock::now() - m_start).count();
+
+			if (nullptr != m_observer) {
+				m_observer->onSearchEnd(m_stats);
+			}
+		}
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+	private:
+		bool               m_collect{false};
+		SearchObserver*    m_observer{nullptr};
+		SearchStats        m_stats;
+		Clock::time_point  m_start;
+		Clock::time_point  m_levelStart;
+
+};
+
+/**
+ *
+ * Level counter of queue based searches
+ *
+ * A FIFO search has no explicit frontiers. This class finds the level
+ * boundaries from the number of nodes popped per level and reports
+ * every completed level to a trace. It must only be used while the
+ * trace is enabled.
+ *
+ */
+class QueueLevelCounter {
+
+	public:
+		explicit QueueLevelCounter(SearchTrace* trace)
+			: m_trace(trace) {
+		}
+
+	public:
+		/**
+		 *
+		 * Count a node taken from the queue
+		 *
+		 */
+		void pop() {
+			if (0 == m_left) {
+				m_trace->level(m_size, m_discovered, m_scanned);
+				m_size = m_left = m_discovered;
+				m_discovered = 0;
+				m_scanned = 0;
+			}
+			m_left--;
+		}
+
+		/**
+		 *
+		 * Count an adjacency entry of the popped node
+		 *
+		 * @param discovered True if the neighbor has been queued
+		 *
+		 */
+		void scan(bool discovered) {
+			m_scanned++;
+			m_discovered += discovered ? 1 : 0;
+		}
+
+		/**
+		 *
+		 * Report the last level, up to the node popped last
+		 *
+		 */
+		void finish() {
+			m_trace->level(m_size - m_left, m_discovered, m_scanned);
+		}
+
+	private:
+		SearchTrace*   m_trace;
+		size_t         m_size{1};
+		size_t         m_left{1};
+		size_t         m_discovered{0};
+		uint64_t       m_scanned{0};
+
+};
@@ -0,0 +1,93 @@
+/*
+ *
+ * Top-down Breadth First Search
+ *
+ */
+
+#pragma once
+
+#include <app/bfs_stats.h>
+#include <app/bfs_workspace.h>
+#include <app/graph_traits.h>
+
+#include <cstdint>
+
+/**
+ *
+ * Top-down BFS
+ *
+ * This class implements the serial queue based traversal from node 0.
+ * Its visiting order defines which node a search returns if several
+ * nodes share the searched identifier, so the other engines fall back
+ * to it to break such ties.
+ *
+ */
+class TopDownSearch {
+
+	public:
+		/**
+		 *
+		 * Find a node by its prepared key in any graph type
+		 *
+		 * @param graph Graph to be searched, see GraphTraits
+		 * @param key Key of the identifier, see GraphTraits::lookupKey()
+		 * @param workspace Workspace holding the visited set and queue
+		 * @param trace Trace receiving the level statistics, or null
+		 * @return Returns the index of the first node with the given key
+		 * in BFS order from node 0, or INVALID_NODE_INDEX in case no node
+		 * has been found.
+		 *
+		 */
+		template <typename G>
+		static NodeIndex find(const G& graph, const typename GraphTraits<G>::Key& key, BfsWorkspace& workspace,
+							  SearchTrace* trace = nullptr) {
+
+			typedef GraphTraits<G> Traits;
+
+			if (0 == Traits::size(graph)) {
+				return INVALID_NODE_INDEX;
+			}
+
+			workspace.reset(Traits::size(graph));
+			workspace.visit(0);
+			workspace.push(0);
+
+			bool tracing = nullptr != trace && trace->enabled();
+			if (tracing) {
+				trace->root();
+			}
+
+			QueueLevelCounter levels(trace);
+
+			while (!workspace.empty()) {
+				NodeIndex node = workspace.pop();
+				if (tracing) {
+					levels.pop();
+				}
+
+				if (Traits::matches(graph, node, key)) {
+					if (tracing) {
+						levels.finish();
+					}
+					return node;
+				}
+
+				Traits::forEachNeighbor(graph, node, [&workspace, &levels, tracing](NodeIndex other) {
+					bool discovered = workspace.visit(other);
+					if (discovered) {
+						workspace.push(other);
+					}
+					if (tracing) {
+						levels.scan(discovered);
+					}
+				});
+			}
+
+			if (tracing) {
+				levels.finish();
+			}
+
+			return INVALID_NODE_INDEX;
+		}
+
+};
@@ -0,0 +1,127 @@
+/*
+ *
+ * Breadth First Search Workspace
+ *
+ */
+
+#pragma once
+
+#include <app/node.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ *
+ * BFS workspace
+ *
+ * This class holds the scratch state of a queue based traversal so it can
+ * be reused across queries. The visited set stores, per node, the epoch of
+ * the query that last visited it; starting a query bumps the epoch, which
+ * un-visits every node in constant time instead of clearing N entries.
+ * The queue is a ring over a preallocated power-of-two buffer.
+ *
+ * Arrays only grow, so a workspace used on graphs of different sizes
+ * settles at the largest one. A workspace must not be shared by threads
+ * running at the same time; see forThread() for a per-thread instance.
+ *
+ */
+class BfsWorkspace {
+
+	public:
+		/**
+		 *
+		 * Start a new traversal
+		 *
+		 * Empties the queue and marks all nodes as unvisited.
+		 *
+		 * @param numNodes Number of nodes of the graph to be traversed
+		 *
+		 */
+		void reset(size_t numNodes) {
+			if (numNodes > m_stamps.size()) {
+				m_stamps.resize(numNodes, 0);
+			}
+
+			if (numNodes > m_queue.size()) {
+				size_t capacity = 1;
+				while (capacity < numNodes) {
+					capacity *= 2;
+				}
+				m_queue.resize(capacity);
+				m_mask = capacity - 1;
+			}
+
+			if (0 == ++m_epoch) {
+				// stamps from 2^32 queries ago would look current again
+				std::fill(m_stamps.begin(), m_stamps.end(), 0);
+				m_epoch = 1;
+			}
+
+			m_head = 0;
+			m_tail = 0;
+		}
+
+		/**
+		 *
+		 * Mark node as visited
+		 *
+		 * @param node Index of the node, must be below the size passed to reset()
+		 * @return Returns true if the node has not been visited before in
+		 * this traversal, false otherwise.
+		 *
+		 */
+		bool visit(NodeIndex node) {
+			if (m_epoch == m_stamps[node]) {
+				return false;
+			}
+			m_stamps[node] = m_epoch;
+			return true;
+		}
+
+		bool isVisited(NodeIndex node) const {
+			return m_epoch == m_stamps[node];
+		}
+
+		/**
+		 *
+		 * Queue a node
+		 *
+		 * Every node is queued at most once per traversal, so the queue
+		 * never holds more than the number of nodes passed to reset().
+		 *
+		 */
+		void push(NodeIndex node) {
+			m_queue[m_tail++ & m_mask] = node;
+		}
+
+		NodeIndex pop() {
+			return m_queue[m_head++ & m_mask];
+		}
+
+		bool empty() const {
+			return m_head == m_tail;
+		}
+
+		/**
+		 *
+		 * Get workspace of the calling thread
+		 *
+		 * @return Returns a workspace owned by the calling thread.
+		 *
+		 */
+		static BfsWorkspace& forThread() {
+			static thread_local BfsWorkspace workspace;
+			return workspace;
+		}
+
+	private:
+		std::vector<uint32_t>    m_stamps;
+		std::vector<NodeIndex>   m_queue;
+		size_t                   m_mask{0};
+		size_t                   m_head{0};
+		size_t                   m_tail{0};
+		uint32_t                 m_epoch{0};
+
+};
@@ -0,0 +1,318 @@
+/*
+ *
+ * Compressed graph
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+#include <auxiliary/logger.h>
+#include <auxiliary/stringpool.h>
+
+#include <app/csr.h>
+#include <app/node.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CompressedGraph;
+typedef std::shared_ptr<const CompressedGraph> CompressedGraphRef;
+
+/**
+ *
+ * Compressed graph
+ *
+ * This class implements an immutable snapshot with compressed adjacency
+ * lists. Every list is sorted and stored as a byte stream of varints:
+ * the degree, the first neighbor as a zigzag encoded difference to the
+ * node itself, and the gaps between consecutive neighbors. Most gaps
+ * of graphs with some locality fit into one or two bytes, so the
+ * generated datasets take 1.5 to 2.5 bytes per adjacency entry instead
+ * of the four bytes of a CsrGraph. A traversal reads correspondingly
+ * less memory, at the cost of decoding, which pays off once the graph
+ * no longer fits into the caches.
+ *
+ * Lists are located through a 64-bit offset per block of BLOCK_SIZE
+ * nodes plus a 32-bit offset per node relative to its block.
+ *
+ * The class implements the interface described by GraphTraits, so
+ * BreadthFirstSearch decodes the lists while it traverses them. Since
+ * the lists are sorted, a search returns the first match in BFS order
+ * over sorted neighbors, which differs from the snapshot order only if
+ * several nodes on the same level share the searched identifier.
+ *
+ */
+class CompressedGraph {
+
+	public:
+		typedef StringHandle Key;				///< Nodes are matched by identifier handle
+
+		static const size_t BLOCK_SIZE = 1024;	///< Nodes per 64-bit block offset
+
+	public:
+		CompressedGraph() = default;
+
+		CompressedGraph(const CompressedGraph&) = delete;
+		CompressedGraph& operator=(const CompressedGraph&) = delete;
+
+	public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param snapshot Snapshot to be compressed
+		 * @return Returns a reference to the created graph, or null if
+		 * the adjacency of a block exceeds 32-bit offsets.
+		 *
+		 */
+		static CompressedGraphRef createInstance(const CsrGraph& snapshot) {
+			auto graph = std::make_shared<CompressedGraph>();
+
+			size_t numNodes = snapshot.size();
+			graph->m_blockOffsets.reserve(numNodes / BLOCK_SIZE + 1);
+			graph->m_nodeOffsets.resize(numNodes);
+			graph->m_data.reserve(numNodes + snapshot.numTargets());
+
+			std::vector<NodeIndex> sorted;
+			for (NodeIndex node = 0; node < numNodes; node++) {
+				if (0 == node % BLOCK_SIZE) {
+					graph->m_blockOffsets.push_back(graph->m_data.size());
+				}
+
+				uint64_t relative = graph->m_data.size() - graph->m_blockOffsets.back();
+				if (relative > UINT32_MAX) {
+					LOG_ERROR("cannot compress graph because a block exceeds 4 GiB");
+					return nullptr;
+				}
+				graph->m_nodeOffsets[node] = (uint32_t) relative;
+
+				sorted.assign(snapshot.neighborsBegin(node), snapshot.neighborsEnd(node));
+				std::sort(sorted.begin(), sorted.end());
+				graph->appendList(node, sorted);
+			}
+
+			graph->m_data.shrink_to_fit();
+
+			graph->m_numNodes = numNodes;
+			graph->m_numTargets = snapshot.numTargets();
+			graph->m_idData.assign(snapshot.idData(), snapshot.idData() + snapshot.idBytes());
+			graph->m_ids.assign(snapshot.idHandles(), snapshot.idHandles() + numNodes);
+			graph->buildIdIndex();
+
+			return graph;
+		}
+
+	public:
+		size_t size() const {
+			return m_numNodes;
+		}
+
+		bool empty() const {
+			return 0 == size();
+		}
+
+		/**
+		 *
+		 * Get number of adjacency entries
+		 *
+		 */
+		size_t numTargets() const {
+			return m_numTargets;
+		}
+
+		/**
+		 *
+		 * Get node degree
+		 *
+		 * @param node Index of the node
+		 * @return Returns the number of neighbors of the node.
+		 *
+		 */
+		size_t degree(NodeIndex node) const {
+			const uint8_t* data = listBegin(node);
+			return (size_t) readVarint(data);
+		}
+
+		/**
+		 *
+		 * Decode the neighbors of a node
+		 *
+		 * @param node Index of the node
+		 * @param fn Function called with the index of every neighbor, in
+		 * increasing order
+		 *
+		 */
+		template <typename Fn>
+		void forEachNeighbor(NodeIndex node, const Fn& fn) const {
+			const uint8_t* data = listBegin(node);
+			uint64_t count = readVarint(data);
+			if (0 == count) {
+				return;
+			}
+
+			uint64_t first = readVarint(data);
+			NodeIndex neighbor = (NodeIndex) ((int64_t) node + unzigzag(first));
+			fn(neighbor);
+
+			for (uint64_t i = 1; i < count; i++) {
+				neighbor += (NodeIndex) readVarint(data);
+				fn(neighbor);
+			}
+		}
+
+		/**
+		 *
+		 * Get node identifier
+		 *
+		 * @param node Index of the node
+		 * @return Returns a copy of the identifier of the node.
+		 *
+		 */
+		std::string getId(NodeIndex node) const {
+			return std::string(StringPool::c_str(m_idData.data(), m_ids[node]), StringPool::length(m_idData.data(), m_ids[node]));
+		}
+
+		StringHandle getIdHandle(NodeIndex node) const {
+			return m_ids[node];
+		}
+
+		/**
+		 *
+		 * Find node by identifier
+		 *
+		 * @param id Identifier of the node
+		 * @return Returns the lowest index of a node with the given
+		 * identifier, or INVALID_NODE_INDEX if there is none.
+		 *
+		 */
+		NodeIndex findById(const std::string& id) const {
+			return m_index.find(HashIndex::hashKey(id), [this, &id](uint32_t other) {
+				StringHandle handle = m_ids[other];
+				return StringPool::length(m_idData.data(), handle) == id.size()
+					&& 0 == std::memcmp(StringPool::c_str(m_idData.data(), handle), id.data(), id.size());
+			});
+		}
+
+		bool contains(const std::string& id) const {
+			return INVALID_NODE_INDEX != findById(id);
+		}
+
+		/**
+		 *
+		 * Prepare a search key, see GraphTraits
+		 *
+		 */
+		bool lookupKey(const std::string& id, Key& key) const {
+			NodeIndex node = findById(id);
+			key = (INVALID_NODE_INDEX != node) ? m_ids[node] : INVALID_STRING_HANDLE;
+			return INVALID_STRING_HANDLE != key;
+		}
+
+		/**
+		 *
+		 * Check if a node has the searched identifier, see GraphTraits
+		 *
+		 */
+		bool matches(NodeIndex node, const Key& key) const {
+			return m_ids[node] == key;
+		}
+
+		/**
+		 *
+		 * Get memory footprint
+		 *
+		 * @return Returns the number of bytes used by the compressed
+		 * lists and their offsets, comparable to CsrGraph::adjacencyBytes().
+		 *
+		 */
+		size_t adjacencyBytes() const {
+			return m_data.size() + m_nodeOffsets.size() * sizeof(uint32_t) + m_blockOffsets.size() * sizeof(uint64_t);
+		}
+
+	private:
+		const uint8_t* listBegin(NodeIndex node) const {
+			return m_data.data() + m_blockOffsets[node / BLOCK_SIZE] + m_nodeOffsets[node];
+		}
+
+		/**
+		 *
+		 * Encode a sorted neighbor list
+		 *
+		 */
+		void appendList(NodeIndex node, const std::vector<NodeIndex>& neighbors) {
+			writeVarint(neighbors.size());
+			if (neighbors.empty()) {
+				return;
+			}
+
+			writeVarint(zigzag((int64_t) neighbors[0] - (int64_t) node));
+			for (size_t i = 1; i < neighbors.size(); i++) {
+				writeVarint(neighbors[i] - neighbors[i - 1]);
+			}
+		}
+
+		void writeVarint(uint64_t value) {
+			while (value >= 0x80) {
+				m_data.push_back((uint8_t) (value | 0x80));
+				value >>= 7;
+			}
+			m_data.push_back((uint8_t) value);
+		}
+
+		static uint64_t readVarint(const uint8_t*& data) {
+			// most gaps fit into one byte
+			uint64_t value = *data++;
+			if (value < 0x80) {
+				return value;
+			}
+
+			value &= 0x7f;
+			for (unsigned shift = 7; ; shift += 7) {
+				uint64_t byte = *data++;
+				value |= (byte & 0x7f) << shift;
+				if (byte < 0x80) {
+					return value;
+				}
+			}
+		}
+
+		static uint64_t zigzag(int64_t value) {
+			return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+		}
+
+		static int64_t unzigzag(uint64_t value) {
+			return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+		}
+
+		/**
+		 *
+		 * Index identifiers, duplicate identifiers keep the lowest index
+		 *
+		 */
+		void buildIdIndex() {
+			m_index.reserve(m_numNodes);
+			for (size_t i = 0; i < m_numNodes; i++) {
+				StringHandle handle = m_ids[i];
+				uint64_t hash = HashIndex::hashKey(StringPool::c_str(m_idData.data(), handle), StringPool::length(m_idData.data(), handle));
+				m_index.insert(hash, (uint32_t) i, [this, handle](uint32_t other) {
+					return m_ids[other] == handle;
+				});
+			}
+		}
+
+	private:
+		size_t                     m_numNodes{0};
+		size_t                     m_numTargets{0};
+		std::vector<uint64_t>      m_blockOffsets;
+		std::vector<uint32_t>      m_nodeOffsets;
+		std::vector<uint8_t>       m_data;
+		std::vector<char>          m_idData;
+		std::vector<StringHandle>  m_ids;
+		HashIndex                  m_index;
+
+};
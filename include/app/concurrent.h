@@ -0,0 +1,177 @@
+/*
+ *
+ * Concurrent graph
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/epoch.h>
+
+#include <app/csr.h>
+#include <app/graph.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+class ConcurrentGraph;
+typedef std::shared_ptr<ConcurrentGraph> ConcurrentGraphRef;
+
+/**
+ *
+ * Concurrent graph
+ *
+ * This class lets queries run while the graph is updated. A writer
+ * applies batches of updates to a private Graph and publishes a new
+ * immutable CSR snapshot after every batch; readers always search the
+ * latest published snapshot.
+ *
+ * Publishing is read-copy-update: the current version is swapped with
+ * one atomic store, and the replaced version is reclaimed through an
+ * EpochDomain once no reader can still see it. A reader takes no lock
+ * and never waits for the writer; it copies the snapshot reference in a
+ * short epoch critical section and then searches it with any engine for
+ * as long as it needs, e.g. BreadthFirstSearch::find(snapshot(), id).
+ *
+ * Writers are serialized by a mutex. Every batch rebuilds the snapshot
+ * (see Graph::freeze()), so updates should be grouped into batches
+ * rather than published one by one.
+ *
+ */
+class ConcurrentGraph {
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param graph Initial graph, owned by the instance from now on;
+		 * it must not be modified or searched directly anymore
+		 *
+		 */
+		explicit ConcurrentGraph(GraphRef graph)
+			: m_graph(graph) {
+			m_current.store(new Version{m_graph->freeze(), 0}, std::memory_order_seq_cst);
+		}
+
+		~ConcurrentGraph() {
+			delete m_current.load(std::memory_order_relaxed);
+		}
+
+		ConcurrentGraph(const ConcurrentGraph&) = delete;
+		ConcurrentGraph& operator=(const ConcurrentGraph&) = delete;
+
+	public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param graph Initial graph, or null to start with an empty one
+		 * @return Returns a reference to the created instance
+		 *
+		 */
+		static ConcurrentGraphRef createInstance(GraphRef graph = nullptr) {
+			return std::make_shared<ConcurrentGraph>((nullptr != graph) ? graph : Graph::createInstance());
+		}
+
+	public:
+		/**
+		 *
+		 * Get the latest published snapshot
+		 *
+		 * Lock-free. The snapshot stays valid and unchanged for as long
+		 * as the caller holds the reference, regardless of later updates.
+		 *
+		 * @return Returns a reference to the snapshot.
+		 *
+		 */
+		CsrGraphRef snapshot() const {
+			EpochDomain::Guard guard(m_epochs);
+			return m_current.load(std::memory_order_seq_cst)->snapshot;
+		}
+
+		/**
+		 *
+		 * Get the latest published snapshot and its version
+		 *
+		 * @param version Receives the number of batches published before
+		 * the snapshot, zero for the initial graph
+		 * @return Returns a reference to the snapshot.
+		 *
+		 */
+		CsrGraphRef snapshot(uint64_t& version) const {
+			EpochDomain::Guard guard(m_epochs);
+			const Version* current = m_current.load(std::memory_order_seq_cst);
+			version = current->version;
+			return current->snapshot;
+		}
+
+		/**
+		 *
+		 * Get version of the latest published snapshot
+		 *
+		 */
+		uint64_t getVersion() const {
+			EpochDomain::Guard guard(m_epochs);
+			return m_current.load(std::memory_order_seq_cst)->version;
+		}
+
+		/**
+		 *
+		 * Apply a batch of updates and publish it
+		 *
+		 * The function is called with the writer graph, e.g. to add
+		 * nodes and edges, while other writers are locked out. Readers
+		 * keep searching the previous snapshot until the batch has been
+		 * published as a whole.
+		 *
+		 * @param fn Function called with the writer graph
+		 * @return Returns the version of the published snapshot.
+		 *
+		 */
+		template <typename Fn>
+		uint64_t update(const Fn& fn) {
+			std::lock_guard<std::mutex> lock(m_writeLock);
+
+			fn(*m_graph);
+
+			const Version* previous = m_current.load(std::memory_order_relaxed);
+			Version* next = new Version{m_graph->freeze(), previous->version + 1};
+
+			m_current.store(next, std::memory_order_seq_cst);
+			m_epochs.retire(previous);
+			m_epochs.reclaim();
+
+			return next->version;
+		}
+
+		/**
+		 *
+		 * Get number of replaced versions not yet reclaimed
+		 *
+		 */
+		size_t numRetired() const {
+			std::lock_guard<std::mutex> lock(m_writeLock);
+			return m_epochs.numRetired();
+		}
+
+	private:
+		/**
+		 *
+		 * Published version of the graph
+		 *
+		 */
+		struct Version {
+			CsrGraphRef  snapshot;
+			uint64_t     version;
+		};
+
+	private:
+		GraphRef                        m_graph;
+		std::atomic<const Version*>     m_current{nullptr};
+		mutable EpochDomain             m_epochs;
+		mutable std::mutex              m_writeLock;
+
+};
@@ -0,0 +1,363 @@
+/*
+ *
+ * Compressed Sparse Row (CSR) graph
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+#include <auxiliary/logger.h>
+#include <auxiliary/stringpool.h>
+
+#include <app/node.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+class CsrGraph;
+typedef std::shared_ptr<const CsrGraph> CsrGraphRef;
+
+/**
+ *
+ * CSR graph
+ *
+ * This class implements an immutable snapshot of a graph in
+ * compressed-sparse-row layout. The neighbors of node i are stored
+ * contiguously in targets[offsets[i] .. offsets[i+1]) as 32-bit node
+ * indices, so a traversal touches two flat arrays instead of chasing
+ * node pointers.
+ *
+ * Identifiers are stored as handles into a blob of string pool bytes
+ * (see StringPool). A search looks up the searched identifier once with
+ * lookupId() and then compares handles. An id index is built along with
+ * the snapshot, so existence checks and lookups by identifier take
+ * constant time.
+ *
+ * The snapshot only reads its arrays through plain pointers. They are
+ * either owned by the snapshot or point into a mapped graph file (see
+ * GraphFile), in which case nothing is copied on load.
+ *
+ */
+class CsrGraph {
+
+	friend class GraphFile;
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param offsets Offsets into the target array, one entry per node plus one
+		 * @param targets Neighbor indices of all nodes
+		 * @param idData String pool bytes holding the identifiers, see StringPool::data()
+		 * @param ids Identifier handles of all nodes
+		 *
+		 */
+		CsrGraph(std::vector<uint64_t>&& offsets,
+				 std::vector<NodeIndex>&& targets,
+				 std::vector<char>&& idData,
+				 std::vector<StringHandle>&& ids) {
+
+			auto arrays = std::make_shared<Arrays>();
+			arrays->offsets = std::move(offsets);
+			arrays->targets = std::move(targets);
+			arrays->idData = std::move(idData);
+			arrays->ids = std::move(ids);
+
+			if (arrays->offsets.empty()) {
+				arrays->offsets.push_back(0);
+			}
+
+			m_numNodes = arrays->ids.size();
+			m_numTargets = arrays->targets.size();
+			m_offsets = arrays->offsets.data();
+			m_targets = arrays->targets.data();
+			m_idData = arrays->idData.data();
+			m_idBytes = arrays->idData.size();
+			m_ids = arrays->ids.data();
+
+			// nodes are inserted in order, so duplicate identifiers keep the lowest index
+			HashIndex& index = arrays->index;
+			index.reserve(m_numNodes);
+			for (size_t i = 0; i < m_numNodes; i++) {
+				StringHandle handle = m_ids[i];
+				uint64_t hash = HashIndex::hashKey(StringPool::c_str(m_idData, handle), StringPool::length(m_idData, handle));
+				index.insert(hash, (uint32_t) i, [this, handle](uint32_t other) {
+					return m_ids[other] == handle;
+				});
+			}
+
+			m_slots = index.slots();
+			m_numSlots = index.capacity();
+			m_owner = arrays;
+		}
+
+	public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param offsets Offsets into the target array, one entry per node plus one
+		 * @param targets Neighbor indices of all nodes
+		 * @param idData String pool bytes holding the identifiers
+		 * @param ids Identifier handles of all nodes
+		 * @return Returns a reference to the created CSR graph instance
+		 *
+		 */
+		static CsrGraphRef createInstance(std::vector<uint64_t>&& offsets,
+										  std::vector<NodeIndex>&& targets,
+										  std::vector<char>&& idData,
+										  std::vector<StringHandle>&& ids) {
+			return std::make_shared<CsrGraph>(std::move(offsets), std::move(targets), std::move(idData), std::move(ids));
+		}
+
+		/**
+		 *
+		 * Factory method
+		 *
+		 * Builds the adjacency from a list of undirected edges. Both
+		 * directions of every edge are stored in list order, so the
+		 * snapshot equals the one a Graph built with the same addEdge()
+		 * calls would freeze into.
+		 *
+		 * @param edges Edges as (source, target) pairs of node indices
+		 * @param idData String pool bytes holding the identifiers
+		 * @param ids Identifier handles of all nodes
+		 * @return Returns a reference to the created CSR graph instance
+		 *
+		 */
+		static CsrGraphRef fromEdgeList(const std::vector<NodeIndex>& edges,
+										std::vector<char>&& idData,
+										std::vector<StringHandle>&& ids) {
+			size_t numNodes = ids.size();
+
+			std::vector<uint64_t> offsets(numNodes + 1, 0);
+			for (NodeIndex node : edges) {
+				offsets[node + 1]++;
+			}
+			for (size_t i = 0; i < numNodes; i++) {
+				offsets[i + 1] += offsets[i];
+			}
+
+			std::vector<NodeIndex> targets(edges.size());
+			std::vector<uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i + 1 < edges.size(); i += 2) {
+				NodeIndex source = edges[i];
+				NodeIndex target = edges[i + 1];
+				targets[cursor[source]++] = target;
+				targets[cursor[target]++] = source;
+			}
+
+			return createInstance(std::move(offsets), std::move(targets), std::move(idData), std::move(ids));
+		}
+
+	public:
+		/**
+		 *
+		 * Get graph size
+		 *
+		 * @return Returns the number of nodes.
+		 *
+		 */
+		size_t size() const {
+			return m_numNodes;
+		}
+
+		/**
+		 *
+		 * Check if graph is empty
+		 *
+		 * @return Returns true if the graph has no nodes, false otherwise.
+		 *
+		 */
+		bool empty() const {
+			return 0 == size();
+		}
+
+		/**
+		 *
+		 * Get number of adjacency entries
+		 *
+		 * Every undirected edge is stored once per direction.
+		 *
+		 * @return Returns the length of the target array.
+		 *
+		 */
+		size_t numTargets() const {
+			return m_numTargets;
+		}
+
+		/**
+		 *
+		 * Get node degree
+		 *
+		 * @param node Index of the node
+		 * @return Returns the number of neighbors of the node.
+		 *
+		 */
+		size_t degree(NodeIndex node) const {
+			return (size_t) (m_offsets[node + 1] - m_offsets[node]);
+		}
+
+		/**
+		 *
+		 * Get first neighbor of a node
+		 *
+		 * @param node Index of the node
+		 * @return Returns a pointer to the first neighbor index.
+		 *
+		 */
+		const NodeIndex* neighborsBegin(NodeIndex node) const {
+			return m_targets + m_offsets[node];
+		}
+
+		/**
+		 *
+		 * Get end of the neighbors of a node
+		 *
+		 * @param node Index of the node
+		 * @return Returns a pointer past the last neighbor index.
+		 *
+		 */
+		const NodeIndex* neighborsEnd(NodeIndex node) const {
+			return m_targets + m_offsets[node + 1];
+		}
+
+		/**
+		 *
+		 * Get node identifier
+		 *
+		 * @param node Index of the node
+		 * @return Returns a copy of the identifier of the node.
+		 *
+		 */
+		std::string getId(NodeIndex node) const {
+			return std::string(StringPool::c_str(m_idData, m_ids[node]), StringPool::length(m_idData, m_ids[node]));
+		}
+
+		/**
+		 *
+		 * Get node identifier handle
+		 *
+		 * @param node Index of the node
+		 * @return Returns the handle of the node identifier.
+		 *
+		 */
+		StringHandle getIdHandle(NodeIndex node) const {
+			return m_ids[node];
+		}
+
+		/**
+		 *
+		 * Get identifier handles of all nodes
+		 *
+		 * @return Returns a pointer to size() handles, indexed by node.
+		 *
+		 */
+		const StringHandle* idHandles() const {
+			return m_ids;
+		}
+
+		/**
+		 *
+		 * Get raw identifier bytes
+		 *
+		 * @return Returns a pointer to idBytes() string pool bytes, see
+		 * StringPool::data(); getIdHandle() indexes into them.
+		 *
+		 */
+		const char* idData() const {
+			return m_idData;
+		}
+
+		size_t idBytes() const {
+			return m_idBytes;
+		}
+
+		/**
+		 *
+		 * Look up an identifier
+		 *
+		 * @param id Identifier to be found
+		 * @return Returns the handle of the identifier, or
+		 * INVALID_STRING_HANDLE if no node has it.
+		 *
+		 */
+		StringHandle lookupId(const std::string& id) const {
+			NodeIndex node = findById(id);
+			return (INVALID_NODE_INDEX != node) ? m_ids[node] : INVALID_STRING_HANDLE;
+		}
+
+		/**
+		 *
+		 * Find node by identifier
+		 *
+		 * @param id Identifier of the node
+		 * @return Returns the lowest index of a node with the given
+		 * identifier, or INVALID_NODE_INDEX if there is none.
+		 *
+		 */
+		NodeIndex findById(const std::string& id) const {
+			return HashIndex::find(m_slots, m_numSlots, HashIndex::hashKey(id), [this, &id](uint32_t other) {
+				StringHandle handle = m_ids[other];
+				return StringPool::length(m_idData, handle) == id.size()
+					&& 0 == std::memcmp(StringPool::c_str(m_idData, handle), id.data(), id.size());
+			});
+		}
+
+		/**
+		 *
+		 * Check if a node with a given identifier exists
+		 *
+		 * @param id Identifier of the node
+		 * @return Returns true if the snapshot holds such a node, false otherwise.
+		 *
+		 */
+		bool contains(const std::string& id) const {
+			return INVALID_NODE_INDEX != findById(id);
+		}
+
+		/**
+		 *
+		 * Get memory footprint
+		 *
+		 * @return Returns the number of bytes used by the adjacency arrays.
+		 *
+		 */
+		size_t adjacencyBytes() const {
+			return (m_numNodes + 1) * sizeof(uint64_t) + m_numTargets * sizeof(NodeIndex);
+		}
+
+	private:
+		/**
+		 *
+		 * Arrays of a snapshot built in memory
+		 *
+		 */
+		struct Arrays {
+			std::vector<uint64_t>      offsets;
+			std::vector<NodeIndex>     targets;
+			std::vector<char>          idData;
+			std::vector<StringHandle>  ids;
+			HashIndex                  index;
+		};
+
+		CsrGraph() = default;
+
+	private:
+		std::shared_ptr<const void>  m_owner;          ///< Keeps the arrays below alive
+		size_t                       m_numNodes{0};
+		size_t                       m_numTargets{0};
+		const uint64_t*              m_offsets{nullptr};
+		const NodeIndex*             m_targets{nullptr};
+		const char*                  m_idData{nullptr};
+		size_t                       m_idBytes{0};
+		const StringHandle*          m_ids{nullptr};
+		const HashIndex::Slot*       m_slots{nullptr};
+		size_t                       m_numSlots{0};
+
+};
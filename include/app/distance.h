@@ -0,0 +1,142 @@
+/*
+ *
+ * Distance index
+ *
+ */
+
+#pragma once
+
+#include <app/node.h>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+static const uint32_t UNREACHABLE_DEPTH = UINT32_MAX;	///< Distance of nodes not connected to the root
+
+/**
+ *
+ * Distance index
+ *
+ * This class keeps the hop distance of every node from the root (node 0)
+ * while edges are added. Adding an edge can only shorten distances, and
+ * only if the endpoints differ by more than one hop; the decrease is
+ * then propagated breadth-first from the closer endpoint, and the
+ * propagation stops at every node whose distance does not change. An
+ * update therefore touches just the region that got closer to the root,
+ * and a distance is read in constant time.
+ *
+ * Removing edges or nodes is not supported, the index is rebuilt when
+ * the graph is cleared.
+ *
+ */
+class DistanceIndex {
+
+	public:
+		/**
+		 *
+		 * Compute all distances with a full BFS
+		 *
+		 * @param nodes Nodes of the graph, node 0 is the root
+		 *
+		 */
+		void rebuild(const std::vector<Node*>& nodes) {
+			m_depth.assign(nodes.size(), UNREACHABLE_DEPTH);
+			if (nodes.empty()) {
+				return;
+			}
+
+			m_depth[0] = 0;
+			propagate(nodes, 0);
+		}
+
+		/**
+		 *
+		 * Add a node without connections
+		 *
+		 * The first node becomes the root, later ones are unreachable
+		 * until an edge connects them.
+		 *
+		 */
+		void addNode() {
+			m_depth.push_back(m_depth.empty() ? 0 : UNREACHABLE_DEPTH);
+		}
+
+		/**
+		 *
+		 * Add an undirected edge and propagate the distance decreases
+		 *
+		 * @param nodes Nodes of the graph, with the edge already connected
+		 * @param node1 Index of one endpoint
+		 * @param node2 Index of the other endpoint
+		 *
+		 */
+		void addEdge(const std::vector<Node*>& nodes, NodeIndex node1, NodeIndex node2) {
+			m_lastUpdateSize = 0;
+
+			if (m_depth[node2] < m_depth[node1]) {
+				std::swap(node1, node2);
+			}
+
+			// node1 is the closer endpoint, nothing changes unless it saves a hop
+			if (UNREACHABLE_DEPTH == m_depth[node1] || m_depth[node1] + 1 >= m_depth[node2]) {
+				return;
+			}
+
+			m_depth[node2] = m_depth[node1] + 1;
+			propagate(nodes, node2);
+		}
+
+		/**
+		 *
+		 * Get distance of a node from the root
+		 *
+		 * @param node Index of the node
+		 * @return Returns the hop distance, or UNREACHABLE_DEPTH.
+		 *
+		 */
+		uint32_t depth(NodeIndex node) const {
+			return (node < m_depth.size()) ? m_depth[node] : UNREACHABLE_DEPTH;
+		}
+
+		/**
+		 *
+		 * Get number of nodes whose distance changed in the last update
+		 *
+		 */
+		size_t getLastUpdateSize() const {
+			return m_lastUpdateSize;
+		}
+
+	private:
+		/**
+		 *
+		 * Lower the distances of the neighbors of a node, breadth-first
+		 *
+		 */
+		void propagate(const std::vector<Node*>& nodes, NodeIndex start) {
+			m_queue.clear();
+			m_queue.push_back(start);
+
+			for (size_t head = 0; head < m_queue.size(); head++) {
+				NodeIndex node = m_queue[head];
+				uint32_t next = m_depth[node] + 1;
+
+				for (const Node* other : nodes[node]->getConnections()) {
+					NodeIndex index = other->getIndex();
+					if (m_depth[index] <= next) continue;
+
+					m_depth[index] = next;
+					m_queue.push_back(index);
+				}
+			}
+
+			m_lastUpdateSize = m_queue.size();
+		}
+
+	private:
+		std::vector<uint32_t>    m_depth;
+		std::vector<NodeIndex>   m_queue;
+		size_t                   m_lastUpdateSize{0};
+
+};
@@ -0,0 +1,637 @@
+/*
+ *
+ * Synthetic dataset generator
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+#include <auxiliary/logger.h>
+#include <auxiliary/stringpool.h>
+#include <auxiliary/threadpool.h>
+
+#include <app/csr.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ *
+ * Tree topology
+ *
+ * This class describes the dataset the application searches in closed
+ * form: the root carries `levels` groups of `fanout` children, every child
+ * spans a complete fanout-ary tree of levels + 1 node levels, and nodes
+ * are numbered in depth-first preorder. On top of the tree, node i is
+ * connected to node i + d for every power of two d >= 2 below half the
+ * node count and every i that is a multiple of 2d below numNodes - 2d
+ * (the cross-level edges).
+ *
+ * Node 0 is called "root", node i > 0 is called "Node<i - 1>". Counts,
+ * neighbors and identifiers of any node are computed without looking at
+ * other nodes, in the order Graph::addEdge() would have stored them when
+ * the tree is built node by node and the cross-level edges are added
+ * afterwards.
+ *
+ */
+class TreeTopology {
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param levels Number of child groups of the root, and depth of the subtrees below them
+		 * @param fanout Number of children per node
+		 *
+		 */
+		TreeTopology(size_t levels = 0, size_t fanout = 0)
+			: m_levels(levels), m_fanout(fanout) {
+
+			// m_subtree[h] holds the size of a complete tree with h node levels
+			m_subtree.assign(levels + 2, 0);
+			for (size_t h = 1; h < m_subtree.size(); h++) {
+				m_subtree[h] = saturate(1, saturate(fanout, m_subtree[h - 1], true), false);
+			}
+
+			m_numNodes = saturate(1, saturate(saturate(levels, fanout, true), m_subtree[levels + 1], true), false);
+		}
+
+	public:
+		size_t getLevels() const {
+			return m_levels;
+		}
+
+		size_t getFanout() const {
+			return m_fanout;
+		}
+
+		/**
+		 *
+		 * Get number of nodes
+		 *
+		 * @return Returns the number of nodes, or UINT64_MAX if it does
+		 * not fit into 64 bits.
+		 *
+		 */
+		uint64_t numNodes() const {
+			return m_numNodes;
+		}
+
+		/**
+		 *
+		 * Get number of cross-level edges
+		 *
+		 */
+		uint64_t numCrossEdges() const {
+			uint64_t count = 0;
+			for (uint64_t distance = 2; distance < m_numNodes / 2; distance *= 2) {
+				uint64_t span = distance * 2;
+				uint64_t limit = m_numNodes - span;
+				count += (limit + span - 1) / span;
+			}
+			return count;
+		}
+
+		/**
+		 *
+		 * Get number of undirected edges
+		 *
+		 */
+		uint64_t numEdges() const {
+			return m_numNodes - 1 + numCrossEdges();
+		}
+
+		/**
+		 *
+		 * Get node degree
+		 *
+		 * @param node Index of the node, must be below numNodes()
+		 * @return Returns the number of neighbors of the node.
+		 *
+		 */
+		size_t degree(uint64_t node) const {
+			size_t count = 0;
+			forEachNeighbor(node, [&count](uint64_t) { count++; });
+			return count;
+		}
+
+		/**
+		 *
+		 * Visit the neighbors of a node
+		 *
+		 * Neighbors are visited parent first, then the children in
+		 * preorder, then the cross-level partners by increasing distance.
+		 *
+		 * @param node Index of the node, must be below numNodes()
+		 * @param fn Function called with the index of every neighbor
+		 *
+		 */
+		template <typename Fn>
+		void forEachNeighbor(uint64_t node, const Fn& fn) const {
+			uint64_t firstChild = 1;
+			uint64_t numChildren = m_levels * m_fanout;
+			uint64_t stride = m_subtree[m_levels + 1];
+
+			if (0 != node) {
+				size_t height = 0;
+				fn(locate(node, height));
+
+				firstChild = node + 1;
+				numChildren = (height > 1) ? m_fanout : 0;
+				stride = m_subtree[height - 1];
+			}
+
+			for (uint64_t child = 0; child < numChildren; child++) {
+				fn(firstChild + child * stride);
+			}
+
+			for (uint64_t distance = 2; distance < m_numNodes / 2; distance *= 2) {
+				uint64_t span = distance * 2;
+				uint64_t limit = m_numNodes - span;
+
+				if (0 == node % span) {
+					if (node < limit) fn(node + distance);
+				} else if (distance == node % span) {
+					if (node - distance < limit) fn(node - distance);
+				}
+			}
+		}
+
+		/**
+		 *
+		 * Get length of a node identifier
+		 *
+		 * @param node Index of the node
+		 * @return Returns the number of characters of nodeId(node).
+		 *
+		 */
+		static size_t idLength(uint64_t node) {
+			if (0 == node) {
+				return 4;
+			}
+
+			size_t digits = 1;
+			for (uint64_t value = node - 1; value >= 10; value /= 10) {
+				digits++;
+			}
+			return 4 + digits;
+		}
+
+		/**
+		 *
+		 * Write a node identifier
+		 *
+		 * @param node Index of the node
+		 * @param out Buffer receiving idLength(node) characters, not zero terminated
+		 *
+		 */
+		static void writeId(uint64_t node, char* out) {
+			if (0 == node) {
+				std::memcpy(out, "root", 4);
+				return;
+			}
+
+			std::memcpy(out, "Node", 4);
+
+			char* pos = out + idLength(node);
+			uint64_t value = node - 1;
+			do {
+				*--pos = (char) ('0' + value % 10);
+				value /= 10;
+			} while (0 != value);
+		}
+
+		/**
+		 *
+		 * Get node identifier
+		 *
+		 * @param node Index of the node
+		 * @return Returns the identifier of the node.
+		 *
+		 */
+		static std::string nodeId(uint64_t node) {
+			std::string id(idLength(node), ' ');
+			writeId(node, &id[0]);
+			return id;
+		}
+
+	private:
+		/**
+		 *
+		 * Multiply or add, saturating at UINT64_MAX
+		 *
+		 */
+		static uint64_t saturate(uint64_t a, uint64_t b, bool multiply) {
+			if (multiply) {
+				return (0 != a && b > UINT64_MAX / a) ? UINT64_MAX : a * b;
+			}
+			return (b > UINT64_MAX - a) ? UINT64_MAX : a + b;
+		}
+
+		/**
+		 *
+		 * Find the parent of a node by descending from the root
+		 *
+		 * @param node Index of a node other than the root
+		 * @param height Receives the number of node levels of the subtree of the node
+		 * @return Returns the index of the parent.
+		 *
+		 */
+		uint64_t locate(uint64_t node, size_t& height) const {
+			uint64_t parent = 0;
+			uint64_t base = 1;
+			height = m_levels + 1;
+
+			while (true) {
+				uint64_t size = m_subtree[height];
+				uint64_t child = base + ((node - base) / size) * size;
+				if (child == node) {
+					return parent;
+				}
+				parent = child;
+				base = child + 1;
+				height--;
+			}
+		}
+
+	private:
+		size_t                  m_levels;
+		size_t                  m_fanout;
+		uint64_t                m_numNodes{1};
+		std::vector<uint64_t>   m_subtree;
+
+};
+
+/**
+ *
+ * Dataset generator
+ *
+ * This class builds synthetic graphs directly as CSR snapshots, without
+ * creating Node objects. Three topologies are available:
+ *
+ *     Tree      the application dataset, see TreeTopology
+ *     R-MAT     2^scale nodes, edgeFactor edges per node, each edge
+ *               placed by recursively picking one of four quadrants of
+ *               the adjacency matrix with probabilities a, b, c, d
+ *     Uniform   a given number of edges between uniformly random nodes
+ *
+ * Nodes are named like TreeTopology::nodeId() in every topology. Work is
+ * split into slices of the node or edge range that run on a thread pool.
+ * Every slice derives its output from the node or edge index alone (the
+ * random topologies seed a generator per edge), so the result does not
+ * depend on the number of threads. Random graphs may contain self loops
+ * and repeated edges.
+ *
+ */
+class DatasetGenerator {
+
+	public:
+		/**
+		 *
+		 * Topology
+		 *
+		 */
+		typedef enum {
+			TopologyTree = 0,       ///< Application dataset, see TreeTopology
+			TopologyRmat = 1,       ///< Recursive matrix (Kronecker) graph
+			TopologyUniform = 2     ///< Uniformly random edges
+		} topology_t;
+
+		static const size_t MIN_ITEMS_PER_SLICE = 4096;		///< Ranges smaller than this are not split
+		static const size_t SLICES_PER_THREAD = 4;			///< Slices per thread available for stealing
+		static constexpr double DEFAULT_RMAT_A = 0.57;		///< Graph500 quadrant probabilities
+		static constexpr double DEFAULT_RMAT_B = 0.19;
+		static constexpr double DEFAULT_RMAT_C = 0.19;
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param numThreads Number of threads, zero selects the number of hardware threads
+		 *
+		 */
+		DatasetGenerator(size_t numThreads = 0) {
+			setNumThreads(numThreads);
+		}
+
+	public:
+		/**
+		 *
+		 * Set number of threads
+		 *
+		 * @param numThreads Number of threads, zero selects the number of hardware threads
+		 *
+		 */
+		void setNumThreads(size_t numThreads) {
+			if (0 == numThreads) {
+				numThreads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			if (numThreads == getNumThreads()) {
+				return;
+			}
+			m_pool = (numThreads > 1) ? ThreadPool::createInstance(numThreads) : nullptr;
+		}
+
+		/**
+		 *
+		 * Set thread pool
+		 *
+		 * @param pool Pool to share with other work, or null to generate
+		 * on the calling thread only
+		 *
+		 */
+		void setThreadPool(ThreadPoolRef pool) {
+			m_pool = pool;
+		}
+
+		ThreadPoolRef getThreadPool() const {
+			return m_pool;
+		}
+
+		size_t getNumThreads() const {
+			return (nullptr != m_pool) ? m_pool->size() : 1;
+		}
+
+		/**
+		 *
+		 * Select the tree topology
+		 *
+		 * @param levels Number of child groups of the root, and depth of the subtrees below them
+		 * @param fanout Number of children per node
+		 *
+		 */
+		void setTree(size_t levels, size_t fanout) {
+			m_topology = TopologyTree;
+			m_tree = TreeTopology(levels, fanout);
+		}
+
+		/**
+		 *
+		 * Select the R-MAT topology
+		 *
+		 * @param scale Base two logarithm of the number of nodes
+		 * @param edgeFactor Number of edges per node
+		 * @param a Probability of the top left quadrant
+		 * @param b Probability of the top right quadrant
+		 * @param c Probability of the bottom left quadrant, the bottom
+		 * right one gets the rest
+		 *
+		 */
+		void setRmat(size_t scale, size_t edgeFactor,
+					 double a = DEFAULT_RMAT_A, double b = DEFAULT_RMAT_B, double c = DEFAULT_RMAT_C) {
+			m_topology = TopologyRmat;
+			m_scale = std::min<size_t>(scale, 63);
+			m_numNodes = (uint64_t) 1 << m_scale;
+			m_numEdges = m_numNodes * edgeFactor;
+			m_a = a;
+			m_b = b;
+			m_c = c;
+		}
+
+		/**
+		 *
+		 * Select the uniform random topology
+		 *
+		 * @param numNodes Number of nodes
+		 * @param numEdges Number of edges
+		 *
+		 */
+		void setUniform(uint64_t numNodes, uint64_t numEdges) {
+			m_topology = TopologyUniform;
+			m_numNodes = numNodes;
+			m_numEdges = numEdges;
+		}
+
+		/**
+		 *
+		 * Set random seed
+		 *
+		 * @param seed Seed of the random topologies, the same seed
+		 * generates the same graph
+		 *
+		 */
+		void setSeed(uint64_t seed) {
+			m_seed = seed;
+		}
+
+		topology_t getTopology() const {
+			return m_topology;
+		}
+
+		/**
+		 *
+		 * Get number of nodes the selected topology generates
+		 *
+		 */
+		uint64_t numNodes() const {
+			return (TopologyTree == m_topology) ? m_tree.numNodes() : m_numNodes;
+		}
+
+		/**
+		 *
+		 * Get number of undirected edges the selected topology generates
+		 *
+		 */
+		uint64_t numEdges() const {
+			return (TopologyTree == m_topology) ? m_tree.numEdges() : m_numEdges;
+		}
+
+		/**
+		 *
+		 * Generate the graph
+		 *
+		 * @return Returns the CSR snapshot of the graph, or null if the
+		 * graph does not fit into 32-bit node indices.
+		 *
+		 */
+		CsrGraphRef generate() {
+
+			uint64_t nodes = numNodes();
+			if (0 == nodes || nodes >= INVALID_NODE_INDEX) {
+				LOG_ERRORF("cannot generate a graph of %llu nodes", (unsigned long long) nodes);
+				return nullptr;
+			}
+
+			std::vector<char> idData;
+			std::vector<StringHandle> ids;
+			if (!generateIds((size_t) nodes, idData, ids)) {
+				return nullptr;
+			}
+
+			if (TopologyTree != m_topology) {
+				std::vector<NodeIndex> edges;
+				generateEdges(edges);
+				return CsrGraph::fromEdgeList(edges, std::move(idData), std::move(ids));
+			}
+
+			std::vector<uint64_t> offsets((size_t) nodes + 1, 0);
+			std::vector<uint64_t> sliceBase(numSlices(nodes) + 1, 0);
+
+			runSlices(nodes, [&](uint64_t begin, uint64_t end, size_t slice) {
+				uint64_t count = 0;
+				for (uint64_t node = begin; node < end; node++) {
+					count += m_tree.degree(node);
+				}
+				sliceBase[slice + 1] = count;
+			});
+
+			for (size_t slice = 1; slice < sliceBase.size(); slice++) {
+				sliceBase[slice] += sliceBase[slice - 1];
+			}
+
+			std::vector<NodeIndex> targets((size_t) sliceBase.back());
+
+			runSlices(nodes, [&](uint64_t begin, uint64_t end, size_t slice) {
+				uint64_t pos = sliceBase[slice];
+				for (uint64_t node = begin; node < end; node++) {
+					m_tree.forEachNeighbor(node, [&targets, &pos](uint64_t other) {
+						targets[pos++] = (NodeIndex) other;
+					});
+					offsets[node + 1] = pos;
+				}
+			});
+
+			return CsrGraph::createInstance(std::move(offsets), std::move(targets), std::move(idData), std::move(ids));
+		}
+
+	private:
+		/**
+		 *
+		 * Counter based random number generator (splitmix64)
+		 *
+		 */
+		struct Random {
+			uint64_t state;
+
+			uint64_t next() {
+				state += 0x9e3779b97f4a7c15ULL;
+				return HashIndex::hashKey(state);
+			}
+
+			double nextDouble() {
+				return (double) (next() >> 11) * (1.0 / 9007199254740992.0);
+			}
+		};
+
+		size_t numSlices(uint64_t numItems) const {
+			return (size_t) std::max<uint64_t>(1, std::min<uint64_t>(numItems / MIN_ITEMS_PER_SLICE, getNumThreads() * SLICES_PER_THREAD));
+		}
+
+		/**
+		 *
+		 * Split a range into slices and run a function per slice on the thread pool
+		 *
+		 */
+		template <typename Fn>
+		void runSlices(uint64_t numItems, const Fn& fn) {
+			size_t slices = numSlices(numItems);
+
+			auto run = [&fn, numItems, slices](size_t slice) {
+				fn(numItems * slice / slices, numItems * (slice + 1) / slices, slice);
+			};
+
+			if (nullptr != m_pool) {
+				m_pool->parallelFor(slices, run);
+			} else {
+				for (size_t slice = 0; slice < slices; slice++) {
+					run(slice);
+				}
+			}
+		}
+
+		/**
+		 *
+		 * Lay out the node identifiers as string pool bytes (see StringPool)
+		 *
+		 */
+		bool generateIds(size_t nodes, std::vector<char>& idData, std::vector<StringHandle>& ids) {
+			std::vector<uint64_t> sliceBase(numSlices(nodes) + 1, 0);
+
+			runSlices(nodes, [&sliceBase](uint64_t begin, uint64_t end, size_t slice) {
+				uint64_t bytes = 0;
+				for (uint64_t node = begin; node < end; node++) {
+					bytes += sizeof(uint32_t) + TreeTopology::idLength(node) + 1;
+				}
+				sliceBase[slice + 1] = bytes;
+			});
+
+			for (size_t slice = 1; slice < sliceBase.size(); slice++) {
+				sliceBase[slice] += sliceBase[slice - 1];
+			}
+
+			if (sliceBase.back() >= INVALID_STRING_HANDLE) {
+				LOG_ERROR("cannot generate graph because its identifiers exceed the string pool");
+				return false;
+			}
+
+			idData.resize((size_t) sliceBase.back());
+			ids.resize(nodes);
+
+			runSlices(nodes, [&](uint64_t begin, uint64_t end, size_t slice) {
+				uint64_t pos = sliceBase[slice];
+				for (uint64_t node = begin; node < end; node++) {
+					uint32_t length = (uint32_t) TreeTopology::idLength(node);
+					ids[node] = (StringHandle) pos;
+					std::memcpy(&idData[pos], &length, sizeof(length));
+					TreeTopology::writeId(node, &idData[pos + sizeof(length)]);
+					idData[pos + sizeof(length) + length] = '\0';
+					pos += sizeof(length) + length + 1;
+				}
+			});
+
+			return true;
+		}
+
+		/**
+		 *
+		 * Draw the edges of a random topology as (source, target) pairs
+		 *
+		 */
+		void generateEdges(std::vector<NodeIndex>& edges) {
+			edges.resize((size_t) m_numEdges * 2);
+
+			runSlices(m_numEdges, [this, &edges](uint64_t begin, uint64_t end, size_t) {
+				for (uint64_t edge = begin; edge < end; edge++) {
+					Random random{HashIndex::hashKey(m_seed ^ HashIndex::hashKey(edge))};
+
+					uint64_t source = 0;
+					uint64_t target = 0;
+
+					if (TopologyUniform == m_topology) {
+						source = random.next() % m_numNodes;
+						target = random.next() % m_numNodes;
+					} else {
+						for (size_t bit = 0; bit < m_scale; bit++) {
+							double r = random.nextDouble();
+							source = (source << 1) | ((r >= m_a + m_b) ? 1 : 0);
+							target = (target << 1) | ((r >= m_a && r < m_a + m_b) || r >= m_a + m_b + m_c ? 1 : 0);
+						}
+					}
+
+					edges[edge * 2] = (NodeIndex) source;
+					edges[edge * 2 + 1] = (NodeIndex) target;
+				}
+			});
+		}
+
+	private:
+		ThreadPoolRef   m_pool;
+		topology_t      m_topology{TopologyTree};
+		TreeTopology    m_tree;
+		uint64_t        m_numNodes{0};
+		uint64_t        m_numEdges{0};
+		size_t          m_scale{0};
+		double          m_a{DEFAULT_RMAT_A};
+		double          m_b{DEFAULT_RMAT_B};
+		double          m_c{DEFAULT_RMAT_C};
+		uint64_t        m_seed{1};
+
+};
@@ -1,178 +1,542 @@
-/*
- *
- * Graph
- *
- */
-
-#pragma once
-
-#include <auxiliary/logger.h>
-#include <auxiliary/test.h>
-
-#include <app/node.h>
-
-#include <algorithm>
-#include <memory>
-#include <string>
-#include <vector>
-
-class Graph;
-typedef std::shared_ptr<Graph> GraphRef;
-
-/**
- *
- * Graph
- *
- * This class implements a graph.
- *
- */
-class Graph {
-
-    public:
-		/**
-		 *
-		 * Constructor
-		 *
-		 */
-        Graph() { 
-			clear(); 
-		}
-
-    public:
-		/**
-		 *
-		 * Factory method
-		 *
-		 * @return Returns a reference to the created graph instance
-		 *
-		 */
-        static GraphRef createInstance() {
-            Log::info("Graph created");
-            return std::make_shared<Graph>();
-        }
-
-    public:
-		/**
-		 *
-		 * Create new node instance and add it as a child node
-		 *
-		 * @param id Identifier of node
-		 * @return Returns reference to created node instance
-		 *
-		 */
-        NodeRef addNode(const std::string& id) {
-            auto newNode = Node::createInstance(id);
-            m_nodeMap.push_back(newNode);
-            return newNode;
-
-
-            /* ////TO ENABLE DUPLICATE ID CHECK USE THIS CODE///
-            // check if we already have a node with this id.
-            auto foundNode = std::find_if(m_nodeMap.begin(), m_nodeMap.end(), [&id](const NodeRef& node) {
-                return node->getId() == id;
-            });
-
-            // if we already have node with this id return null else create a new node
-            if (foundNode != m_nodeMap.end()) {
-                Log::errorf("Node with id: %d already exists", id);
-                return nullptr;
-            } else {
-                auto newNode = Node::createInstance(id);
-                m_nodeMap.push_back(newNode);
-                Log::debugf("new node created succesfully, id: %d", id);
-                return newNode;
-            }
-            */
-        }
-
-		/**
-		 *
-		 * Create an edge between two nodes
-		 *
-		 * @param node1 Reference to node
-		 * @param node2 Reference to node
-		 *
-		 */
-        void addEdge(NodeRef node1, NodeRef node2) {
-            if (!node1 || !node2) {
-                Log::error("cannot add edge ebcause node is invalid");
-                return;
-            }
-
-            Log::debug("Successfully added edge");
-            node1->connect(node2);
-            node2->connect(node1);
-        }
-
-		/**
-		 *
-		 * Get graph size
-		 *
-		 * This method returns the graph size as the number of nodes.
-		 *
-		 * @return Returns the graph size, or zero for an empty graph.
-		 *
-		 */
-		size_t size() const {
-            return m_nodeMap.size();
-        }
-
-		/**
-		 *
-		 * Clear graph
-		 *
-		 */
-		void clear() {
-            m_nodeMap.clear();
-		}
-
-		/**
-		 *
-		 * Check if graph is empty
-		 *
-		 * @return Returns true if the graph is empty, false otherwise.
-		 *
-		 */
-		bool empty() const {
-            return m_nodeMap.empty();
-		}
-
-		/**
-		 *
-		 * Get node with a specific index
-		 *
-		 * @param index Index of the node to be retrieved.
-		 * @return Returns a reference to an existing node of the graph,
-		 * or null if the index is out of range.
-		 *
-		 */
-		NodeRef getNode(size_t index) const {
-            if (index >= m_nodeMap.size()) {
-                Log::warn("Index out of bounds for node.");
-                return nullptr;
-            } else {
-                return m_nodeMap[index];
-            }
-		}
-
-		/**
-		 *
-		 * Get first node of graph (root)
-		 *
-		 * @return Returns a reference to the first node of the graph,
-		 * or null if the graph is empty.
-		 *
-		 */
-		NodeRef getFirst() const {
-            if (m_nodeMap.empty()) {
-                Log::error("Graph is empty");
-                return nullptr;
-            } else {
-                return m_nodeMap[0];
-            }
-		}
-
-private:
-        std::vector<NodeRef> m_nodeMap;
-
-};
+/*
+ *
+ * Graph
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+#include <auxiliary/logger.h>
+#include <auxiliary/test.h>
+
+#include <app/csr.h>
+#include <app/distance.h>
+#include <app/node.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Graph;
+typedef std::shared_ptr<Graph> GraphRef;
+
+/**
+ *
+ * Graph
+ *
+ * This class implements a graph.
+ *
+ * Nodes and their connections are allocated in graph-owned arenas
+ * (see NodeStorage): nodes are laid out contiguously in creation order
+ * within each arena block, never move, and are released in bulk when
+ * the graph is cleared and no node reference is left.
+ *
+ * Several threads may search the graph as long as nobody modifies it;
+ * updates are not synchronized. To search while the graph is updated
+ * use a ConcurrentGraph, which publishes immutable snapshots.
+ *
+ */
+class Graph {
+
+    public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 */
+        Graph() { 
+			clear(); 
+		}
+
+    public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @return Returns a reference to the created graph instance
+		 *
+		 */
+        static GraphRef createInstance() {
+            LOG_INFO("Graph created");
+            return std::make_shared<Graph>();
+        }
+
+		/**
+		 *
+		 * Factory method
+		 *
+		 * Creates the nodes of a CSR snapshot with their connections in
+		 * snapshot order, so the graph freezes back into an equal snapshot.
+		 *
+		 * @param snapshot Snapshot to be copied, e.g. a generated or imported one
+		 * @return Returns a reference to the created graph instance
+		 *
+		 */
+        static GraphRef createInstance(const CsrGraph& snapshot) {
+            GraphRef graph = createInstance();
+            graph->m_nodeMap.reserve(snapshot.size());
+
+            for (NodeIndex node = 0; node < snapshot.size(); node++) {
+                graph->addNode(snapshot.getId(node));
+            }
+
+            for (NodeIndex node = 0; node < snapshot.size(); node++) {
+                Node* source = graph->m_nodeMap[node];
+                for (const NodeIndex* it = snapshot.neighborsBegin(node); it != snapshot.neighborsEnd(node); ++it) {
+                    source->connect(graph->m_nodeMap[*it]);
+                }
+            }
+
+            return graph;
+        }
+
+    public:
+		/**
+		 *
+		 * Create new node instance and add it as a child node
+		 *
+		 * @param id Identifier of node
+		 * @return Returns reference to created node instance, or nullptr
+		 * if the identifier is a duplicate or does not fit the string pool
+		 *
+		 */
+        NodeRef addNode(const std::string& id) {
+            NodeIndex index = (NodeIndex) m_nodeMap.size();
+            StringHandle handle = m_storage->ids.intern(id);
+            if (INVALID_STRING_HANDLE == handle) {
+                LOG_ERROR("cannot add node because its identifier exceeds the string pool");
+                return nullptr;
+            }
+
+            // reject duplicates while the id index is enabled
+            if (m_hasIdIndex && !m_idIndex.insert(HashIndex::hashKey((uint64_t) handle), index, matchId(handle))) {
+                LOG_ERRORF("Node with id: %s already exists", id.c_str());
+                return nullptr;
+            }
+
+            Node* newNode = m_storage->nodes.create<Node>(m_storage.get(), handle, index);
+            m_nodeMap.push_back(newNode);
+            if (m_hasDistanceIndex) {
+                m_distanceIndex.addNode();
+            }
+            m_frozen.reset();
+            m_version++;
+            return toRef(newNode);
+        }
+
+		/**
+		 *
+		 * Create an edge between two nodes
+		 *
+		 * @param node1 Reference to node
+		 * @param node2 Reference to node
+		 *
+		 */
+        void addEdge(NodeRef node1, NodeRef node2) {
+            if (!node1 || !node2) {
+                LOG_ERROR("cannot add edge ebcause node is invalid");
+                return;
+            }
+
+            if (!contains(node1.get()) || !contains(node2.get())) {
+                LOG_ERROR("cannot add edge because node belongs to another graph");
+                return;
+            }
+
+            node1->connect(node2.get());
+            node2->connect(node1.get());
+            m_frozen.reset();
+            m_version++;
+
+            if (m_hasDistanceIndex) {
+                m_distanceIndex.addEdge(m_nodeMap, node1->getIndex(), node2->getIndex());
+            }
+        }
+
+		/**
+		 *
+		 * Get graph size
+		 *
+		 * This method returns the graph size as the number of nodes.
+		 *
+		 * @return Returns the graph size, or zero for an empty graph.
+		 *
+		 */
+		size_t size() const {
+            return m_nodeMap.size();
+        }
+
+		/**
+		 *
+		 * Clear graph
+		 *
+		 */
+		void clear() {
+            m_nodeMap.clear();
+            m_storage = std::make_shared<NodeStorage>();   // nodes still referenced elsewhere keep the old storage
+            m_idIndex.clear();
+            m_distanceIndex.rebuild(m_nodeMap);
+            m_frozen.reset();
+            m_version++;
+		}
+
+		/**
+		 *
+		 * Get graph identifier
+		 *
+		 * @return Returns an identifier unique among all graphs of the
+		 * process, e.g. to tell cached results of different graphs apart.
+		 *
+		 */
+		uint64_t getUid() const {
+            return m_uid;
+		}
+
+		/**
+		 *
+		 * Get graph version
+		 *
+		 * The version changes with every addNode(), addEdge() and
+		 * clear(), so results computed at one version are valid as long
+		 * as the version stays the same.
+		 *
+		 * @return Returns the version of the graph.
+		 *
+		 */
+		uint64_t getVersion() const {
+            return m_version;
+		}
+
+		/**
+		 *
+		 * Enable or disable the id index
+		 *
+		 * While enabled, the graph maintains a hash index from node
+		 * identifier to node, findById() takes constant time and
+		 * addNode() rejects duplicate identifiers. When enabled on a
+		 * graph that already holds duplicates, the first node wins.
+		 *
+		 * @param enabled True to enable the index, false to drop it
+		 *
+		 */
+		void enableIdIndex(bool enabled) {
+            m_hasIdIndex = enabled;
+            m_idIndex.clear();
+
+            if (!enabled) {
+                return;
+            }
+
+            m_idIndex.reserve(m_nodeMap.size());
+            for (Node* node : m_nodeMap) {
+                StringHandle handle = node->getIdHandle();
+                if (!m_idIndex.insert(HashIndex::hashKey((uint64_t) handle), node->getIndex(), matchId(handle))) {
+                    LOG_WARNF("Duplicate node id %s is not indexed", m_storage->ids.c_str(handle));
+                }
+            }
+		}
+
+		/**
+		 *
+		 * Check if the id index is enabled
+		 *
+		 * @return Returns true if the id index is enabled, false otherwise.
+		 *
+		 */
+		bool hasIdIndex() const {
+            return m_hasIdIndex;
+		}
+
+		/**
+		 *
+		 * Enable or disable the distance index
+		 *
+		 * While enabled, the graph keeps the hop distance of every node
+		 * from the first node up to date (see DistanceIndex), and
+		 * depthOf() and isWithin() take constant time for nodes found in
+		 * constant time.
+		 *
+		 * @param enabled True to enable the index, false to drop it
+		 *
+		 */
+		void enableDistanceIndex(bool enabled) {
+            m_hasDistanceIndex = enabled;
+            m_distanceIndex.rebuild(enabled ? m_nodeMap : std::vector<Node*>());
+		}
+
+		bool hasDistanceIndex() const {
+            return m_hasDistanceIndex;
+		}
+
+		/**
+		 *
+		 * Get hop distance of a node from the first node
+		 *
+		 * This method reads the distance index if it is enabled, and
+		 * falls back to a BFS otherwise. The node is looked up with
+		 * findById().
+		 *
+		 * @param id Identifier of the node
+		 * @return Returns the number of edges on a shortest path from the
+		 * first node, or -1 if there is no node with the identifier or it
+		 * is not connected to the first node.
+		 *
+		 */
+		int depthOf(const std::string& id) const {
+            NodeRef node = findById(id);
+            if (nullptr == node) {
+                return -1;
+            }
+
+            uint32_t depth = UNREACHABLE_DEPTH;
+            if (m_hasDistanceIndex) {
+                depth = m_distanceIndex.depth(node->getIndex());
+            } else {
+                DistanceIndex distances;
+                distances.rebuild(m_nodeMap);
+                depth = distances.depth(node->getIndex());
+            }
+
+            return (UNREACHABLE_DEPTH != depth) ? (int) depth : -1;
+		}
+
+		/**
+		 *
+		 * Check if a node is within a number of hops from the first node
+		 *
+		 * @param id Identifier of the node
+		 * @param hops Maximum number of hops
+		 * @return Returns true if the node exists and depthOf() is at most
+		 * hops, false otherwise.
+		 *
+		 */
+		bool isWithin(const std::string& id, int hops) const {
+            int depth = depthOf(id);
+            return depth >= 0 && depth <= hops;
+		}
+
+		/**
+		 *
+		 * Get the distance index
+		 *
+		 * @return Returns the index, empty unless enabled.
+		 *
+		 */
+		const DistanceIndex& getDistanceIndex() const {
+            return m_distanceIndex;
+		}
+
+		/**
+		 *
+		 * Find node by identifier
+		 *
+		 * This method takes constant time while the id index is enabled
+		 * or if no node has the identifier, and falls back to a linear
+		 * scan otherwise.
+		 *
+		 * @param id Identifier of the node
+		 * @return Returns the first node with the given identifier, or
+		 * null if there is none.
+		 *
+		 */
+		NodeRef findById(const std::string& id) const {
+            StringHandle handle = m_storage->ids.lookup(id);
+            if (INVALID_STRING_HANDLE == handle) {
+                return nullptr;
+            }
+
+            if (m_hasIdIndex) {
+                NodeIndex index = m_idIndex.find(HashIndex::hashKey((uint64_t) handle), matchId(handle));
+                return (INVALID_NODE_INDEX != index) ? toRef(m_nodeMap[index]) : nullptr;
+            }
+
+            auto foundNode = std::find_if(m_nodeMap.begin(), m_nodeMap.end(), [handle](const Node* node) {
+                return node->getIdHandle() == handle;
+            });
+            return (foundNode != m_nodeMap.end()) ? toRef(*foundNode) : nullptr;
+		}
+
+		/**
+		 *
+		 * Look up an identifier in the string pool of the graph
+		 *
+		 * Interning the searched identifier once lets a search compare
+		 * node identifiers by handle.
+		 *
+		 * @param id Identifier to be found
+		 * @return Returns the handle of the identifier, or
+		 * INVALID_STRING_HANDLE if no node of the graph has ever used it.
+		 *
+		 */
+		StringHandle lookupId(const std::string& id) const {
+            return m_storage->ids.lookup(id);
+		}
+
+		/**
+		 *
+		 * Check if graph is empty
+		 *
+		 * @return Returns true if the graph is empty, false otherwise.
+		 *
+		 */
+		bool empty() const {
+            return m_nodeMap.empty();
+		}
+
+		/**
+		 *
+		 * Get node with a specific index
+		 *
+		 * @param index Index of the node to be retrieved.
+		 * @return Returns a reference to an existing node of the graph,
+		 * or null if the index is out of range.
+		 *
+		 */
+		NodeRef getNode(size_t index) const {
+            if (index >= m_nodeMap.size()) {
+                LOG_WARN("Index out of bounds for node.");
+                return nullptr;
+            } else {
+                return toRef(m_nodeMap[index]);
+            }
+		}
+
+		/**
+		 *
+		 * Get raw node pointer with a specific index
+		 *
+		 * Unchecked access for traversal loops that would otherwise copy
+		 * a reference per visited node. The pointer stays valid until the
+		 * graph is cleared or destroyed.
+		 *
+		 * @param index Index of the node, must be below size().
+		 *
+		 */
+		const Node* getNodePointer(size_t index) const {
+			return m_nodeMap[index];
+		}
+
+		/**
+		 *
+		 * Get first node of graph (root)
+		 *
+		 * @return Returns a reference to the first node of the graph,
+		 * or null if the graph is empty.
+		 *
+		 */
+		NodeRef getFirst() const {
+            if (m_nodeMap.empty()) {
+                LOG_ERROR("Graph is empty");
+                return nullptr;
+            } else {
+                return toRef(m_nodeMap[0]);
+            }
+		}
+
+		/**
+		 *
+		 * Freeze graph
+		 *
+		 * This method returns an immutable CSR snapshot of the graph.
+		 * The snapshot is cached until the graph is modified, so
+		 * repeated calls between modifications are free. Concurrent
+		 * callers build it once.
+		 *
+		 * @return Returns a reference to the CSR snapshot.
+		 *
+		 */
+		CsrGraphRef freeze() const {
+            std::lock_guard<std::mutex> lock(m_frozenLock);
+            if (nullptr != m_frozen) {
+                return m_frozen;
+            }
+
+            size_t numNodes = m_nodeMap.size();
+            size_t numConnections = 0;
+
+            for (Node* node : m_nodeMap) {
+                numConnections += node->getConnections().size();
+            }
+
+            std::vector<uint64_t> offsets(numNodes + 1, 0);
+            std::vector<NodeIndex> targets;
+            std::vector<StringHandle> ids(numNodes);
+
+            targets.reserve(numConnections);
+
+            for (size_t i = 0; i < numNodes; i++) {
+                for (Node* other : m_nodeMap[i]->getConnections()) {
+                    targets.push_back(other->getIndex());
+                }
+                offsets[i + 1] = targets.size();
+                ids[i] = m_nodeMap[i]->getIdHandle();
+            }
+
+            // the snapshot gets its own copy of the pool bytes, so it stays valid while the graph grows
+            const StringPool& pool = m_storage->ids;
+            std::vector<char> idData(pool.data(), pool.data() + pool.bytes());
+
+            m_frozen = CsrGraph::createInstance(std::move(offsets), std::move(targets), std::move(idData), std::move(ids));
+            return m_frozen;
+		}
+
+private:
+		/**
+		 *
+		 * Predicate comparing an identifier with an indexed node
+		 *
+		 */
+		struct IdMatch {
+            const std::vector<Node*>& nodes;
+            StringHandle handle;
+
+            bool operator()(uint32_t index) const {
+                return nodes[index]->getIdHandle() == handle;
+            }
+		};
+
+		IdMatch matchId(StringHandle handle) const {
+            return IdMatch{m_nodeMap, handle};
+		}
+
+		/**
+		 *
+		 * Create a reference to a node of the graph, sharing ownership of the storage
+		 *
+		 */
+		NodeRef toRef(Node* node) const {
+            return NodeRef(m_storage, node);
+		}
+
+		/**
+		 *
+		 * Check if a node belongs to the graph
+		 *
+		 */
+		bool contains(const Node* node) const {
+            return node->getIndex() < m_nodeMap.size() && m_nodeMap[node->getIndex()] == node;
+		}
+
+		static uint64_t nextUid() {
+            static std::atomic<uint64_t> next{1};
+            return next.fetch_add(1, std::memory_order_relaxed);
+		}
+
+private:
+        std::vector<Node*>   m_nodeMap;
+        NodeStorageRef       m_storage;
+        mutable CsrGraphRef  m_frozen;
+        mutable std::mutex   m_frozenLock;
+        HashIndex            m_idIndex;
+        bool                 m_hasIdIndex{false};
+        DistanceIndex        m_distanceIndex;
+        bool                 m_hasDistanceIndex{false};
+        uint64_t             m_uid{nextUid()};
+        uint64_t             m_version{0};
+
+};
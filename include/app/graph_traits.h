@@ -0,0 +1,118 @@
+/*
+ *
+ * Graph traits
+ *
+ */
+
+#pragma once
+
+#include <app/csr.h>
+#include <app/graph.h>
+
+#include <string>
+
+/**
+ *
+ * Graph traits
+ *
+ * Compile-time interface a search uses to walk a graph type, so one
+ * traversal runs on every representation without virtual calls. A graph
+ * type either provides the members below, or gets a specialization that
+ * maps them onto its own API:
+ *
+ *     size()                    number of nodes, node 0 is the root
+ *     Key                       type of a prepared search key
+ *     lookupKey(id, key)        prepare a key, false if no node has the id
+ *     matches(node, key)        check if a node has the searched id
+ *     forEachNeighbor(node, fn) call fn with every neighbor index, in
+ *                               adjacency order
+ *
+ */
+template <typename G>
+struct GraphTraits {
+
+	typedef typename G::Key Key;
+
+	static size_t size(const G& graph) {
+		return graph.size();
+	}
+
+	static bool lookupKey(const G& graph, const std::string& id, Key& key) {
+		return graph.lookupKey(id, key);
+	}
+
+	static bool matches(const G& graph, NodeIndex node, const Key& key) {
+		return graph.matches(node, key);
+	}
+
+	template <typename Fn>
+	static void forEachNeighbor(const G& graph, NodeIndex node, const Fn& fn) {
+		graph.forEachNeighbor(node, fn);
+	}
+
+};
+
+/**
+ *
+ * Graph traits of the pointer based graph, nodes are matched by identifier handle
+ *
+ */
+template <>
+struct GraphTraits<Graph> {
+
+	typedef StringHandle Key;
+
+	static size_t size(const Graph& graph) {
+		return graph.size();
+	}
+
+	static bool lookupKey(const Graph& graph, const std::string& id, Key& key) {
+		key = graph.lookupId(id);
+		return INVALID_STRING_HANDLE != key;
+	}
+
+	static bool matches(const Graph& graph, NodeIndex node, const Key& key) {
+		return graph.getNodePointer(node)->getIdHandle() == key;
+	}
+
+	template <typename Fn>
+	static void forEachNeighbor(const Graph& graph, NodeIndex node, const Fn& fn) {
+		for (const Node* other : graph.getNodePointer(node)->getConnections()) {
+			fn(other->getIndex());
+		}
+	}
+
+};
+
+/**
+ *
+ * Graph traits of CSR snapshots, nodes are matched by identifier handle
+ *
+ */
+template <>
+struct GraphTraits<CsrGraph> {
+
+	typedef StringHandle Key;
+
+	static size_t size(const CsrGraph& graph) {
+		return graph.size();
+	}
+
+	static bool lookupKey(const CsrGraph& graph, const std::string& id, Key& key) {
+		key = graph.lookupId(id);
+		return INVALID_STRING_HANDLE != key;
+	}
+
+	static bool matches(const CsrGraph& graph, NodeIndex node, const Key& key) {
+		return graph.getIdHandle(node) == key;
+	}
+
+	template <typename Fn>
+	static void forEachNeighbor(const CsrGraph& graph, NodeIndex node, const Fn& fn) {
+		const NodeIndex* end = graph.neighborsEnd(node);
+		for (const NodeIndex* it = graph.neighborsBegin(node); it != end; ++it) {
+			fn(*it);
+		}
+	}
+
+};
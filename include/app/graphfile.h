@@ -0,0 +1,365 @@
+/*
+ *
+ * Binary graph file
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+#include <auxiliary/logger.h>
+
+#include <app/csr.h>
+#include <app/graph.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+/**
+ *
+ * Binary graph file
+ *
+ * This class writes CSR snapshots to a binary file and maps them back
+ * into memory. The file is laid out exactly like the arrays of a
+ * CsrGraph, so an opened graph reads adjacency, identifiers and the id
+ * index straight from the mapped pages. Loading costs a few system
+ * calls plus an optional checksum pass, independent of the graph size
+ * otherwise; pages are faulted in as traversals touch them.
+ *
+ * Layout (native byte order, every section padded to 8 bytes):
+ *
+ *     Header        64 bytes, see Header
+ *     offsets       (numNodes + 1) x uint64
+ *     targets       numTargets x uint32
+ *     ids           numNodes x uint32, handles into the id blob
+ *     index         numSlots x HashIndex::Slot, keyed by identifier
+ *     id blob       idBytes, string pool bytes (see StringPool)
+ *
+ * The checksum covers everything after the header.
+ *
+ */
+class GraphFile {
+
+	public:
+		static const uint64_t MAGIC = 0x48505247534642ULL;	///< "BFSGRPH" read as a little endian integer
+		static const uint32_t VERSION = 1;					///< Format version written by this code
+
+		/**
+		 *
+		 * File header
+		 *
+		 */
+		struct Header {
+			uint64_t magic;
+			uint32_t version;
+			uint32_t headerBytes;
+			uint64_t numNodes;
+			uint64_t numTargets;
+			uint64_t idBytes;
+			uint64_t numSlots;
+			uint64_t fileBytes;
+			uint64_t checksum;
+		};
+
+	public:
+		/**
+		 *
+		 * Write a graph file
+		 *
+		 * The file is written next to the target and renamed into place,
+		 * so readers never see a partially written file.
+		 *
+		 * @param graph CSR snapshot to be written
+		 * @param path Path of the file
+		 * @return Returns true on success, false otherwise.
+		 *
+		 */
+		static bool write(const CsrGraph& graph, const std::string& path) {
+
+			Header header;
+			std::memset(&header, 0, sizeof(header));
+			header.magic = MAGIC;
+			header.version = VERSION;
+			header.headerBytes = sizeof(Header);
+			header.numNodes = graph.m_numNodes;
+			header.numTargets = graph.m_numTargets;
+			header.idBytes = graph.m_idBytes;
+			header.numSlots = graph.m_numSlots;
+			header.fileBytes = layout(header).fileBytes;
+
+			std::string tempPath = path + ".tmp";
+
+			FILE* file = fopen(tempPath.c_str(), "wb");
+			if (nullptr == file) {
+				LOG_ERRORF("cannot create graph file %s", tempPath.c_str());
+				return false;
+			}
+
+			uint64_t checksum = CHECKSUM_SEED;
+
+			bool ok = 1 == fwrite(&header, sizeof(header), 1, file)
+				&& writeSection(file, graph.m_offsets, (header.numNodes + 1) * sizeof(uint64_t), checksum)
+				&& writeSection(file, graph.m_targets, header.numTargets * sizeof(NodeIndex), checksum)
+				&& writeSection(file, graph.m_ids, header.numNodes * sizeof(StringHandle), checksum)
+				&& writeSection(file, graph.m_slots, header.numSlots * sizeof(HashIndex::Slot), checksum)
+				&& writeSection(file, graph.m_idData, header.idBytes, checksum);
+
+			// the checksum is known once the payload has been written
+			header.checksum = checksum;
+			ok = ok && 0 == fseek(file, 0, SEEK_SET) && 1 == fwrite(&header, sizeof(header), 1, file);
+			ok = (0 == fclose(file)) && ok;
+
+			if (!ok || 0 != std::rename(tempPath.c_str(), path.c_str())) {
+				LOG_ERRORF("cannot write graph file %s", path.c_str());
+				std::remove(tempPath.c_str());
+				return false;
+			}
+
+			return true;
+		}
+
+		/**
+		 *
+		 * Write a graph file
+		 *
+		 * @param graph Graph to be written, see Graph::freeze()
+		 * @param path Path of the file
+		 * @return Returns true on success, false otherwise.
+		 *
+		 */
+		static bool write(GraphRef graph, const std::string& path) {
+			if (nullptr == graph) {
+				return false;
+			}
+			return write(*graph->freeze(), path);
+		}
+
+		/**
+		 *
+		 * Open a graph file
+		 *
+		 * Maps the file read-only. The returned snapshot keeps the mapping
+		 * alive; the file must not be modified while it is mapped.
+		 *
+		 * @param path Path of the file
+		 * @param verifyChecksum Read the whole file once to verify its
+		 * checksum; skipping this only checks the offsets, identifiers and
+		 * index (see isConsistent()) and trusts the adjacency targets, so
+		 * it requires input from a trusted writer
+		 * @return Returns the mapped snapshot, or null on failure.
+		 *
+		 */
+		static CsrGraphRef open(const std::string& path, bool verifyChecksum = true) {
+
+#ifdef _WIN32
+			LOG_ERRORF("cannot map graph file %s, not supported on this platform", path.c_str());
+			return nullptr;
+#else
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				LOG_ERRORF("cannot open graph file %s", path.c_str());
+				return nullptr;
+			}
+
+			struct stat info;
+			if (0 != fstat(fd, &info) || (size_t) info.st_size < sizeof(Header)) {
+				LOG_ERRORF("graph file %s is truncated", path.c_str());
+				::close(fd);
+				return nullptr;
+			}
+
+			size_t fileBytes = (size_t) info.st_size;
+			void* base = mmap(nullptr, fileBytes, PROT_READ, MAP_SHARED, fd, 0);
+			::close(fd);
+
+			if (MAP_FAILED == base) {
+				LOG_ERRORF("cannot map graph file %s", path.c_str());
+				return nullptr;
+			}
+
+			std::shared_ptr<const void> mapping(base, [fileBytes](const void* ptr) {
+				munmap(const_cast<void*>(ptr), fileBytes);
+			});
+
+			const char* data = (const char*) base;
+			const Header& header = *(const Header*) data;
+
+			if (!isValid(header, fileBytes)) {
+				LOG_ERRORF("graph file %s has an unsupported or corrupt header", path.c_str());
+				return nullptr;
+			}
+
+			if (verifyChecksum && header.checksum != computeChecksum(data + sizeof(Header), fileBytes - sizeof(Header))) {
+				LOG_ERRORF("graph file %s has a checksum mismatch", path.c_str());
+				return nullptr;
+			}
+
+			Layout sections = layout(header);
+
+			std::shared_ptr<CsrGraph> graph(new CsrGraph());
+			graph->m_owner = mapping;
+			graph->m_numNodes = (size_t) header.numNodes;
+			graph->m_numTargets = (size_t) header.numTargets;
+			graph->m_offsets = (const uint64_t*) (data + sections.offsets);
+			graph->m_targets = (const NodeIndex*) (data + sections.targets);
+			graph->m_ids = (const StringHandle*) (data + sections.ids);
+			graph->m_slots = (const HashIndex::Slot*) (data + sections.slots);
+			graph->m_numSlots = (size_t) header.numSlots;
+			graph->m_idData = data + sections.idData;
+			graph->m_idBytes = (size_t) header.idBytes;
+
+			if (!verifyChecksum && !isConsistent(*graph)) {
+				LOG_ERRORF("graph file %s has inconsistent sections", path.c_str());
+				return nullptr;
+			}
+
+			return graph;
+#endif
+		}
+
+	private:
+		static const uint64_t CHECKSUM_SEED = 14695981039346656037ULL;
+		static const uint64_t CHECKSUM_PRIME = 1099511628211ULL;
+
+		/**
+		 *
+		 * Byte positions of the sections of a file
+		 *
+		 */
+		struct Layout {
+			uint64_t offsets;
+			uint64_t targets;
+			uint64_t ids;
+			uint64_t slots;
+			uint64_t idData;
+			uint64_t fileBytes;
+		};
+
+		static uint64_t padded(uint64_t bytes) {
+			return (bytes + 7) & ~(uint64_t) 7;
+		}
+
+		static Layout layout(const Header& header) {
+			Layout sections;
+			sections.offsets = sizeof(Header);
+			sections.targets = sections.offsets + padded((header.numNodes + 1) * sizeof(uint64_t));
+			sections.ids = sections.targets + padded(header.numTargets * sizeof(NodeIndex));
+			sections.slots = sections.ids + padded(header.numNodes * sizeof(StringHandle));
+			sections.idData = sections.slots + padded(header.numSlots * sizeof(HashIndex::Slot));
+			sections.fileBytes = sections.idData + padded(header.idBytes);
+			return sections;
+		}
+
+		/**
+		 *
+		 * Check a header against the size of its file
+		 *
+		 */
+		static bool isValid(const Header& header, size_t fileBytes) {
+			if (MAGIC != header.magic || VERSION != header.version || sizeof(Header) != header.headerBytes) {
+				return false;
+			}
+
+			// bound the counts first, so the layout arithmetic cannot overflow
+			if (header.numNodes >= INVALID_NODE_INDEX || header.numTargets > fileBytes || header.idBytes > fileBytes
+					|| header.numSlots > fileBytes || header.numSlots <= header.numNodes
+					|| 0 != (header.numSlots & (header.numSlots - 1))) {
+				return false;
+			}
+
+			return header.fileBytes == fileBytes && layout(header).fileBytes == fileBytes;
+		}
+
+		/**
+		 *
+		 * Check the invariants a search relies on without a checksum
+		 *
+		 * Offsets rise from zero to the number of targets, identifiers lie
+		 * inside the id blob and the index holds node indices plus at
+		 * least one empty slot, so lookups terminate. This reads the
+		 * offsets, ids and index once but not the targets.
+		 *
+		 */
+		static bool isConsistent(const CsrGraph& graph) {
+			if (0 != graph.m_offsets[0] || graph.m_numTargets != graph.m_offsets[graph.m_numNodes]) {
+				return false;
+			}
+
+			for (size_t node = 0; node < graph.m_numNodes; node++) {
+				if (graph.m_offsets[node] > graph.m_offsets[node + 1]) {
+					return false;
+				}
+
+				// length prefix, characters and terminator must fit into the blob
+				uint64_t handle = graph.m_ids[node];
+				if (handle + sizeof(uint32_t) > graph.m_idBytes
+						|| handle + sizeof(uint32_t) + StringPool::length(graph.m_idData, (StringHandle) handle) >= graph.m_idBytes) {
+					return false;
+				}
+			}
+
+			bool empty = false;
+			for (size_t pos = 0; pos < graph.m_numSlots; pos++) {
+				uint32_t value = graph.m_slots[pos].value;
+				if (HashIndex::NOT_FOUND == value) {
+					empty = true;
+				} else if (value >= graph.m_numNodes) {
+					return false;
+				}
+			}
+
+			return empty;
+		}
+
+		/**
+		 *
+		 * Checksum a padded payload, 64-bit FNV-1a over 8-byte words
+		 *
+		 */
+		static uint64_t computeChecksum(const char* data, size_t bytes, uint64_t checksum = CHECKSUM_SEED) {
+			for (size_t pos = 0; pos + sizeof(uint64_t) <= bytes; pos += sizeof(uint64_t)) {
+				uint64_t word;
+				std::memcpy(&word, data + pos, sizeof(word));
+				checksum = (checksum ^ word) * CHECKSUM_PRIME;
+			}
+			return checksum;
+		}
+
+		/**
+		 *
+		 * Write a section padded with zeros and add it to the checksum
+		 *
+		 */
+		static bool writeSection(FILE* file, const void* data, size_t bytes, uint64_t& checksum) {
+			size_t full = bytes & ~(size_t) 7;
+
+			if (full > 0) {
+				if (1 != fwrite(data, full, 1, file)) {
+					return false;
+				}
+				checksum = computeChecksum((const char*) data, full, checksum);
+			}
+
+			if (full < bytes) {
+				char tail[sizeof(uint64_t)] = { 0 };
+				std::memcpy(tail, (const char*) data + full, bytes - full);
+				if (1 != fwrite(tail, sizeof(tail), 1, file)) {
+					return false;
+				}
+				checksum = computeChecksum(tail, sizeof(tail), checksum);
+			}
+
+			return true;
+		}
+
+};
@@ -0,0 +1,188 @@
+/*
+ *
+ * Implicit tree graph
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/logger.h>
+
+#include <app/generator.h>
+#include <app/node.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class ImplicitTreeGraph;
+typedef std::shared_ptr<const ImplicitTreeGraph> ImplicitTreeGraphRef;
+
+/**
+ *
+ * Implicit tree graph
+ *
+ * This class is a read-only view of the application dataset (see
+ * TreeTopology) that stores nothing but its two parameters. Neighbors
+ * and identifiers are computed on demand, and identifiers are resolved
+ * by parsing them, so the graph costs no memory regardless of its size.
+ * Only the per-search state of a traversal grows with the node count.
+ *
+ * The class implements the interface described by GraphTraits and can
+ * be searched with BreadthFirstSearch directly.
+ *
+ */
+class ImplicitTreeGraph {
+
+	public:
+		typedef NodeIndex Key;	///< Nodes are matched by index, identifiers are unique
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param topology Topology of the graph, must have fewer than
+		 * INVALID_NODE_INDEX nodes
+		 *
+		 */
+		explicit ImplicitTreeGraph(const TreeTopology& topology)
+			: m_topology(topology) {
+		}
+
+	public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param levels Number of child groups of the root, and depth of the subtrees below them
+		 * @param fanout Number of children per node
+		 * @return Returns a reference to the created graph, or null if
+		 * the graph does not fit into 32-bit node indices.
+		 *
+		 */
+		static ImplicitTreeGraphRef createInstance(size_t levels, size_t fanout) {
+			TreeTopology topology(levels, fanout);
+			if (topology.numNodes() >= INVALID_NODE_INDEX) {
+				LOG_ERRORF("cannot create an implicit graph of %llu nodes", (unsigned long long) topology.numNodes());
+				return nullptr;
+			}
+			return std::make_shared<ImplicitTreeGraph>(topology);
+		}
+
+	public:
+		const TreeTopology& getTopology() const {
+			return m_topology;
+		}
+
+		/**
+		 *
+		 * Get graph size
+		 *
+		 * @return Returns the number of nodes.
+		 *
+		 */
+		size_t size() const {
+			return (size_t) m_topology.numNodes();
+		}
+
+		bool empty() const {
+			return 0 == size();
+		}
+
+		/**
+		 *
+		 * Get node degree
+		 *
+		 * @param node Index of the node
+		 * @return Returns the number of neighbors of the node.
+		 *
+		 */
+		size_t degree(NodeIndex node) const {
+			return m_topology.degree(node);
+		}
+
+		/**
+		 *
+		 * Visit the neighbors of a node
+		 *
+		 * @param node Index of the node
+		 * @param fn Function called with the index of every neighbor
+		 *
+		 */
+		template <typename Fn>
+		void forEachNeighbor(NodeIndex node, const Fn& fn) const {
+			m_topology.forEachNeighbor(node, [&fn](uint64_t other) {
+				fn((NodeIndex) other);
+			});
+		}
+
+		/**
+		 *
+		 * Get node identifier
+		 *
+		 * @param node Index of the node
+		 * @return Returns the identifier of the node.
+		 *
+		 */
+		std::string getId(NodeIndex node) const {
+			return TreeTopology::nodeId(node);
+		}
+
+		/**
+		 *
+		 * Find node by identifier
+		 *
+		 * @param id Identifier of the node
+		 * @return Returns the index of the node with the given identifier,
+		 * or INVALID_NODE_INDEX if there is none.
+		 *
+		 */
+		NodeIndex findById(const std::string& id) const {
+			if (0 == id.compare("root")) {
+				return 0;
+			}
+
+			// "Node" followed by the canonical decimal index minus one
+			if (id.size() < 5 || id.size() > 14 || 0 != id.compare(0, 4, "Node") || ('0' == id[4] && id.size() > 5)) {
+				return INVALID_NODE_INDEX;
+			}
+
+			uint64_t value = 0;
+			for (size_t pos = 4; pos < id.size(); pos++) {
+				if (id[pos] < '0' || id[pos] > '9') {
+					return INVALID_NODE_INDEX;
+				}
+				value = value * 10 + (uint64_t) (id[pos] - '0');
+			}
+
+			return (value + 1 < m_topology.numNodes()) ? (NodeIndex) (value + 1) : INVALID_NODE_INDEX;
+		}
+
+		bool contains(const std::string& id) const {
+			return INVALID_NODE_INDEX != findById(id);
+		}
+
+		/**
+		 *
+		 * Prepare a search key, see GraphTraits
+		 *
+		 */
+		bool lookupKey(const std::string& id, Key& key) const {
+			key = findById(id);
+			return INVALID_NODE_INDEX != key;
+		}
+
+		/**
+		 *
+		 * Check if a node has the searched identifier, see GraphTraits
+		 *
+		 */
+		bool matches(NodeIndex node, const Key& key) const {
+			return node == key;
+		}
+
+	private:
+		TreeTopology    m_topology;
+
+};
@@ -0,0 +1,437 @@
+/*
+ *
+ * Edge list importer
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+#include <auxiliary/logger.h>
+#include <auxiliary/stringpool.h>
+#include <auxiliary/threadpool.h>
+
+#include <app/csr.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ *
+ * Edge list importer
+ *
+ * This class reads a text graph and builds a CSR snapshot directly,
+ * without creating Node objects. Every line names a node followed by its
+ * neighbors, so both edge lists ("src dst") and adjacency lists
+ * ("src dst1 dst2 ...") are accepted. Tokens are separated by spaces or
+ * tabs, and lines starting with '#' or '%' are comments. Identifiers are
+ * taken verbatim, so numeric ids are found by their decimal text.
+ *
+ * The file is read in blocks cut at line boundaries. Each block is split
+ * into slices that are parsed on a thread pool. Every slice resolves its
+ * tokens through its own dictionary. The slice dictionaries are then
+ * merged into the global one in file order. Node indices are assigned in
+ * order of first appearance no matter how many threads run, so node 0
+ * (the search root) is the first node in the file. Only one block of
+ * text is held in memory at a time.
+ *
+ * Edges are undirected and stored in file order, so the snapshot equals
+ * the one a Graph built with the same addNode()/addEdge() calls would
+ * freeze into.
+ *
+ */
+class EdgeListImporter {
+
+	public:
+		static const size_t DEFAULT_BLOCK_SIZE = 16 * 1024 * 1024;	///< Bytes of text read per block
+		static const size_t MIN_SLICE_SIZE = 64 * 1024;				///< Blocks are not split into smaller slices
+		static const size_t SLICES_PER_THREAD = 4;					///< Slices per thread available for stealing
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param numThreads Number of threads, zero selects the number of hardware threads
+		 *
+		 */
+		EdgeListImporter(size_t numThreads = 0) {
+			setNumThreads(numThreads);
+		}
+
+	public:
+		/**
+		 *
+		 * Set number of threads
+		 *
+		 * @param numThreads Number of threads, zero selects the number of hardware threads
+		 *
+		 */
+		void setNumThreads(size_t numThreads) {
+			if (0 == numThreads) {
+				numThreads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			if (numThreads == getNumThreads()) {
+				return;
+			}
+			m_pool = (numThreads > 1) ? ThreadPool::createInstance(numThreads) : nullptr;
+		}
+
+		/**
+		 *
+		 * Set thread pool
+		 *
+		 * @param pool Pool to share with other work, or null to parse on
+		 * the calling thread only
+		 *
+		 */
+		void setThreadPool(ThreadPoolRef pool) {
+			m_pool = pool;
+		}
+
+		ThreadPoolRef getThreadPool() const {
+			return m_pool;
+		}
+
+		size_t getNumThreads() const {
+			return (nullptr != m_pool) ? m_pool->size() : 1;
+		}
+
+		/**
+		 *
+		 * Set block size
+		 *
+		 * @param blockSize Bytes of text read and parsed at once; lines
+		 * longer than this grow the block
+		 *
+		 */
+		void setBlockSize(size_t blockSize) {
+			m_blockSize = std::max<size_t>(blockSize, 1);
+		}
+
+		/**
+		 *
+		 * Import a graph file
+		 *
+		 * @param path Path of the text file
+		 * @return Returns the CSR snapshot of the graph, or null if the
+		 * file cannot be read.
+		 *
+		 */
+		CsrGraphRef import(const std::string& path) {
+
+			FILE* file = fopen(path.c_str(), "rb");
+			if (nullptr == file) {
+				LOG_ERRORF("cannot open graph file %s", path.c_str());
+				return nullptr;
+			}
+
+			m_ids.clear();
+			m_nodeIds.clear();
+			m_nodeIndex.clear();
+			m_edges.clear();
+
+			std::vector<char> buffer;
+			size_t carry = 0;
+			bool ok = true;
+
+			for (bool eof = false; !eof && ok; ) {
+				if (buffer.size() < carry + m_blockSize) {
+					buffer.resize(carry + m_blockSize);
+				}
+
+				size_t requested = buffer.size() - carry;
+				size_t numRead = fread(buffer.data() + carry, 1, requested, file);
+				if (numRead < requested) {
+					if (ferror(file)) {
+						LOG_ERRORF("cannot read graph file %s", path.c_str());
+						ok = false;
+						break;
+					}
+					eof = true;
+				}
+
+				size_t valid = carry + numRead;
+				size_t end = eof ? valid : lineEnd(buffer.data(), valid);
+
+				if (0 == end) {
+					// no complete line yet, read on into a larger block
+					carry = valid;
+					buffer.resize(buffer.size() * 2);
+					continue;
+				}
+
+				ok = importBlock(buffer.data(), end);
+
+				carry = valid - end;
+				std::memmove(buffer.data(), buffer.data() + end, carry);
+			}
+
+			fclose(file);
+
+			if (!ok) {
+				return nullptr;
+			}
+
+			return buildGraph();
+		}
+
+	private:
+		/**
+		 *
+		 * Identifier found in a slice, referencing the text of the block
+		 *
+		 */
+		struct Token {
+			const char* data;
+			uint32_t length;
+			uint64_t hash;
+		};
+
+		/**
+		 *
+		 * Parse result of a slice
+		 *
+		 * Local node k is tokens[k]. Edges are stored as pairs of local
+		 * nodes; a line without neighbors stores (k, INVALID_NODE_INDEX).
+		 *
+		 */
+		struct Slice {
+			const char*             begin;
+			const char*             end;
+			std::vector<Token>      tokens;
+			HashIndex               index;
+			std::vector<NodeIndex>  edges;
+		};
+
+		/**
+		 *
+		 * Get end of the last complete line
+		 *
+		 * @return Returns the position after the last newline, or zero if
+		 * there is none.
+		 *
+		 */
+		static size_t lineEnd(const char* data, size_t size) {
+			for (size_t pos = size; pos > 0; pos--) {
+				if ('\n' == data[pos - 1]) {
+					return pos;
+				}
+			}
+			return 0;
+		}
+
+		static bool isSpace(char c) {
+			return ' ' == c || '\t' == c || '\r' == c;
+		}
+
+		/**
+		 *
+		 * Parse a block of complete lines and merge it into the graph
+		 *
+		 */
+		bool importBlock(const char* data, size_t size) {
+			size_t numSlices = std::max<size_t>(1, std::min(size / MIN_SLICE_SIZE, getNumThreads() * SLICES_PER_THREAD));
+
+			if (m_slices.size() < numSlices) {
+				m_slices.resize(numSlices);
+			}
+
+			// cut at newlines, so no line spans two slices
+			const char* begin = data;
+			for (size_t i = 0; i < numSlices; i++) {
+				const char* end = data + size * (i + 1) / numSlices;
+				end = std::max(end, begin);
+				while (end < data + size && '\n' != end[-1]) {
+					end++;
+				}
+				m_slices[i].begin = begin;
+				m_slices[i].end = end;
+				begin = end;
+			}
+
+			auto parse = [this](size_t chunk) {
+				parseSlice(m_slices[chunk]);
+			};
+
+			if (nullptr != m_pool) {
+				m_pool->parallelFor(numSlices, parse);
+			} else {
+				for (size_t i = 0; i < numSlices; i++) {
+					parse(i);
+				}
+			}
+
+			for (size_t i = 0; i < numSlices; i++) {
+				if (!mergeSlice(m_slices[i])) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/**
+		 *
+		 * Parse the lines of a slice into local nodes and edges
+		 *
+		 */
+		static void parseSlice(Slice& slice) {
+			slice.tokens.clear();
+			slice.index.clear();
+			slice.edges.clear();
+
+			const char* pos = slice.begin;
+
+			while (pos < slice.end) {
+				const char* eol = (const char*) std::memchr(pos, '\n', slice.end - pos);
+				if (nullptr == eol) {
+					eol = slice.end;
+				}
+
+				NodeIndex source = INVALID_NODE_INDEX;
+				bool hasNeighbors = false;
+
+				while (pos < eol) {
+					while (pos < eol && isSpace(*pos)) pos++;
+					if (pos == eol) break;
+
+					if (INVALID_NODE_INDEX == source && ('#' == *pos || '%' == *pos)) {
+						pos = eol;
+						break;
+					}
+
+					const char* tokenEnd = pos;
+					while (tokenEnd < eol && !isSpace(*tokenEnd)) tokenEnd++;
+
+					NodeIndex node = resolve(slice, pos, (size_t) (tokenEnd - pos));
+					if (INVALID_NODE_INDEX == source) {
+						source = node;
+					} else {
+						slice.edges.push_back(source);
+						slice.edges.push_back(node);
+						hasNeighbors = true;
+					}
+
+					pos = tokenEnd;
+				}
+
+				if (INVALID_NODE_INDEX != source && !hasNeighbors) {
+					slice.edges.push_back(source);
+					slice.edges.push_back(INVALID_NODE_INDEX);
+				}
+
+				pos = eol + 1;
+			}
+		}
+
+		/**
+		 *
+		 * Get local node of a token, adding it on first sight
+		 *
+		 */
+		static NodeIndex resolve(Slice& slice, const char* data, size_t length) {
+			uint64_t hash = HashIndex::hashKey(data, length);
+
+			auto equals = [&slice, data, length](uint32_t other) {
+				const Token& token = slice.tokens[other];
+				return token.length == length && 0 == std::memcmp(token.data, data, length);
+			};
+
+			NodeIndex node = slice.index.find(hash, equals);
+			if (HashIndex::NOT_FOUND == node) {
+				node = (NodeIndex) slice.tokens.size();
+				slice.tokens.push_back(Token{data, (uint32_t) length, hash});
+				slice.index.insert(hash, node, equals);
+			}
+
+			return node;
+		}
+
+		/**
+		 *
+		 * Map the local nodes of a slice to graph nodes and append its edges
+		 *
+		 */
+		bool mergeSlice(const Slice& slice) {
+			m_remap.resize(slice.tokens.size());
+
+			for (size_t local = 0; local < slice.tokens.size(); local++) {
+				const Token& token = slice.tokens[local];
+
+				auto equals = [this, &token](uint32_t other) {
+					StringHandle handle = m_nodeIds[other];
+					return m_ids.length(handle) == token.length && 0 == std::memcmp(m_ids.c_str(handle), token.data, token.length);
+				};
+
+				NodeIndex node = m_nodeIndex.find(token.hash, equals);
+				if (HashIndex::NOT_FOUND == node) {
+					if (m_nodeIds.size() >= INVALID_NODE_INDEX - 1) {
+						LOG_ERROR("cannot import graph because it has too many nodes");
+						return false;
+					}
+					StringHandle handle = m_ids.intern(token.data, token.length);
+					if (INVALID_STRING_HANDLE == handle) {
+						LOG_ERROR("cannot import graph because its identifiers exceed the string pool");
+						return false;
+					}
+					node = (NodeIndex) m_nodeIds.size();
+					m_nodeIds.push_back(handle);
+					m_nodeIndex.insert(token.hash, node, equals);
+				}
+
+				m_remap[local] = node;
+			}
+
+			for (size_t i = 0; i < slice.edges.size(); i += 2) {
+				NodeIndex source = m_remap[slice.edges[i]];
+				NodeIndex target = slice.edges[i + 1];
+
+				// isolated nodes only need their index
+				if (INVALID_NODE_INDEX == target) continue;
+
+				m_edges.push_back(source);
+				m_edges.push_back(m_remap[target]);
+			}
+
+			return true;
+		}
+
+		/**
+		 *
+		 * Build the CSR snapshot from the collected edges
+		 *
+		 */
+		CsrGraphRef buildGraph() {
+			std::vector<char> idData(m_ids.data(), m_ids.data() + m_ids.bytes());
+			std::vector<StringHandle> ids(std::move(m_nodeIds));
+
+			// both directions of an edge, in file order (see Graph::addEdge())
+			CsrGraphRef graph = CsrGraph::fromEdgeList(m_edges, std::move(idData), std::move(ids));
+
+			m_ids.clear();
+			m_nodeIds.clear();
+			m_nodeIndex.clear();
+			std::vector<NodeIndex>().swap(m_edges);
+
+			return graph;
+		}
+
+	private:
+		ThreadPoolRef              m_pool;
+		size_t                     m_blockSize{DEFAULT_BLOCK_SIZE};
+		std::vector<Slice>         m_slices;
+		std::vector<NodeIndex>     m_remap;
+		StringPool                 m_ids;          ///< Identifiers of all nodes seen so far
+		std::vector<StringHandle>  m_nodeIds;      ///< Identifier handle per node
+		HashIndex                  m_nodeIndex;    ///< Identifier hash to node
+		std::vector<NodeIndex>     m_edges;        ///< Edges as (source, target) pairs
+
+};
@@ -1,112 +1,245 @@
-/*
- *
- * Node
- *
- */
-
-#pragma once
-
-#include <auxiliary/logger.h>
-#include <auxiliary/test.h>
-
-#include <memory>
-#include <string>
-#include <vector>
-
-class Node;
-typedef std::shared_ptr<Node> NodeRef;
-typedef std::weak_ptr<Node> NodeWRef;
-
-/**
- *
- * Node
- *
- * This class implements a graph node element.
- *
- */
-class Node {
-
-    private:
-		/**
-		 *
-		 * Constructor
-		 *
-		 */
-        Node() = delete;
-
-    public:
-		/**
-		 *
-		 * Constructor
-		 *
-		 */
-        Node(const std::string& id) {
-            m_id = id;
-        }
-
-    public:
-		/**
-		 *
-		 * Factory method
-		 *
-		 * @param id Identifier of node
-		 * @return Returns a reference to the created node instance
-		 *
-		 */
-        static NodeRef createInstance(const std::string& id) {
-            return std::make_shared<Node>(id);
-        }
-
-    public:
-		/**
-		 *
-		 * Create new node instance and add it as a child node
-		 *
-		 * @param otherNode Reference to node to connect to
-		 *
-		 */
-        void connect(NodeRef otherNode) {
-            m_connections.push_back(otherNode);
-        }
-
-		/**
-		 *
-		 * Get node identifier
-		 *
-		 * @return Returns the node identifier
-		 *
-		 */
-        std::string getId() const {
-            return m_id;
-
-        }
-
-		/**
-		 *
-		 * Get node connections
-		 *
-		 * @return Returns the connections of the node to other nodes
-		 *
-		 */
-        const std::vector<NodeWRef>& getConnections() const {
-            return m_connections;
-        }
-
-		/**
-		 *
-		 * Check if the content of nodes are equal
-		 *
-		 * This function checks if the content (id) of nodes are equal.
-		 *
-		 * @return Returns true if equal, false otherwise.
-		 *
-		 */
-		bool equals(NodeRef node) const {
-            return node->getId() == m_id;
-		}
-
-    private:
-        std::string                m_id{""};
-        std::vector<NodeWRef>      m_connections;
-
-};
+/*
+ *
+ * Node
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/arena.h>
+#include <auxiliary/logger.h>
+#include <auxiliary/stringpool.h>
+#include <auxiliary/test.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+class Node;
+typedef std::shared_ptr<Node> NodeRef;
+typedef std::weak_ptr<Node> NodeWRef;
+
+typedef uint32_t NodeIndex;                             ///< Dense index of a node within its graph
+static const NodeIndex INVALID_NODE_INDEX = UINT32_MAX; ///< Marker for "no node"
+static const size_t STANDALONE_NODE_BLOCK_SIZE = 1024;  ///< Arena block size of nodes created outside of a graph
+
+typedef ArenaArray<Node*> NodeConnections;
+
+/**
+ *
+ * Node storage
+ *
+ * Memory shared by a group of nodes: the arena holding the nodes, the
+ * arena holding their connections, and the pool holding their
+ * identifiers. Keeping connections apart lets nodes created one after
+ * another sit next to each other however edges are added in between.
+ * Node references share ownership of the storage, so a node stays valid
+ * as long as any reference to a node of the same storage is alive, and
+ * the whole group is released at once.
+ *
+ */
+struct NodeStorage {
+
+	NodeStorage(size_t blockSize = Arena::DEFAULT_BLOCK_SIZE)
+		: nodes(blockSize), connections(blockSize) {
+	}
+
+	Arena       nodes;
+	Arena       connections;
+	StringPool  ids;
+
+};
+typedef std::shared_ptr<NodeStorage> NodeStorageRef;
+
+/**
+ *
+ * Node
+ *
+ * This class implements a graph node element.
+ *
+ * Nodes live in a NodeStorage, usually the one of the graph they belong
+ * to. The identifier is interned in the string pool of the storage, so
+ * nodes of the same storage compare identifiers by handle.
+ *
+ */
+class Node {
+
+    private:
+		/**
+		 *
+		 * Constructor
+		 *
+		 */
+        Node() = delete;
+
+    public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param storage Storage holding the node and its identifier
+		 * @param id Handle of the identifier in the string pool of the storage
+		 * @param index Index of the node within its graph
+		 *
+		 */
+        Node(NodeStorage* storage, StringHandle id, NodeIndex index) {
+            m_storage = storage;
+            m_id = id;
+            m_index = index;
+        }
+
+    public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param id Identifier of node
+		 * @return Returns a reference to the created node instance
+		 *
+		 */
+        static NodeRef createInstance(const std::string& id) {
+            return createInstance(id, INVALID_NODE_INDEX);
+        }
+
+		/**
+		 *
+		 * Factory method
+		 *
+		 * The node gets a small storage of its own; nodes of a graph are
+		 * created in the graph storage by Graph::addNode().
+		 *
+		 * @param id Identifier of node
+		 * @param index Index of the node within its graph
+		 * @return Returns a reference to the created node instance, or
+		 * nullptr if the identifier does not fit the string pool
+		 *
+		 */
+        static NodeRef createInstance(const std::string& id, NodeIndex index) {
+            auto storage = std::make_shared<NodeStorage>(STANDALONE_NODE_BLOCK_SIZE);
+            StringHandle handle = storage->ids.intern(id);
+            if (INVALID_STRING_HANDLE == handle) {
+                LOG_ERROR("cannot create node because its identifier exceeds the string pool");
+                return nullptr;
+            }
+            Node* node = storage->nodes.create<Node>(storage.get(), handle, index);
+            return NodeRef(storage, node);
+        }
+
+    public:
+		/**
+		 *
+		 * Get node identifier
+		 *
+		 * This method copies the identifier out of the string pool; use
+		 * getIdHandle() or hasId() on hot paths.
+		 *
+		 * @return Returns the node identifier
+		 *
+		 */
+        std::string getId() const {
+            return m_storage->ids.str(m_id);
+
+        }
+
+		/**
+		 *
+		 * Get handle of the interned node identifier
+		 *
+		 * @return Returns the handle of the identifier in getIdPool()
+		 *
+		 */
+        StringHandle getIdHandle() const {
+            return m_id;
+        }
+
+		/**
+		 *
+		 * Get string pool holding the node identifier
+		 *
+		 * @return Returns the string pool
+		 *
+		 */
+        const StringPool* getIdPool() const {
+            return &m_storage->ids;
+        }
+
+		/**
+		 *
+		 * Check the node identifier
+		 *
+		 * @param id Identifier to compare with
+		 * @return Returns true if the node has the given identifier,
+		 * false otherwise.
+		 *
+		 */
+        bool hasId(const std::string& id) const {
+            return m_storage->ids.equals(m_id, id);
+        }
+
+		/**
+		 *
+		 * Get node index
+		 *
+		 * @return Returns the index of the node within its graph, or
+		 * INVALID_NODE_INDEX if the node does not belong to a graph.
+		 *
+		 */
+        NodeIndex getIndex() const {
+            return m_index;
+        }
+
+		/**
+		 *
+		 * Get node connections
+		 *
+		 * @return Returns the connections of the node to other nodes
+		 *
+		 */
+        const NodeConnections& getConnections() const {
+            return m_connections;
+        }
+
+		/**
+		 *
+		 * Check if the content of nodes are equal
+		 *
+		 * This function checks if the content (id) of nodes are equal.
+		 *
+		 * @return Returns true if equal, false otherwise.
+		 *
+		 */
+		bool equals(NodeRef node) const {
+            if (node->m_storage == m_storage) {
+                return node->m_id == m_id;
+            }
+            return hasId(node->getId());
+		}
+
+    private:
+        friend class Graph;
+
+		/**
+		 *
+		 * Connect to another node
+		 *
+		 * Only the graph connects nodes (see Graph::addEdge()), so both
+		 * nodes share its storage and the graph version and indexes
+		 * follow every connection.
+		 *
+		 * @param otherNode Node of the same storage to connect to
+		 *
+		 */
+        void connect(Node* otherNode) {
+            m_connections.push_back(otherNode, m_storage->connections);
+        }
+
+    private:
+        NodeStorage*               m_storage{nullptr};
+        StringHandle               m_id{INVALID_STRING_HANDLE};
+        NodeIndex                  m_index{INVALID_NODE_INDEX};
+        NodeConnections            m_connections;
+
+};
+
+static_assert(std::is_trivially_destructible<Node>::value, "nodes are released in bulk with their storage");
@@ -0,0 +1,820 @@
+/*
+ *
+ * Partitioned graph
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+#include <auxiliary/logger.h>
+#include <auxiliary/stringpool.h>
+
+#include <app/csr.h>
+#include <app/graph.h>
+#include <app/node.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/socket.h>
+#  include <sys/syscall.h>
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+class PartitionedGraph;
+typedef std::shared_ptr<PartitionedGraph> PartitionedGraphRef;
+
+static const char* const PARTITION_SHARD_ARGUMENT = "--shard";		///< Command line argument starting a shard process, see PartitionedGraph::runShard()
+static const char* const PARTITION_SHARD_EXECUTABLE = "/proc/self/exe";	///< Executable started for every shard
+static const int PARTITION_SHARD_FD = 3;							///< Descriptor of the coordinator socket in a shard process
+
+/**
+ *
+ * Partitioned graph
+ *
+ * This class splits a snapshot into shards by node range or by a hash
+ * of the node index. Every shard is served by its own child process,
+ * which holds the adjacency lists and identifiers of its nodes only;
+ * the calling process keeps nothing but one socket per shard.
+ *
+ * A search runs level-synchronously. Per level the coordinator sends
+ * every shard the nodes other shards have discovered for it, over a
+ * Unix domain socket pair. The shard drops nodes it has already seen,
+ * matches the rest, expands its frontier and answers with the newly
+ * discovered nodes of other shards, bucketed by owner, which the
+ * coordinator routes into the next level. All shards work on a level at
+ * the same time, and a level costs one round trip per shard. Every shard
+ * keeps a bitmap of all nodes it has seen during the search, so it sends
+ * a node at most once.
+ *
+ * The shallowest matching level is always found. If that level holds
+ * more than one match, the node with the lowest index is returned, which
+ * differs from a serial search only if several nodes on the same level
+ * share the searched identifier.
+ *
+ * Shards are started by fork and exec of the running executable with
+ * PARTITION_SHARD_ARGUMENT, so its main() has to pass that mode on to
+ * runShard(). Between fork and exec the child only rearranges its
+ * descriptors, which is safe in a multithreaded caller. A shard inherits
+ * no descriptor but its socket and receives its part of the snapshot
+ * over it. It exits when the socket closes, i.e. also when the
+ * coordinator dies without stopping it. The messages only need a byte
+ * stream, so shards on other machines can be attached through TCP
+ * connections instead of socket pairs. Searches from several threads are
+ * serialized.
+ *
+ */
+class PartitionedGraph {
+
+	public:
+		typedef enum {
+			PartitionRange = 0,     ///< Contiguous index ranges of equal size
+			PartitionHash = 1       ///< Nodes spread by a hash of their index
+		} partition_t;
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * Shards are started by createInstance().
+		 *
+		 * @param numNodes Number of nodes of the partitioned graph
+		 * @param numShards Number of shards
+		 * @param partition Assignment of nodes to shards
+		 *
+		 */
+		PartitionedGraph(size_t numNodes, size_t numShards, partition_t partition)
+			: m_numNodes(numNodes)
+			, m_numShards(numShards)
+			, m_partition(partition) {
+		}
+
+		/**
+		 *
+		 * Destructor
+		 *
+		 * Stops all shards and waits for their processes.
+		 *
+		 */
+		~PartitionedGraph() {
+			shutdown();
+		}
+
+		PartitionedGraph(const PartitionedGraph&) = delete;
+		PartitionedGraph& operator=(const PartitionedGraph&) = delete;
+
+	public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param snapshot Snapshot to be partitioned
+		 * @param numShards Number of shard processes
+		 * @param partition Assignment of nodes to shards
+		 * @return Returns a reference to the created graph, or null if
+		 * the shard processes cannot be started.
+		 *
+		 */
+		static PartitionedGraphRef createInstance(const CsrGraph& snapshot, size_t numShards, partition_t partition = PartitionRange) {
+#ifdef _WIN32
+			LOG_ERROR("cannot partition graph, not supported on this platform");
+			return nullptr;
+#else
+			if (0 == numShards) {
+				LOG_ERROR("cannot partition graph into zero shards");
+				return nullptr;
+			}
+
+			auto graph = std::make_shared<PartitionedGraph>(snapshot.size(), numShards, partition);
+			for (size_t shard = 0; shard < numShards; shard++) {
+				if (!graph->spawn(shard)) {
+					return nullptr;
+				}
+			}
+
+			// all shards run before the first one is loaded, so they build their part in parallel
+			for (size_t shard = 0; shard < numShards; shard++) {
+				if (!graph->sendLoad(snapshot, shard)) {
+					LOG_ERRORF("cannot load shard %zu", shard);
+					return nullptr;
+				}
+			}
+			return graph;
+#endif
+		}
+
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param graph Graph to be partitioned, see Graph::freeze()
+		 * @param numShards Number of shard processes
+		 * @param partition Assignment of nodes to shards
+		 * @return Returns a reference to the created graph, or null on failure.
+		 *
+		 */
+		static PartitionedGraphRef createInstance(GraphRef graph, size_t numShards, partition_t partition = PartitionRange) {
+			if (nullptr == graph) {
+				return nullptr;
+			}
+			return createInstance(*graph->freeze(), numShards, partition);
+		}
+
+		/**
+		 *
+		 * Serve as a shard process
+		 *
+		 * To be called by main() of a process started with
+		 * PARTITION_SHARD_ARGUMENT. Receives the part of the snapshot from
+		 * the coordinator on PARTITION_SHARD_FD and serves its requests.
+		 *
+		 * @return Returns true if the shard has been stopped by the
+		 * coordinator, false if the connection or the load has failed.
+		 *
+		 */
+		static bool runShard() {
+#ifdef _WIN32
+			return false;
+#else
+			bool stopped = false;
+			try {
+				Shard shard;
+				std::unique_ptr<PartitionedGraph> graph = receiveLoad(PARTITION_SHARD_FD, shard);
+				if (nullptr != graph) {
+					stopped = graph->serve(shard, PARTITION_SHARD_FD);
+				} else {
+					LOG_ERROR("shard process cannot load its part of the graph");
+				}
+			} catch (...) {
+			}
+			::close(PARTITION_SHARD_FD);
+			return stopped;
+#endif
+		}
+
+	public:
+		size_t size() const {
+			return m_numNodes;
+		}
+
+		size_t numShards() const {
+			return m_numShards;
+		}
+
+		partition_t getPartition() const {
+			return m_partition;
+		}
+
+		/**
+		 *
+		 * Check shard health
+		 *
+		 * @return Returns false once a shard has failed, searches then
+		 * no longer find anything.
+		 *
+		 */
+		bool isHealthy() const {
+			return m_healthy;
+		}
+
+		/**
+		 *
+		 * Get owning shard of a node
+		 *
+		 * @param node Index of the node
+		 * @return Returns the index of the shard holding the node.
+		 *
+		 */
+		size_t ownerOf(NodeIndex node) const {
+			if (PartitionHash == m_partition) {
+				return (size_t) (HashIndex::hashKey((uint64_t) node) % m_numShards);
+			}
+			return (size_t) ((uint64_t) node * m_numShards / m_numNodes);
+		}
+
+		/**
+		 *
+		 * Find a named node.
+		 *
+		 * @param id Identifier to be found.
+		 * @return Returns the index of the found node, or
+		 * INVALID_NODE_INDEX in case no node has been found or a shard
+		 * has failed.
+		 *
+		 */
+		NodeIndex find(const std::string& id) {
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			if (!m_healthy || 0 == m_numNodes) {
+				return INVALID_NODE_INDEX;
+			}
+
+			// every shard interns the identifier, skip the traversal if none knows it
+			bool known = false;
+			for (size_t shard = 0; shard < m_numShards; shard++) {
+				if (!sendMessage(m_sockets[shard], CommandBegin, id.data(), id.size())) {
+					return fail();
+				}
+			}
+			for (size_t shard = 0; shard < m_numShards; shard++) {
+				if (!receiveMessage(m_sockets[shard], m_reply) || m_reply.empty()) {
+					return fail();
+				}
+				known = known || 0 != m_reply[0];
+			}
+			if (!known) {
+				return INVALID_NODE_INDEX;
+			}
+
+			m_incoming.resize(m_numShards);
+			for (auto& incoming : m_incoming) {
+				incoming.clear();
+			}
+			m_incoming[ownerOf(0)].push_back(0);
+
+			while (true) {
+				for (size_t shard = 0; shard < m_numShards; shard++) {
+					const std::vector<NodeIndex>& incoming = m_incoming[shard];
+					if (!sendMessage(m_sockets[shard], CommandLevel, incoming.data(), incoming.size() * sizeof(NodeIndex))) {
+						return fail();
+					}
+				}
+				for (auto& incoming : m_incoming) {
+					incoming.clear();
+				}
+
+				// reply: match, frontier size, bucket sizes per shard, bucket contents
+				NodeIndex match = INVALID_NODE_INDEX;
+				uint64_t frontierSize = 0;
+
+				for (size_t shard = 0; shard < m_numShards; shard++) {
+					if (!receiveMessage(m_sockets[shard], m_reply) || m_reply.size() < 2 + m_numShards) {
+						return fail();
+					}
+
+					match = std::min(match, (NodeIndex) m_reply[0]);
+					frontierSize += m_reply[1];
+
+					size_t pos = 2 + m_numShards;
+					for (size_t target = 0; target < m_numShards; target++) {
+						size_t count = m_reply[2 + target];
+						if (pos + count > m_reply.size()) {
+							return fail();
+						}
+						m_incoming[target].insert(m_incoming[target].end(), m_reply.begin() + pos, m_reply.begin() + pos + count);
+						pos += count;
+					}
+				}
+
+				if (INVALID_NODE_INDEX != match) {
+					return match;
+				}
+				if (0 == frontierSize) {
+					return INVALID_NODE_INDEX;
+				}
+			}
+		}
+
+	private:
+		typedef enum {
+			CommandBegin = 1,       ///< Start a search, payload is the identifier
+			CommandLevel = 2,       ///< Run a level, payload are the nodes discovered by other shards
+			CommandQuit = 3,        ///< Stop the shard process
+			CommandLoad = 4         ///< Hand the shard its nodes, payload is a LoadHeader and the arrays it describes
+		} command_t;
+
+		/**
+		 *
+		 * Message header, followed by the payload bytes
+		 *
+		 */
+		struct MessageHeader {
+			uint32_t command;
+			uint32_t reserved;
+			uint64_t bytes;
+		};
+
+		/**
+		 *
+		 * Load message header, followed by the adjacency offsets (uint64
+		 * per owned node plus one), the neighbors (NodeIndex each) and the
+		 * identifiers of the owned nodes in StringPool layout
+		 *
+		 */
+		struct LoadHeader {
+			uint64_t numNodes;
+			uint64_t numShards;
+			uint32_t partition;
+			uint32_t index;
+			uint64_t numTargets;
+			uint64_t idBytes;
+		};
+
+		/**
+		 *
+		 * Nodes of a shard, held by the shard process only
+		 *
+		 */
+		struct Shard {
+			size_t                               index{0};
+			std::vector<NodeIndex>               nodes;      ///< Global indices of the owned nodes, increasing
+			std::vector<uint64_t>                offsets;    ///< Offsets into targets, per owned node plus one
+			std::vector<NodeIndex>               targets;    ///< Global indices of the neighbors
+			StringPool                           pool;
+			std::vector<StringHandle>            ids;        ///< Identifier handles into pool, per owned node
+			StringHandle                         key{INVALID_STRING_HANDLE};
+			std::vector<uint64_t>                seen;       ///< Bitmap of all nodes seen in the current search
+			std::vector<NodeIndex>               frontier;   ///< Local indices of the current level
+			std::vector<NodeIndex>               next;       ///< Local indices discovered for the next level
+			std::vector<std::vector<NodeIndex>>  outgoing;   ///< Discovered nodes of other shards, per owner
+			std::vector<uint32_t>                reply;
+		};
+
+	private:
+#ifndef _WIN32
+		/**
+		 *
+		 * Start the process of a shard
+		 *
+		 */
+		bool spawn(size_t index) {
+			int fds[2];
+#ifdef SOCK_CLOEXEC
+			int created = socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds);
+#else
+			int created = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+			if (0 == created) {
+				fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+				fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+			}
+#endif
+			if (0 != created) {
+				LOG_ERRORF("cannot create socket pair for shard %zu", index);
+				return false;
+			}
+
+			// everything the child needs is prepared here, it must not allocate or lock after the fork
+			char* const argv[] = { (char*) PARTITION_SHARD_EXECUTABLE, (char*) PARTITION_SHARD_ARGUMENT, nullptr };
+			long maxFd = sysconf(_SC_OPEN_MAX);
+			int lastFd = (maxFd > 0 && maxFd < INT_MAX) ? (int) maxFd - 1 : 1023;
+
+			pid_t pid = fork();
+			if (pid < 0) {
+				LOG_ERRORF("cannot start process for shard %zu", index);
+				::close(fds[0]);
+				::close(fds[1]);
+				return false;
+			}
+
+			if (0 == pid) {
+				// async-signal-safe calls only until exec, dup2 clears close-on-exec on the copy
+				int moved = (PARTITION_SHARD_FD == fds[1]) ? fcntl(fds[1], F_SETFD, 0) : dup2(fds[1], PARTITION_SHARD_FD);
+				if (moved < 0) {
+					_exit(127);
+				}
+				closeFrom(PARTITION_SHARD_FD + 1, lastFd);
+				execv(PARTITION_SHARD_EXECUTABLE, argv);
+				_exit(127);
+			}
+
+			::close(fds[1]);
+			m_sockets.push_back(fds[0]);
+			m_pids.push_back(pid);
+			return true;
+		}
+
+		/**
+		 *
+		 * Close all descriptors from a given one on, runs between fork and exec
+		 *
+		 */
+		static void closeFrom(int first, int last) {
+#ifdef SYS_close_range
+			if (0 == syscall(SYS_close_range, (unsigned) first, ~0u, 0u)) {
+				return;
+			}
+#endif
+			for (int fd = first; fd <= last; fd++) {
+				::close(fd);
+			}
+		}
+
+		/**
+		 *
+		 * Send a shard its nodes, their adjacency and identifiers
+		 *
+		 */
+		bool sendLoad(const CsrGraph& snapshot, size_t index) const {
+			std::vector<NodeIndex> nodes = ownedNodes(index);
+
+			std::vector<uint64_t> offsets;
+			std::vector<NodeIndex> targets;
+			std::vector<char> ids;
+			offsets.reserve(nodes.size() + 1);
+			offsets.push_back(0);
+
+			for (NodeIndex node : nodes) {
+				targets.insert(targets.end(), snapshot.neighborsBegin(node), snapshot.neighborsEnd(node));
+				offsets.push_back(targets.size());
+
+				StringHandle handle = snapshot.getIdHandle(node);
+				const char* entry = snapshot.idData() + handle;
+				ids.insert(ids.end(), entry, entry + sizeof(uint32_t) + StringPool::length(snapshot.idData(), handle) + 1);
+			}
+
+			LoadHeader load;
+			load.numNodes = m_numNodes;
+			load.numShards = m_numShards;
+			load.partition = (uint32_t) m_partition;
+			load.index = (uint32_t) index;
+			load.numTargets = targets.size();
+			load.idBytes = ids.size();
+
+			MessageHeader header;
+			header.command = CommandLoad;
+			header.reserved = 0;
+			header.bytes = sizeof(load) + offsets.size() * sizeof(uint64_t) + targets.size() * sizeof(NodeIndex) + ids.size();
+
+			int fd = m_sockets[index];
+			return sendAll(fd, &header, sizeof(header)) && sendAll(fd, &load, sizeof(load))
+				&& sendAll(fd, offsets.data(), offsets.size() * sizeof(uint64_t))
+				&& sendAll(fd, targets.data(), targets.size() * sizeof(NodeIndex))
+				&& sendAll(fd, ids.data(), ids.size());
+		}
+
+		/**
+		 *
+		 * Receive the nodes of a shard, runs in the shard process
+		 *
+		 * @return Returns the graph the shard belongs to, without any
+		 * shard processes of its own, or null if the message is invalid.
+		 *
+		 */
+		static std::unique_ptr<PartitionedGraph> receiveLoad(int fd, Shard& shard) {
+			MessageHeader header;
+			LoadHeader load;
+			if (!receiveAll(fd, &header, sizeof(header)) || CommandLoad != header.command || header.bytes < sizeof(load)
+				|| !receiveAll(fd, &load, sizeof(load))) {
+				return nullptr;
+			}
+
+			if (0 == load.numShards || load.index >= load.numShards || load.numNodes >= INVALID_NODE_INDEX
+				|| (PartitionRange != load.partition && PartitionHash != load.partition)) {
+				return nullptr;
+			}
+
+			auto graph = std::make_unique<PartitionedGraph>((size_t) load.numNodes, (size_t) load.numShards, (partition_t) load.partition);
+			shard.index = load.index;
+			shard.nodes = graph->ownedNodes(shard.index);
+
+			// sizes are checked against the message before anything is allocated for them
+			uint64_t remaining = header.bytes - sizeof(load);
+			uint64_t offsetBytes = (shard.nodes.size() + 1) * sizeof(uint64_t);
+			if (load.numTargets > remaining / sizeof(NodeIndex) || load.idBytes > remaining
+				|| offsetBytes + load.numTargets * sizeof(NodeIndex) + load.idBytes != remaining) {
+				return nullptr;
+			}
+
+			shard.offsets.resize(shard.nodes.size() + 1);
+			shard.targets.resize((size_t) load.numTargets);
+			std::vector<char> idData((size_t) load.idBytes);
+			if (!receiveAll(fd, shard.offsets.data(), (size_t) offsetBytes)
+				|| !receiveAll(fd, shard.targets.data(), shard.targets.size() * sizeof(NodeIndex))
+				|| !receiveAll(fd, idData.data(), idData.size())) {
+				return nullptr;
+			}
+
+			if (0 != shard.offsets.front() || load.numTargets != shard.offsets.back()
+				|| !std::is_sorted(shard.offsets.begin(), shard.offsets.end())) {
+				return nullptr;
+			}
+			for (NodeIndex target : shard.targets) {
+				if (target >= load.numNodes) {
+					return nullptr;
+				}
+			}
+
+			shard.ids.reserve(shard.nodes.size());
+			size_t pos = 0;
+			for (size_t node = 0; node < shard.nodes.size(); node++) {
+				if (idData.size() - pos < sizeof(uint32_t) + 1) {
+					return nullptr;
+				}
+				uint32_t length;
+				std::memcpy(&length, idData.data() + pos, sizeof(length));
+				if (idData.size() - pos - sizeof(uint32_t) - 1 < length) {
+					return nullptr;
+				}
+				StringHandle handle = shard.pool.intern(idData.data() + pos + sizeof(uint32_t), length);
+				if (INVALID_STRING_HANDLE == handle) {
+					return nullptr;
+				}
+				shard.ids.push_back(handle);
+				pos += sizeof(uint32_t) + length + 1;
+			}
+			if (pos != idData.size()) {
+				return nullptr;
+			}
+
+			shard.seen.assign((size_t) ((load.numNodes + 63) / 64), 0);
+			shard.outgoing.resize(graph->m_numShards);
+			return graph;
+		}
+#endif
+
+		/**
+		 *
+		 * Stop all shards
+		 *
+		 */
+		void shutdown() {
+#ifndef _WIN32
+			for (int fd : m_sockets) {
+				sendMessage(fd, CommandQuit, nullptr, 0);
+				::close(fd);
+			}
+			for (pid_t pid : m_pids) {
+				while (waitpid(pid, nullptr, 0) < 0 && EINTR == errno) {
+				}
+			}
+			m_sockets.clear();
+			m_pids.clear();
+#endif
+		}
+
+		NodeIndex fail() {
+			LOG_ERROR("shard process failed, partitioned graph is no longer usable");
+			m_healthy = false;
+			return INVALID_NODE_INDEX;
+		}
+
+		/**
+		 *
+		 * Get local index of a node owned by a shard
+		 *
+		 */
+		NodeIndex toLocal(const Shard& shard, NodeIndex node) const {
+			if (PartitionHash == m_partition) {
+				return (NodeIndex) (std::lower_bound(shard.nodes.begin(), shard.nodes.end(), node) - shard.nodes.begin());
+			}
+			return node - shard.nodes.front();
+		}
+
+		/**
+		 *
+		 * Get the nodes owned by a shard, in increasing order
+		 *
+		 */
+		std::vector<NodeIndex> ownedNodes(size_t index) const {
+			std::vector<NodeIndex> nodes;
+			if (PartitionHash == m_partition) {
+				for (NodeIndex node = 0; node < m_numNodes; node++) {
+					if (ownerOf(node) == index) {
+						nodes.push_back(node);
+					}
+				}
+			} else {
+				NodeIndex first = (NodeIndex) ((m_numNodes * index + m_numShards - 1) / m_numShards);
+				NodeIndex last = (NodeIndex) ((m_numNodes * (index + 1) + m_numShards - 1) / m_numShards);
+				for (NodeIndex node = first; node < last; node++) {
+					nodes.push_back(node);
+				}
+			}
+			return nodes;
+		}
+
+		/**
+		 *
+		 * Serve requests of the coordinator, runs in the shard process
+		 *
+		 * @return Returns true if the shard has been stopped, false if the
+		 * connection has failed.
+		 *
+		 */
+		bool serve(Shard& shard, int fd) const {
+			MessageHeader header;
+			std::vector<uint32_t> payload;
+
+			while (receiveAll(fd, &header, sizeof(header))) {
+				payload.resize((size_t) ((header.bytes + sizeof(uint32_t) - 1) / sizeof(uint32_t)));
+				if (!receiveAll(fd, payload.data(), (size_t) header.bytes)) {
+					return false;
+				}
+
+				if (CommandQuit == header.command) {
+					return true;
+				}
+
+				if (CommandBegin == header.command) {
+					shard.key = shard.pool.lookup(std::string((const char*) payload.data(), (size_t) header.bytes));
+					std::fill(shard.seen.begin(), shard.seen.end(), 0);
+					shard.frontier.clear();
+					shard.next.clear();
+
+					uint32_t known = (INVALID_STRING_HANDLE != shard.key) ? 1 : 0;
+					if (!sendMessage(fd, CommandBegin, &known, sizeof(known))) {
+						return false;
+					}
+				} else if (CommandLevel == header.command) {
+					runLevel(shard, payload.data(), (size_t) (header.bytes / sizeof(NodeIndex)));
+					if (!sendMessage(fd, CommandLevel, shard.reply.data(), shard.reply.size() * sizeof(uint32_t))) {
+						return false;
+					}
+				} else {
+					return false;
+				}
+			}
+
+			return false;
+		}
+
+		/**
+		 *
+		 * Match and expand one level of a shard and build the reply
+		 *
+		 */
+		void runLevel(Shard& shard, const NodeIndex* incoming, size_t numIncoming) const {
+			shard.frontier.swap(shard.next);
+			shard.next.clear();
+
+			for (size_t i = 0; i < numIncoming; i++) {
+				if (testAndSet(shard.seen, incoming[i])) continue;
+				shard.frontier.push_back(toLocal(shard, incoming[i]));
+			}
+
+			// local indices increase with the global ones, so the lowest local match is the lowest node
+			NodeIndex match = INVALID_NODE_INDEX;
+			for (NodeIndex local : shard.frontier) {
+				if (shard.ids[local] == shard.key) {
+					match = std::min(match, local);
+				}
+			}
+
+			for (auto& outgoing : shard.outgoing) {
+				outgoing.clear();
+			}
+
+			if (INVALID_NODE_INDEX == match) {
+				for (NodeIndex local : shard.frontier) {
+					const NodeIndex* last = shard.targets.data() + shard.offsets[local + 1];
+					for (const NodeIndex* it = shard.targets.data() + shard.offsets[local]; it != last; ++it) {
+						if (testAndSet(shard.seen, *it)) continue;
+
+						size_t owner = ownerOf(*it);
+						if (owner == shard.index) {
+							shard.next.push_back(toLocal(shard, *it));
+						} else {
+							shard.outgoing[owner].push_back(*it);
+						}
+					}
+				}
+			}
+
+			shard.reply.clear();
+			shard.reply.push_back((INVALID_NODE_INDEX != match) ? shard.nodes[match] : INVALID_NODE_INDEX);
+			shard.reply.push_back((uint32_t) shard.frontier.size());
+			for (const auto& outgoing : shard.outgoing) {
+				shard.reply.push_back((uint32_t) outgoing.size());
+			}
+			for (const auto& outgoing : shard.outgoing) {
+				shard.reply.insert(shard.reply.end(), outgoing.begin(), outgoing.end());
+			}
+		}
+
+		static bool testAndSet(std::vector<uint64_t>& bitmap, NodeIndex node) {
+			uint64_t bit = (uint64_t) 1 << (node & 63);
+			uint64_t& word = bitmap[node >> 6];
+			if (word & bit) {
+				return true;
+			}
+			word |= bit;
+			return false;
+		}
+
+		/**
+		 *
+		 * Receive a message of uint32 words from a shard
+		 *
+		 */
+		static bool receiveMessage(int fd, std::vector<uint32_t>& payload) {
+			MessageHeader header;
+			if (!receiveAll(fd, &header, sizeof(header)) || 0 != header.bytes % sizeof(uint32_t)) {
+				return false;
+			}
+			payload.resize((size_t) (header.bytes / sizeof(uint32_t)));
+			return receiveAll(fd, payload.data(), (size_t) header.bytes);
+		}
+
+		static bool sendMessage(int fd, uint32_t command, const void* payload, size_t bytes) {
+			MessageHeader header;
+			header.command = command;
+			header.reserved = 0;
+			header.bytes = bytes;
+			return sendAll(fd, &header, sizeof(header)) && sendAll(fd, payload, bytes);
+		}
+
+		static bool sendAll(int fd, const void* data, size_t bytes) {
+#ifdef _WIN32
+			return false;
+#else
+			const char* pos = (const char*) data;
+			while (bytes > 0) {
+#ifdef MSG_NOSIGNAL
+				ssize_t sent = ::send(fd, pos, bytes, MSG_NOSIGNAL);
+#else
+				ssize_t sent = ::send(fd, pos, bytes, 0);
+#endif
+				if (sent < 0 && EINTR == errno) continue;
+				if (sent <= 0) return false;
+				pos += sent;
+				bytes -= (size_t) sent;
+			}
+			return true;
+#endif
+		}
+
+		static bool receiveAll(int fd, void* data, size_t bytes) {
+#ifdef _WIN32
+			return false;
+#else
+			char* pos = (char*) data;
+			while (bytes > 0) {
+				ssize_t received = ::recv(fd, pos, bytes, 0);
+				if (received < 0 && EINTR == errno) continue;
+				if (received <= 0) return false;
+				pos += received;
+				bytes -= (size_t) received;
+			}
+			return true;
+#endif
+		}
+
+	private:
+		size_t                               m_numNodes{0};
+		size_t                               m_numShards{0};
+		partition_t                          m_partition{PartitionRange};
+		bool                                 m_healthy{true};
+
+		std::mutex                           m_lock;
+		std::vector<int>                     m_sockets;
+#ifndef _WIN32
+		std::vector<pid_t>                   m_pids;
+#endif
+		std::vector<std::vector<NodeIndex>>  m_incoming;
+		std::vector<uint32_t>                m_reply;
+
+};
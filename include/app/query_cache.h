@@ -0,0 +1,258 @@
+/*
+ *
+ * Query result cache
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+
+#include <app/node.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class QueryCache;
+typedef std::shared_ptr<QueryCache> QueryCacheRef;
+
+/**
+ *
+ * Key of a cached query
+ *
+ */
+struct QueryKey {
+
+	uint64_t     graph{0};          ///< Graph identifier, see Graph::getUid()
+	uint64_t     version{0};        ///< Graph version the result was computed at
+	NodeIndex    root{0};           ///< Index of the search root
+	std::string  id;                ///< Searched identifier
+
+	bool operator==(const QueryKey& other) const {
+		return graph == other.graph && version == other.version && root == other.root && id == other.id;
+	}
+
+	uint64_t hash() const {
+		return HashIndex::hashKey(HashIndex::hashKey(id) ^ HashIndex::hashKey(graph ^ (version << 20) ^ ((uint64_t) root << 44)));
+	}
+
+};
+
+/**
+ *
+ * Query result cache
+ *
+ * This class remembers the results of find queries, found nodes as well
+ * as misses, so a repeated query skips the traversal. Keys include the
+ * graph version, so a result is never returned once the graph has been
+ * modified; entries of old versions are no longer hit and age out of the
+ * cache.
+ *
+ * The cache is split into shards selected by key hash. Every shard is a
+ * bounded LRU list guarded by its own mutex, so searches on different
+ * threads rarely wait for each other.
+ *
+ */
+class QueryCache {
+
+	public:
+		static const size_t DEFAULT_CAPACITY = 65536;	///< Entries of all shards
+		static const size_t DEFAULT_SHARDS = 16;		///< Number of shards
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param capacity Maximum number of entries, split evenly among the shards
+		 * @param numShards Number of shards
+		 *
+		 */
+		QueryCache(size_t capacity = DEFAULT_CAPACITY, size_t numShards = DEFAULT_SHARDS)
+			: m_shards(std::max((size_t) 1, std::min(numShards, std::max((size_t) 1, capacity)))) {
+			m_shardCapacity = std::max((size_t) 1, capacity / m_shards.size());
+		}
+
+		QueryCache(const QueryCache&) = delete;
+		QueryCache& operator=(const QueryCache&) = delete;
+
+	public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param capacity Maximum number of entries
+		 * @param numShards Number of shards
+		 * @return Returns a reference to the created cache
+		 *
+		 */
+		static QueryCacheRef createInstance(size_t capacity = DEFAULT_CAPACITY, size_t numShards = DEFAULT_SHARDS) {
+			return std::make_shared<QueryCache>(capacity, numShards);
+		}
+
+	public:
+		/**
+		 *
+		 * Look up a query
+		 *
+		 * @param key Key of the query
+		 * @param result Receives the cached result, INVALID_NODE_INDEX
+		 * for a cached miss
+		 * @return Returns true if the query has been cached, false otherwise.
+		 *
+		 */
+		bool lookup(const QueryKey& key, NodeIndex& result) {
+			uint64_t hash = key.hash();
+			Shard& shard = getShard(hash);
+
+			std::lock_guard<std::mutex> lock(shard.lock);
+
+			auto range = shard.index.equal_range(hash);
+			for (auto it = range.first; it != range.second; ++it) {
+				if (it->second->key == key) {
+					// move to the front of the LRU list
+					shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+					result = it->second->result;
+					m_hits.fetch_add(1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+
+			m_misses.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		/**
+		 *
+		 * Store the result of a query
+		 *
+		 * @param key Key of the query
+		 * @param result Found node, INVALID_NODE_INDEX for a miss
+		 *
+		 */
+		void insert(const QueryKey& key, NodeIndex result) {
+			uint64_t hash = key.hash();
+			Shard& shard = getShard(hash);
+
+			std::lock_guard<std::mutex> lock(shard.lock);
+
+			auto range = shard.index.equal_range(hash);
+			for (auto it = range.first; it != range.second; ++it) {
+				if (it->second->key == key) {
+					it->second->result = result;
+					shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+					return;
+				}
+			}
+
+			if (shard.entries.size() >= m_shardCapacity) {
+				evict(shard);
+			}
+
+			shard.entries.push_front(Entry{key, result, hash});
+			shard.index.emplace(hash, shard.entries.begin());
+		}
+
+		/**
+		 *
+		 * Remove all entries
+		 *
+		 */
+		void clear() {
+			for (Shard& shard : m_shards) {
+				std::lock_guard<std::mutex> lock(shard.lock);
+				shard.entries.clear();
+				shard.index.clear();
+			}
+		}
+
+		/**
+		 *
+		 * Get number of cached entries
+		 *
+		 */
+		size_t size() const {
+			size_t size = 0;
+			for (const Shard& shard : m_shards) {
+				std::lock_guard<std::mutex> lock(shard.lock);
+				size += shard.entries.size();
+			}
+			return size;
+		}
+
+		size_t capacity() const {
+			return m_shardCapacity * m_shards.size();
+		}
+
+		/**
+		 *
+		 * Get number of lookups that found a cached result
+		 *
+		 */
+		uint64_t getHits() const {
+			return m_hits.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 *
+		 * Get number of lookups that found nothing
+		 *
+		 */
+		uint64_t getMisses() const {
+			return m_misses.load(std::memory_order_relaxed);
+		}
+
+	private:
+		struct Entry {
+			QueryKey   key;
+			NodeIndex  result;
+			uint64_t   hash;
+		};
+
+		typedef std::list<Entry> EntryList;
+
+		struct Shard {
+			mutable std::mutex                                      lock;
+			EntryList                                               entries;	///< Most recently used first
+			std::unordered_multimap<uint64_t, EntryList::iterator>  index;
+		};
+
+	private:
+		Shard& getShard(uint64_t hash) {
+			// the low bits select the bucket within the shard
+			return m_shards[(hash >> 48) % m_shards.size()];
+		}
+
+		/**
+		 *
+		 * Drop the least recently used entry of a shard
+		 *
+		 */
+		static void evict(Shard& shard) {
+			EntryList::iterator last = std::prev(shard.entries.end());
+
+			auto range = shard.index.equal_range(last->hash);
+			for (auto it = range.first; it != range.second; ++it) {
+				if (it->second == last) {
+					shard.index.erase(it);
+					break;
+				}
+			}
+
+			shard.entries.erase(last);
+		}
+
+	private:
+		std::vector<Shard>       m_shards;
+		size_t                   m_shardCapacity{1};
+		std::atomic<uint64_t>    m_hits{0};
+		std::atomic<uint64_t>    m_misses{0};
+
+};
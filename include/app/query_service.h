@@ -0,0 +1,370 @@
+/*
+ *
+ * Asynchronous query service
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/threadpool.h>
+
+#include <app/bfs.h>
+#include <app/concurrent.h>
+#include <app/csr.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class QueryService;
+typedef std::shared_ptr<QueryService> QueryServiceRef;
+
+static const size_t DEFAULT_QUERY_BATCH_SIZE = 64;							///< Maximum queries per batch of a QueryService
+static const std::chrono::microseconds DEFAULT_QUERY_MAX_DELAY(200);	///< Maximum wait of a query for its batch
+
+/**
+ *
+ * Asynchronous query service
+ *
+ * Callers on any number of threads submit find queries and get a future
+ * or a completion callback back. A dispatcher thread collects the
+ * queries into micro-batches and runs every batch as one shared
+ * traversal (see BatchSearch) on a thread pool. A batch is dispatched
+ * once it holds the maximum batch size, or once its oldest query has
+ * waited for the maximum delay, so throughput grows with the load while
+ * the latency at low load stays bounded by the delay.
+ *
+ * Every batch searches the snapshot returned by the graph source at the
+ * time the batch runs, e.g. the latest published snapshot of a
+ * ConcurrentGraph. Each query gets the node that a single find() on
+ * that snapshot would return. Callbacks must not throw; a failed batch
+ * passes its exception to the futures of its unanswered queries.
+ *
+ */
+class QueryService {
+
+	public:
+		typedef std::function<CsrGraphRef(void)> Source;		///< Returns the snapshot to be searched
+		typedef std::function<void(NodeIndex)> Callback;		///< Receives the found node, INVALID_NODE_INDEX for a miss
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param source Function returning the snapshot to be searched
+		 * @param pool Thread pool running the batches, or null to run
+		 * them on the dispatcher thread
+		 *
+		 */
+		QueryService(Source source, ThreadPoolRef pool)
+			: m_source(source)
+			, m_pool(pool) {
+			m_dispatcher = std::thread([this] { dispatchLoop(); });
+		}
+
+		/**
+		 *
+		 * Destructor
+		 *
+		 * Answers all submitted queries before it returns.
+		 *
+		 */
+		~QueryService() {
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				m_stop = true;
+			}
+			m_wakeup.notify_all();
+			m_dispatcher.join();
+
+			std::unique_lock<std::mutex> lock(m_lock);
+			m_idle.wait(lock, [this] { return 0 == m_inFlight; });
+		}
+
+		QueryService(const QueryService&) = delete;
+		QueryService& operator=(const QueryService&) = delete;
+
+	public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param snapshot Snapshot to be searched
+		 * @param numThreads Number of threads running batches, zero
+		 * selects the number of hardware threads
+		 * @return Returns a reference to the created service
+		 *
+		 */
+		static QueryServiceRef createInstance(CsrGraphRef snapshot, size_t numThreads = 0) {
+			return std::make_shared<QueryService>([snapshot] { return snapshot; }, createPool(numThreads));
+		}
+
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param graph Graph whose latest snapshot is searched by every batch
+		 * @param numThreads Number of threads running batches, zero
+		 * selects the number of hardware threads
+		 * @return Returns a reference to the created service
+		 *
+		 */
+		static QueryServiceRef createInstance(ConcurrentGraphRef graph, size_t numThreads = 0) {
+			return std::make_shared<QueryService>([graph] { return graph->snapshot(); }, createPool(numThreads));
+		}
+
+	public:
+		/**
+		 *
+		 * Set batching limits
+		 *
+		 * @param batchSize Maximum number of queries per batch
+		 * @param maxDelay Maximum time a query waits for more queries
+		 * to join its batch
+		 *
+		 */
+		void setBatching(size_t batchSize, std::chrono::microseconds maxDelay) {
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				m_batchSize = std::max((size_t) 1, batchSize);
+				m_maxDelay = maxDelay;
+			}
+			m_wakeup.notify_all();
+		}
+
+		/**
+		 *
+		 * Submit a query
+		 *
+		 * @param id Identifier to be found
+		 * @return Returns a future receiving the index of the found node,
+		 * or INVALID_NODE_INDEX if no node has been found.
+		 *
+		 */
+		std::future<NodeIndex> submit(const std::string& id) {
+			Request request;
+			request.id = id;
+			std::future<NodeIndex> result = request.promise.get_future();
+			enqueue(std::move(request));
+			return result;
+		}
+
+		/**
+		 *
+		 * Submit a query with a completion callback
+		 *
+		 * @param id Identifier to be found
+		 * @param callback Function called on a pool thread with the index
+		 * of the found node, or INVALID_NODE_INDEX if no node has been
+		 * found; it must neither block nor throw
+		 *
+		 */
+		void submit(const std::string& id, Callback callback) {
+			Request request;
+			request.id = id;
+			request.callback = callback;
+			enqueue(std::move(request));
+		}
+
+		/**
+		 *
+		 * Get number of dispatched batches
+		 *
+		 */
+		uint64_t getNumBatches() const {
+			std::lock_guard<std::mutex> lock(m_lock);
+			return m_numBatches;
+		}
+
+		/**
+		 *
+		 * Get number of dispatched queries
+		 *
+		 */
+		uint64_t getNumQueries() const {
+			std::lock_guard<std::mutex> lock(m_lock);
+			return m_numQueries;
+		}
+
+	private:
+		typedef std::chrono::steady_clock Clock;
+
+		struct Request {
+			std::string              id;
+			std::promise<NodeIndex>  promise;
+			Callback                 callback;
+			Clock::time_point        submitted;
+		};
+
+		typedef std::vector<Request> Batch;
+
+	private:
+		static ThreadPoolRef createPool(size_t numThreads) {
+			// the dispatcher does not take part in the batches, so every thread is a worker
+			if (0 == numThreads) {
+				numThreads = std::max(1u, std::thread::hardware_concurrency());
+			}
+			return ThreadPool::createInstance(numThreads + 1);
+		}
+
+		void enqueue(Request&& request) {
+			size_t pending = 0;
+			size_t batchSize = 0;
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				request.submitted = Clock::now();
+				m_pending.push_back(std::move(request));
+				pending = m_pending.size();
+				batchSize = m_batchSize;
+			}
+
+			// the dispatcher waits for the first query of a batch or for a full batch
+			if (1 == pending || pending >= batchSize) {
+				m_wakeup.notify_one();
+			}
+		}
+
+		/**
+		 *
+		 * Cut the pending queries into batches and hand them to the pool
+		 *
+		 */
+		void dispatchLoop() {
+			std::unique_lock<std::mutex> lock(m_lock);
+
+			while (true) {
+				if (m_pending.empty()) {
+					if (m_stop) break;
+					m_wakeup.wait(lock);
+					continue;
+				}
+
+				Clock::time_point deadline = m_pending.front().submitted + m_maxDelay;
+				if (!m_stop && m_pending.size() < m_batchSize && Clock::now() < deadline) {
+					m_wakeup.wait_until(lock, deadline);
+					continue;
+				}
+
+				size_t size = std::min(m_batchSize, m_pending.size());
+				auto batch = std::make_shared<Batch>();
+				batch->reserve(size);
+				for (size_t i = 0; i < size; i++) {
+					batch->push_back(std::move(m_pending.front()));
+					m_pending.pop_front();
+				}
+
+				m_inFlight++;
+				m_numBatches++;
+				m_numQueries += size;
+
+				lock.unlock();
+				if (nullptr != m_pool) {
+					m_pool->submit([this, batch] { run(*batch); });
+				} else {
+					run(*batch);
+				}
+				lock.lock();
+			}
+		}
+
+		/**
+		 *
+		 * Answer a batch with one traversal
+		 *
+		 * If the source, the search or a callback throws, the futures of
+		 * the unanswered queries receive the exception and the remaining
+		 * callbacks are skipped, so callbacks must not throw.
+		 *
+		 */
+		void run(Batch& batch) {
+			size_t answered = 0;
+
+			try {
+				std::vector<std::string> ids;
+				ids.reserve(batch.size());
+				for (const Request& request : batch) {
+					ids.push_back(request.id);
+				}
+
+				CsrGraphRef snapshot = m_source();
+
+				std::unique_ptr<BreadthFirstSearch> bfs = acquireSearch();
+				std::vector<NodeIndex> results = bfs->findMany(snapshot, ids);
+				releaseSearch(std::move(bfs));
+
+				for (; answered < batch.size(); answered++) {
+					Request& request = batch[answered];
+					if (request.callback) {
+						request.callback(results[answered]);
+					} else {
+						request.promise.set_value(results[answered]);
+					}
+				}
+			} catch (...) {
+				LOG_ERRORF("query batch aborted after %zu of %zu queries", answered, batch.size());
+
+				std::exception_ptr error = std::current_exception();
+				for (size_t i = answered; i < batch.size(); i++) {
+					if (!batch[i].callback) {
+						batch[i].promise.set_exception(error);
+					}
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(m_lock);
+			if (0 == --m_inFlight) {
+				m_idle.notify_all();
+			}
+		}
+
+		/**
+		 *
+		 * Take a search instance from the free list, searches keep their buffers between batches
+		 *
+		 */
+		std::unique_ptr<BreadthFirstSearch> acquireSearch() {
+			std::lock_guard<std::mutex> lock(m_searchLock);
+			if (m_searches.empty()) {
+				return std::make_unique<BreadthFirstSearch>();
+			}
+			std::unique_ptr<BreadthFirstSearch> bfs = std::move(m_searches.back());
+			m_searches.pop_back();
+			return bfs;
+		}
+
+		void releaseSearch(std::unique_ptr<BreadthFirstSearch> bfs) {
+			std::lock_guard<std::mutex> lock(m_searchLock);
+			m_searches.push_back(std::move(bfs));
+		}
+
+	private:
+		Source                                              m_source;
+		ThreadPoolRef                                       m_pool;
+
+		mutable std::mutex                                  m_lock;
+		std::condition_variable                             m_wakeup;
+		std::condition_variable                             m_idle;
+		std::deque<Request>                                 m_pending;
+		size_t                                              m_batchSize{DEFAULT_QUERY_BATCH_SIZE};
+		std::chrono::microseconds                           m_maxDelay{DEFAULT_QUERY_MAX_DELAY};
+		size_t                                              m_inFlight{0};
+		uint64_t                                            m_numBatches{0};
+		uint64_t                                            m_numQueries{0};
+		bool                                                m_stop{false};
+
+		std::mutex                                          m_searchLock;
+		std::vector<std::unique_ptr<BreadthFirstSearch>>    m_searches;
+
+		std::thread                                         m_dispatcher;
+
+};
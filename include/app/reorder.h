@@ -0,0 +1,296 @@
+/*
+ *
+ * Node reordering
+ *
+ */
+
+#pragma once
+
+#include <app/csr.h>
+#include <app/graph.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ *
+ * Node reordering
+ *
+ * This class relabels the nodes of a graph so that nodes visited close
+ * together in time also sit close together in memory. Node indices
+ * otherwise follow insertion order, and a traversal jumps across the
+ * offset, target and identifier arrays.
+ *
+ *     BFS      nodes in the order a top-down search from the root visits them
+ *     RCM      Reverse Cuthill-McKee, which narrows the band of the
+ *              adjacency matrix so that neighbors get nearby indices
+ *     Degree   nodes by decreasing degree, so hubs share cache lines
+ *
+ * The root keeps index 0 in every order, because searches start there.
+ * Nodes not reachable from the root are appended component by component.
+ * Neighbor lists keep their order, so a top-down search visits the same
+ * nodes in the same sequence and returns the same match as on the
+ * original graph. Identifiers move with their nodes and the id index is
+ * rebuilt, so lookups by identifier work unchanged; only lookups of
+ * duplicate identifiers may pick a different node.
+ *
+ * The permutation of the last apply() is kept to translate indices
+ * between the reordered and the original graph.
+ *
+ */
+class NodeReordering {
+
+	public:
+		/**
+		 *
+		 * Node order
+		 *
+		 */
+		typedef enum {
+			OrderBfs = 0,       ///< Top-down BFS order from the root
+			OrderRcm = 1,       ///< Reverse Cuthill-McKee order
+			OrderDegree = 2     ///< Decreasing degree
+		} order_t;
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param order Order applied by apply()
+		 *
+		 */
+		NodeReordering(order_t order = OrderBfs)
+			: m_order(order) {
+		}
+
+	public:
+		void setOrder(order_t order) {
+			m_order = order;
+		}
+
+		order_t getOrder() const {
+			return m_order;
+		}
+
+		/**
+		 *
+		 * Reorder a CSR snapshot
+		 *
+		 * @param graph Snapshot to be reordered
+		 * @return Returns a new snapshot with relabeled nodes.
+		 *
+		 */
+		CsrGraphRef apply(const CsrGraph& graph) {
+			size_t numNodes = graph.size();
+
+			computeOrder(graph);
+
+			m_toReordered.assign(numNodes, INVALID_NODE_INDEX);
+			for (size_t node = 0; node < numNodes; node++) {
+				m_toReordered[m_toOriginal[node]] = (NodeIndex) node;
+			}
+
+			std::vector<uint64_t> offsets(numNodes + 1, 0);
+			std::vector<NodeIndex> targets;
+			std::vector<StringHandle> ids(numNodes);
+			targets.reserve(graph.numTargets());
+
+			for (size_t node = 0; node < numNodes; node++) {
+				NodeIndex original = m_toOriginal[node];
+				for (const NodeIndex* it = graph.neighborsBegin(original); it != graph.neighborsEnd(original); ++it) {
+					targets.push_back(m_toReordered[*it]);
+				}
+				offsets[node + 1] = targets.size();
+				ids[node] = graph.getIdHandle(original);
+			}
+
+			// handles stay valid, the identifier bytes are copied as they are
+			std::vector<char> idData(graph.idData(), graph.idData() + graph.idBytes());
+
+			return CsrGraph::createInstance(std::move(offsets), std::move(targets), std::move(idData), std::move(ids));
+		}
+
+		/**
+		 *
+		 * Reorder a graph
+		 *
+		 * Nodes of the returned graph are allocated in the new order. The
+		 * id index is enabled if it is enabled on the given graph.
+		 *
+		 * @param graph Graph to be reordered
+		 * @return Returns a new graph with relabeled nodes, or null if
+		 * the given graph is null.
+		 *
+		 */
+		GraphRef apply(GraphRef graph) {
+			if (nullptr == graph) {
+				return nullptr;
+			}
+
+			GraphRef reordered = Graph::createInstance(*apply(*graph->freeze()));
+			reordered->enableIdIndex(graph->hasIdIndex());
+			return reordered;
+		}
+
+		/**
+		 *
+		 * Translate a reordered node index to the original one
+		 *
+		 * @param node Index of a node of the graph returned by the last apply()
+		 * @return Returns the index of the node in the original graph.
+		 *
+		 */
+		NodeIndex toOriginal(NodeIndex node) const {
+			return m_toOriginal[node];
+		}
+
+		/**
+		 *
+		 * Translate an original node index to the reordered one
+		 *
+		 * @param node Index of a node of the graph passed to the last apply()
+		 * @return Returns the index of the node in the reordered graph.
+		 *
+		 */
+		NodeIndex toReordered(NodeIndex node) const {
+			return m_toReordered[node];
+		}
+
+	private:
+		/**
+		 *
+		 * Fill m_toOriginal with the original index of every new position
+		 *
+		 */
+		void computeOrder(const CsrGraph& graph) {
+			size_t numNodes = graph.size();
+
+			m_toOriginal.clear();
+			m_toOriginal.reserve(numNodes);
+			m_visited.assign(numNodes, 0);
+			m_level.assign((OrderRcm == m_order) ? numNodes : 0, UINT32_MAX);
+
+			if (OrderDegree == m_order) {
+				for (size_t node = 0; node < numNodes; node++) {
+					m_toOriginal.push_back((NodeIndex) node);
+				}
+				std::stable_sort(m_toOriginal.begin(), m_toOriginal.end(), [&graph](NodeIndex a, NodeIndex b) {
+					return graph.degree(a) > graph.degree(b);
+				});
+			} else {
+				for (size_t node = 0; node < numNodes; node++) {
+					if (m_visited[node]) continue;
+
+					size_t begin = m_toOriginal.size();
+					if (OrderBfs == m_order) {
+						traverse(graph, (NodeIndex) node, false);
+					} else {
+						traverse(graph, peripheralNode(graph, (NodeIndex) node), true);
+					}
+
+					if (OrderRcm == m_order) {
+						std::reverse(m_toOriginal.begin() + begin, m_toOriginal.end());
+					}
+				}
+			}
+
+			// searches start at node 0, so the root stays in front
+			auto root = std::find(m_toOriginal.begin(), m_toOriginal.end(), (NodeIndex) 0);
+			if (root != m_toOriginal.end()) {
+				std::rotate(m_toOriginal.begin(), root, root + 1);
+			}
+		}
+
+		/**
+		 *
+		 * Append the component of a start node in BFS order
+		 *
+		 * @param byDegree Visit the unvisited neighbors of a node by
+		 * increasing degree (Cuthill-McKee) instead of adjacency order
+		 *
+		 */
+		void traverse(const CsrGraph& graph, NodeIndex start, bool byDegree) {
+			size_t head = m_toOriginal.size();
+
+			m_visited[start] = 1;
+			m_toOriginal.push_back(start);
+
+			for (; head < m_toOriginal.size(); head++) {
+				NodeIndex node = m_toOriginal[head];
+				size_t first = m_toOriginal.size();
+
+				for (const NodeIndex* it = graph.neighborsBegin(node); it != graph.neighborsEnd(node); ++it) {
+					if (m_visited[*it]) continue;
+					m_visited[*it] = 1;
+					m_toOriginal.push_back(*it);
+				}
+
+				if (byDegree) {
+					std::stable_sort(m_toOriginal.begin() + first, m_toOriginal.end(), [&graph](NodeIndex a, NodeIndex b) {
+						return graph.degree(a) < graph.degree(b);
+					});
+				}
+			}
+		}
+
+		/**
+		 *
+		 * Find a pseudo-peripheral node of a component (George-Liu)
+		 *
+		 * Starting at a given node, repeatedly moves to a node of lowest
+		 * degree on the last BFS level while the eccentricity grows.
+		 *
+		 */
+		NodeIndex peripheralNode(const CsrGraph& graph, NodeIndex start) {
+			static const int MAX_ROUNDS = 4;
+
+			uint32_t eccentricity = 0;
+
+			for (int round = 0; round < MAX_ROUNDS; round++) {
+				m_queue.assign(1, start);
+				m_level[start] = 0;
+
+				for (size_t head = 0; head < m_queue.size(); head++) {
+					NodeIndex node = m_queue[head];
+					for (const NodeIndex* it = graph.neighborsBegin(node); it != graph.neighborsEnd(node); ++it) {
+						if (UINT32_MAX != m_level[*it]) continue;
+						m_level[*it] = m_level[node] + 1;
+						m_queue.push_back(*it);
+					}
+				}
+
+				uint32_t depth = m_level[m_queue.back()];
+				NodeIndex candidate = m_queue.back();
+				for (auto it = m_queue.rbegin(); it != m_queue.rend() && m_level[*it] == depth; ++it) {
+					if (graph.degree(*it) < graph.degree(candidate)) {
+						candidate = *it;
+					}
+				}
+
+				// only the component has been touched, so resetting it is enough
+				for (NodeIndex node : m_queue) {
+					m_level[node] = UINT32_MAX;
+				}
+
+				if (round > 0 && depth <= eccentricity) {
+					break;
+				}
+				eccentricity = depth;
+				start = candidate;
+			}
+
+			return start;
+		}
+
+	private:
+		order_t                  m_order;
+		std::vector<NodeIndex>   m_toOriginal;
+		std::vector<NodeIndex>   m_toReordered;
+		std::vector<uint8_t>     m_visited;
+		std::vector<uint32_t>    m_level;
+		std::vector<NodeIndex>   m_queue;
+
+};
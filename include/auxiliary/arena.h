@@ -0,0 +1,258 @@
+/**
+ *
+ * Arena Allocator
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ *
+ * Arena
+ *
+ * This class hands out memory from large blocks by bumping a pointer.
+ * Objects created in the arena are never destroyed one by one; all
+ * blocks are released together when the arena is destroyed, so only
+ * trivially destructible objects should be placed here.
+ *
+ * Growing arrays (see ArenaArray) allocate power-of-two size classes and
+ * hand outgrown blocks back to a per-class free list, so repeated growth
+ * reuses memory instead of leaking it into the arena.
+ *
+ */
+class Arena {
+
+	public:
+		static const size_t DEFAULT_BLOCK_SIZE = 256 * 1024;	///< Size of the blocks requested from the system
+		static const size_t MIN_CLASS_SIZE = 32;				///< Smallest size class in bytes
+		static const size_t NUM_CLASSES = 32;					///< Number of size classes
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param blockSize Size of the blocks requested from the system
+		 *
+		 */
+		explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE)
+			: m_blockSize(blockSize) {
+			for (size_t i = 0; i < NUM_CLASSES; i++) {
+				m_freeLists[i] = nullptr;
+			}
+		}
+
+		~Arena() {
+			for (void* block : m_blocks) {
+				std::free(block);
+			}
+		}
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+	public:
+		/**
+		 *
+		 * Allocate memory
+		 *
+		 * @param bytes Number of bytes
+		 * @param align Alignment, must be a power of two
+		 * @return Returns a pointer to uninitialized memory owned by the arena.
+		 *
+		 */
+		void* allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+			uintptr_t pos = (m_pos + (align - 1)) & ~(uintptr_t) (align - 1);
+
+			if (pos + bytes > m_end) {
+				if (bytes + align > m_blockSize / 4) {
+					// large requests get a block of their own, the current block stays in use
+					return alignUp(newBlock(bytes + align), align);
+				}
+
+				m_pos = (uintptr_t) newBlock(m_blockSize);
+				m_end = m_pos + m_blockSize;
+				pos = (m_pos + (align - 1)) & ~(uintptr_t) (align - 1);
+			}
+
+			m_pos = pos + bytes;
+			return (void*) pos;
+		}
+
+		/**
+		 *
+		 * Create an object in the arena
+		 *
+		 * @param args Constructor arguments
+		 * @return Returns a pointer to the created object.
+		 *
+		 */
+		template <typename T, typename... Args>
+		T* create(Args&&... args) {
+			return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		}
+
+		/**
+		 *
+		 * Allocate a block of a size class
+		 *
+		 * @param sizeClass Size class, the block holds MIN_CLASS_SIZE << sizeClass bytes
+		 * @return Returns a pointer to uninitialized memory owned by the arena.
+		 *
+		 */
+		void* allocateClass(size_t sizeClass) {
+			void* block = m_freeLists[sizeClass];
+			if (nullptr != block) {
+				std::memcpy(&m_freeLists[sizeClass], block, sizeof(void*));
+				return block;
+			}
+			return allocate(MIN_CLASS_SIZE << sizeClass, MIN_CLASS_SIZE);
+		}
+
+		/**
+		 *
+		 * Return a block of a size class for reuse
+		 *
+		 * @param block Block returned by allocateClass()
+		 * @param sizeClass Size class the block has been allocated with
+		 *
+		 */
+		void releaseClass(void* block, size_t sizeClass) {
+			std::memcpy(block, &m_freeLists[sizeClass], sizeof(void*));
+			m_freeLists[sizeClass] = block;
+		}
+
+		/**
+		 *
+		 * Get number of bytes requested from the system
+		 *
+		 */
+		size_t reservedBytes() const {
+			return m_reserved;
+		}
+
+	private:
+		void* newBlock(size_t bytes) {
+			void* block = std::malloc(bytes);
+			if (nullptr == block) {
+				throw std::bad_alloc();
+			}
+			m_blocks.push_back(block);
+			m_reserved += bytes;
+			return block;
+		}
+
+		static void* alignUp(void* ptr, size_t align) {
+			return (void*) (((uintptr_t) ptr + (align - 1)) & ~(uintptr_t) (align - 1));
+		}
+
+	private:
+		size_t              m_blockSize;
+		uintptr_t           m_pos{0};
+		uintptr_t           m_end{0};
+		size_t              m_reserved{0};
+		std::vector<void*>  m_blocks;
+		void*               m_freeLists[NUM_CLASSES];
+
+};
+
+/**
+ *
+ * Arena array
+ *
+ * A minimal growable array of trivially copyable elements whose storage
+ * lives in an arena. It has no destructor: the storage goes away with
+ * the arena.
+ *
+ */
+template <typename T>
+class ArenaArray {
+
+	public:
+		typedef const T* const_iterator;
+
+	public:
+		/**
+		 *
+		 * Append an element
+		 *
+		 * @param value Element to be appended
+		 * @param arena Arena providing the storage, must be the same for all calls
+		 *
+		 */
+		void push_back(const T& value, Arena& arena) {
+			if (m_size == m_capacity) {
+				grow(arena);
+			}
+			m_data[m_size++] = value;
+		}
+
+		size_t size() const {
+			return m_size;
+		}
+
+		bool empty() const {
+			return 0 == m_size;
+		}
+
+		const T& operator[](size_t index) const {
+			return m_data[index];
+		}
+
+		const T* data() const {
+			return m_data;
+		}
+
+		const_iterator begin() const {
+			return m_data;
+		}
+
+		const_iterator end() const {
+			return m_data + m_size;
+		}
+
+	private:
+		static_assert(sizeof(T) <= Arena::MIN_CLASS_SIZE, "element too large for the smallest size class");
+
+		/**
+		 *
+		 * Get the smallest size class holding a number of bytes
+		 *
+		 */
+		static size_t classFor(size_t bytes) {
+			size_t sizeClass = 0;
+			while ((Arena::MIN_CLASS_SIZE << sizeClass) < bytes) {
+				sizeClass++;
+			}
+			return sizeClass;
+		}
+
+		void grow(Arena& arena) {
+			size_t sizeClass = (0 == m_capacity)
+				? classFor(sizeof(T))
+				: classFor(m_capacity * sizeof(T)) + 1;
+
+			T* data = (T*) arena.allocateClass(sizeClass);
+			if (0 != m_capacity) {
+				std::memcpy(data, m_data, m_size * sizeof(T));
+				arena.releaseClass(m_data, classFor(m_capacity * sizeof(T)));
+			}
+
+			m_data = data;
+			m_capacity = (uint32_t) ((Arena::MIN_CLASS_SIZE << sizeClass) / sizeof(T));
+		}
+
+	private:
+		T*          m_data{nullptr};
+		uint32_t    m_size{0};
+		uint32_t    m_capacity{0};
+
+};
@@ -0,0 +1,178 @@
+/**
+ *
+ * Epoch Based Reclamation
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ *
+ * Epoch domain
+ *
+ * Read-copy-update support: readers announce the global epoch in a slot
+ * while they dereference shared data, writers retire replaced objects
+ * tagged with the epoch they were unlinked in, and free them once no
+ * reader can still see them. Readers never take a lock and never wait
+ * for a writer; a writer never waits for readers either, it just keeps
+ * retired objects until a later reclaim() finds them unreachable.
+ *
+ * Readers claim one of MAX_READERS slots per critical section, starting
+ * at a per-thread position, so threads rarely touch the same slot. Only
+ * if more readers than slots are inside a critical section at the same
+ * time does a reader spin until a slot becomes free.
+ *
+ * retire() and reclaim() must be serialized by the caller, e.g. by the
+ * lock of the single writer.
+ *
+ */
+class EpochDomain {
+
+	public:
+		static const size_t MAX_READERS = 128;	///< Readers inside a critical section at the same time
+
+	public:
+		/**
+		 *
+		 * Reader critical section
+		 *
+		 * Objects loaded from shared pointers of the domain stay valid
+		 * while the guard is alive. Keep the section short, it delays
+		 * reclamation of every object retired meanwhile.
+		 *
+		 */
+		class Guard {
+
+			public:
+				explicit Guard(EpochDomain& domain)
+					: m_slot(domain.enter()) {
+				}
+
+				~Guard() {
+					m_slot->store(IDLE, std::memory_order_release);
+				}
+
+				Guard(const Guard&) = delete;
+				Guard& operator=(const Guard&) = delete;
+
+			private:
+				std::atomic<uint64_t>*  m_slot;
+
+		};
+
+	public:
+		EpochDomain() = default;
+
+		~EpochDomain() {
+			// no reader may be left, everything retired is unreachable
+			for (Retired& retired : m_retired) {
+				retired.deleter();
+			}
+		}
+
+		EpochDomain(const EpochDomain&) = delete;
+		EpochDomain& operator=(const EpochDomain&) = delete;
+
+	public:
+		/**
+		 *
+		 * Retire an object that has been unlinked from shared data
+		 *
+		 * @param object Object to be deleted once no reader sees it
+		 *
+		 */
+		template <typename T>
+		void retire(T* object) {
+			uint64_t epoch = m_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+			m_retired.push_back(Retired{epoch, [object] { delete object; }});
+		}
+
+		/**
+		 *
+		 * Delete the retired objects no reader can see anymore
+		 *
+		 * @return Returns the number of deleted objects.
+		 *
+		 */
+		size_t reclaim() {
+			uint64_t oldest = UINT64_MAX;
+			for (Slot& slot : m_slots) {
+				uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+				if (IDLE != epoch && epoch < oldest) {
+					oldest = epoch;
+				}
+			}
+
+			// readers that entered at or after the retire epoch loaded the replacement
+			size_t kept = 0;
+			size_t deleted = 0;
+			for (size_t i = 0; i < m_retired.size(); i++) {
+				if (m_retired[i].epoch <= oldest) {
+					m_retired[i].deleter();
+					deleted++;
+				} else {
+					m_retired[kept++] = std::move(m_retired[i]);
+				}
+			}
+			m_retired.resize(kept);
+
+			return deleted;
+		}
+
+		/**
+		 *
+		 * Get number of retired objects waiting for reclamation
+		 *
+		 */
+		size_t numRetired() const {
+			return m_retired.size();
+		}
+
+	private:
+		static const uint64_t IDLE = 0;	///< Slot value outside of a critical section
+
+		// padded to a cache line, so readers do not share slot lines
+		struct Slot {
+			std::atomic<uint64_t>  epoch{IDLE};
+			char                   padding[64 - sizeof(std::atomic<uint64_t>)];
+		};
+
+		struct Retired {
+			uint64_t               epoch;
+			std::function<void()>  deleter;
+		};
+
+	private:
+		/**
+		 *
+		 * Claim a slot and announce the current epoch in it
+		 *
+		 */
+		std::atomic<uint64_t>* enter() {
+			for (size_t pos = threadHint(); ; pos++) {
+				Slot& slot = m_slots[pos % MAX_READERS];
+				uint64_t expected = IDLE;
+				if (slot.epoch.load(std::memory_order_relaxed) == IDLE &&
+					slot.epoch.compare_exchange_strong(expected, m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst)) {
+					return &slot.epoch;
+				}
+			}
+		}
+
+		static size_t threadHint() {
+			static std::atomic<size_t> next{0};
+			thread_local size_t hint = next.fetch_add(1, std::memory_order_relaxed);
+			return hint;
+		}
+
+	private:
+		std::atomic<uint64_t>   m_epoch{1};
+		Slot                    m_slots[MAX_READERS];
+		std::vector<Retired>    m_retired;
+
+};
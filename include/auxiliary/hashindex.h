@@ -0,0 +1,254 @@
+/**
+ *
+ * Open-Addressing Hash Index
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ *
+ * Hash index
+ *
+ * This class maps hashed keys to 32-bit values with open addressing and
+ * linear probing. Keys are not stored in the table: every slot holds a
+ * 32-bit hash of the key and the value, and callers pass a predicate
+ * that compares the searched key with the key behind a value. This keeps
+ * the table at 8 bytes per slot and lets it index keys that live
+ * elsewhere, e.g. node identifiers of a graph.
+ *
+ */
+class HashIndex {
+
+	public:
+		static const uint32_t NOT_FOUND = UINT32_MAX;	///< Value marking an empty slot / missing key
+
+		struct Slot {
+			uint32_t tag;
+			uint32_t value;
+		};
+
+	public:
+		HashIndex() {
+			clear();
+		}
+
+	public:
+		/**
+		 *
+		 * Hash a key
+		 *
+		 * @param data Pointer to the key bytes
+		 * @param length Number of key bytes
+		 * @return Returns a 64-bit FNV-1a hash of the key.
+		 *
+		 */
+		static uint64_t hashKey(const char* data, size_t length) {
+			uint64_t hash = 14695981039346656037ULL;
+			for (size_t i = 0; i < length; i++) {
+				hash ^= (uint8_t) data[i];
+				hash *= 1099511628211ULL;
+			}
+			return hash;
+		}
+
+		static uint64_t hashKey(const std::string& key) {
+			return hashKey(key.data(), key.size());
+		}
+
+		/**
+		 *
+		 * Hash an integer key
+		 *
+		 * @param key Key to be hashed
+		 * @return Returns a 64-bit hash of the key (splitmix64 finalizer).
+		 *
+		 */
+		static uint64_t hashKey(uint64_t key) {
+			key ^= key >> 30;
+			key *= 0xbf58476d1ce4e5b9ULL;
+			key ^= key >> 27;
+			key *= 0x94d049bb133111ebULL;
+			key ^= key >> 31;
+			return key;
+		}
+
+		/**
+		 *
+		 * Clear index
+		 *
+		 */
+		void clear() {
+			m_slots.assign(MIN_CAPACITY, Slot{0, NOT_FOUND});
+			m_size = 0;
+		}
+
+		/**
+		 *
+		 * Get number of entries
+		 *
+		 * @return Returns the number of stored values.
+		 *
+		 */
+		size_t size() const {
+			return m_size;
+		}
+
+		/**
+		 *
+		 * Reserve space
+		 *
+		 * @param numEntries Number of entries the index shall hold
+		 * without growing
+		 *
+		 */
+		void reserve(size_t numEntries) {
+			size_t capacity = MIN_CAPACITY;
+			while (capacity * MAX_LOAD_PERCENT < numEntries * 100) {
+				capacity *= 2;
+			}
+			if (capacity > m_slots.size()) {
+				rehash(capacity);
+			}
+		}
+
+		/**
+		 *
+		 * Find a key
+		 *
+		 * @param hash Hash of the key, see hashKey()
+		 * @param equals Predicate called with a candidate value, returns
+		 * true if the key behind the value equals the searched key
+		 * @return Returns the value stored for the key, or NOT_FOUND.
+		 *
+		 */
+		template <typename Equals>
+		uint32_t find(uint64_t hash, const Equals& equals) const {
+			return find(m_slots.data(), m_slots.size(), hash, equals);
+		}
+
+		/**
+		 *
+		 * Find a key in a raw slot table
+		 *
+		 * Searches a table laid out like the one of an index, e.g. one
+		 * that has been written to a file with slots() and capacity().
+		 *
+		 * @param slots Slot table
+		 * @param capacity Number of slots, a power of two
+		 * @param hash Hash of the key, see hashKey()
+		 * @param equals Predicate as for find()
+		 * @return Returns the value stored for the key, or NOT_FOUND.
+		 *
+		 */
+		template <typename Equals>
+		static uint32_t find(const Slot* slots, size_t capacity, uint64_t hash, const Equals& equals) {
+			size_t mask = capacity - 1;
+			uint32_t tag = toTag(hash);
+
+			for (size_t pos = tag & mask; ; pos = (pos + 1) & mask) {
+				const Slot& slot = slots[pos];
+				if (NOT_FOUND == slot.value) {
+					return NOT_FOUND;
+				}
+				if (slot.tag == tag && equals(slot.value)) {
+					return slot.value;
+				}
+			}
+		}
+
+		/**
+		 *
+		 * Get slot table
+		 *
+		 * @return Returns a pointer to capacity() slots, valid until the
+		 * index is modified.
+		 *
+		 */
+		const Slot* slots() const {
+			return m_slots.data();
+		}
+
+		size_t capacity() const {
+			return m_slots.size();
+		}
+
+		/**
+		 *
+		 * Insert a key
+		 *
+		 * @param hash Hash of the key, see hashKey()
+		 * @param value Value to be stored, must not be NOT_FOUND
+		 * @param equals Predicate as for find()
+		 * @return Returns true if the value has been inserted, false if
+		 * the key is already present (the stored value is kept).
+		 *
+		 */
+		template <typename Equals>
+		bool insert(uint64_t hash, uint32_t value, const Equals& equals) {
+			if ((m_size + 1) * 100 > m_slots.size() * MAX_LOAD_PERCENT) {
+				rehash(m_slots.size() * 2);
+			}
+
+			size_t mask = m_slots.size() - 1;
+			uint32_t tag = toTag(hash);
+
+			for (size_t pos = tag & mask; ; pos = (pos + 1) & mask) {
+				Slot& slot = m_slots[pos];
+				if (NOT_FOUND == slot.value) {
+					slot.tag = tag;
+					slot.value = value;
+					m_size++;
+					return true;
+				}
+				if (slot.tag == tag && equals(slot.value)) {
+					return false;
+				}
+			}
+		}
+
+	private:
+		static const size_t MIN_CAPACITY = 16;
+		static const size_t MAX_LOAD_PERCENT = 70;
+
+		/**
+		 *
+		 * Fold a key hash into the 32-bit tag that also selects the home slot
+		 *
+		 */
+		static uint32_t toTag(uint64_t hash) {
+			return (uint32_t) (hash ^ (hash >> 32));
+		}
+
+		/**
+		 *
+		 * Grow the table. The home slot only depends on the stored tag,
+		 * so entries move without touching the keys.
+		 *
+		 */
+		void rehash(size_t capacity) {
+			std::vector<Slot> old(capacity, Slot{0, NOT_FOUND});
+			old.swap(m_slots);
+
+			size_t mask = capacity - 1;
+
+			for (const Slot& slot : old) {
+				if (NOT_FOUND == slot.value) continue;
+
+				size_t pos = slot.tag & mask;
+				while (NOT_FOUND != m_slots[pos].value) {
+					pos = (pos + 1) & mask;
+				}
+				m_slots[pos] = slot;
+			}
+		}
+
+	private:
+		std::vector<Slot>   m_slots;
+		size_t              m_size{0};
+
+};
@@ -1,168 +1,527 @@
-/**
- *
- * Minimalistic Logging Framework
- *
- */
-
-#pragma once
-
-#include <string>
-#include <stdio.h>
-#include <stdarg.h>  
-
-static const int MAX_LOG_BUFFER = 4096;
-static thread_local char __logbuffer[MAX_LOG_BUFFER];
-
-class Log
-{
-    public:
-        typedef enum {
-            LevelDebug = -1,
-            LevelInfo = 0,
-            LevelWarn = 1,
-            LevelError = 2,
-            LevelTest = 3
-        } loglevel_t;
-
-    private:
-        static loglevel_t currentLogLevel;
-
-    public:
-        static void setLogLevel(loglevel_t logLevel) {
-            currentLogLevel = logLevel;
-        }
-
-        static loglevel_t getLogLevel() {
-            return currentLogLevel;
-        }
-
-    public:
-        static void log(int level, const char* str) {
-            write(level, str);
-        }
-
-        static void log(int level, const std::string& str) {
-            write(level, str.c_str());
-        }
-
-        static void logf(int level, const char* format, ...) {
-            va_list args; va_start(args, format);
-            writef(level, format, args);
-            va_end(args);
-        }
-
-    public:
-        static void debug(const char* str) {
-            write(LevelDebug, str);
-        }
-
-        static void debug(const std::string& str) {
-            write(LevelDebug, str.c_str());
-        }
-
-        static void debugf(const char* format, ...) {
-            if (currentLogLevel > LevelDebug) return;
-            va_list args; va_start(args, format);
-            writef(LevelDebug, format, args);
-            va_end(args);
-        }
-
-        static void info(const char* str) {
-            write(LevelInfo, str);
-        }
-
-        static void info(const std::string& str) {
-            write(LevelInfo, str.c_str());
-        }
-
-        static void infof(const char* format, ...) {
-            if (currentLogLevel > LevelInfo) return;
-            va_list args; va_start(args, format);
-            writef(LevelInfo, format, args);
-            va_end(args);
-        }
-
-        static void warn(const char* str) {
-            write(LevelWarn, str);
-        }
-
-        static void warn(const std::string& str) {
-            write(LevelWarn, str.c_str());
-        }
-
-        static void warnf(const char* format, ...) {
-            if (currentLogLevel > LevelWarn) return;
-            va_list args; va_start(args, format);
-            writef(LevelWarn, format, args);
-            va_end(args);
-        }
-
-        static void error(const char* str) {
-            write(LevelError, str);
-        }
-
-        static void error(const std::string& str) {
-            write(LevelError, str.c_str());
-        }
-
-        static void errorf(const char* format, ...) {
-            if (currentLogLevel > LevelError) return;
-            va_list args; va_start(args, format);
-            writef(LevelError, format, args);
-            va_end(args);
-        }
-
-        static void test(const char* str) {
-            write(LevelTest, str);
-        }
-
-        static void test(const std::string& str) {
-            write(LevelTest, str.c_str());
-        }
-
-        static void testf(const char* format, ...) {
-            if (currentLogLevel > LevelTest) return;
-            va_list args; va_start(args, format);
-            writef(LevelTest, format, args);
-            va_end(args);
-        }
-
-    private:
-        static void write(int level, const char* str) {
-            if (level < (int)currentLogLevel) return;
-
-            switch (level) {
-                case LevelDebug:
-                    printf("[DEBUG] %s\n", str);
-                    break;
-
-                case LevelInfo:
-                    printf("[INFO]  %s\n", str);
-                    break;
-
-                case LevelWarn:
-                    printf("[WARN]  %s\n", str);
-                    break;
-
-                case LevelError:
-                    printf("[ERROR] %s\n", str);
-                    break;
-
-                case LevelTest:
-                    printf("[TEST] %s\n", str);
-                    break;
-
-                default:
-                    break;
-            }
-        }
-
-        static void writef(int level, const char* format, va_list args) {
-            if (level < (int)currentLogLevel) return;
-            vsprintf(__logbuffer, format, args);
-            write(level, __logbuffer);
-        }
-
-};
-
-Log::loglevel_t Log::currentLogLevel = Log::LevelDebug;
+/**
+ *
+ * Minimalistic Logging Framework
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <stdio.h>
+#include <stdarg.h>
+
+/*
+ * Lowest log level compiled in: -1 debug, 0 info, 1 warn, 2 error,
+ * 3 test, see LogLevels. Calls below it compile to nothing.
+ */
+#ifndef BFS_LOG_LEVEL
+#  define BFS_LOG_LEVEL -1
+#endif
+
+static const int MAX_LOG_BUFFER = 4096;
+static const size_t MAX_LOG_RECORD = 512;           ///< Characters per record of the asynchronous writer
+static const size_t LOG_RING_CAPACITY = 1024;       ///< Records buffered by the asynchronous writer
+static const int LOG_IDLE_SLEEP_US = 1000;          ///< Pause of the asynchronous writer once its ring is empty
+static thread_local char __logbuffer[MAX_LOG_BUFFER];
+
+/*
+ * Log levels, also available as Log::loglevel_t
+ */
+struct LogLevels {
+    typedef enum {
+        LevelDebug = -1,
+        LevelInfo = 0,
+        LevelWarn = 1,
+        LevelError = 2,
+        LevelTest = 3
+    } loglevel_t;
+};
+
+/*
+ * Write one record
+ */
+static void printLogRecord(FILE* out, int level, const char* str) {
+    switch (level) {
+        case LogLevels::LevelDebug:
+            fprintf(out, "[DEBUG] %s\n", str);
+            break;
+
+        case LogLevels::LevelInfo:
+            fprintf(out, "[INFO]  %s\n", str);
+            break;
+
+        case LogLevels::LevelWarn:
+            fprintf(out, "[WARN]  %s\n", str);
+            break;
+
+        case LogLevels::LevelError:
+            fprintf(out, "[ERROR] %s\n", str);
+            break;
+
+        case LogLevels::LevelTest:
+            fprintf(out, "[TEST] %s\n", str);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ *
+ * Asynchronous log writer
+ *
+ * Callers claim a slot of a bounded ring buffer with one compare and
+ * swap and format their message straight into it; a background thread
+ * writes the slots out in order. If the ring is full the record is
+ * dropped instead of waiting, so logging never blocks or serializes the
+ * calling threads. Dropped records are counted and reported by the
+ * writer. Records longer than MAX_LOG_RECORD are truncated.
+ *
+ * Every slot carries a sequence number telling producers and the writer
+ * whose turn it is, as in Vyukov's bounded multi-producer queue.
+ *
+ */
+class AsyncLogWriter {
+
+    public:
+        /**
+         *
+         * Constructor
+         *
+         * @param out Stream receiving the records
+         * @param capacity Number of records in the ring, rounded up to
+         * a power of two
+         *
+         */
+        explicit AsyncLogWriter(FILE* out = stdout, size_t capacity = LOG_RING_CAPACITY)
+            : m_out(out) {
+            size_t size = 2;
+            while (size < capacity) size <<= 1;
+
+            m_slots.reset(new Slot[size]);
+            m_mask = size - 1;
+            for (size_t i = 0; i < size; i++) {
+                m_slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+
+            m_thread = std::thread([this] { run(); });
+        }
+
+        /**
+         *
+         * Destructor
+         *
+         * Writes all queued records before it returns.
+         *
+         */
+        ~AsyncLogWriter() {
+            m_stop.store(true, std::memory_order_release);
+            m_thread.join();
+        }
+
+        AsyncLogWriter(const AsyncLogWriter&) = delete;
+        AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+
+    public:
+        /**
+         *
+         * Queue a record
+         *
+         * @param level Log level
+         * @param str Message
+         * @return Returns false if the ring is full and the record has
+         * been dropped.
+         *
+         */
+        bool write(int level, const char* str) {
+            Slot* slot = claim();
+            if (nullptr == slot) {
+                return false;
+            }
+            snprintf(slot->text, MAX_LOG_RECORD, "%s", str);
+            publish(slot, level);
+            return true;
+        }
+
+        /**
+         *
+         * Format and queue a record
+         *
+         * @param level Log level
+         * @param format Format string
+         * @param args Format arguments
+         * @return Returns false if the ring is full and the record has
+         * been dropped.
+         *
+         */
+        bool writef(int level, const char* format, va_list args) {
+            Slot* slot = claim();
+            if (nullptr == slot) {
+                return false;
+            }
+            vsnprintf(slot->text, MAX_LOG_RECORD, format, args);
+            publish(slot, level);
+            return true;
+        }
+
+        /**
+         *
+         * Wait until all records queued so far have been written
+         *
+         */
+        void flush() {
+            size_t target = m_tail.load(std::memory_order_acquire);
+            while (m_head.load(std::memory_order_acquire) < target) {
+                std::this_thread::yield();
+            }
+            fflush(m_out);
+        }
+
+        uint64_t getNumWritten() const {
+            return m_written.load(std::memory_order_relaxed);
+        }
+
+        uint64_t getNumDropped() const {
+            return m_dropped.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Slot {
+            std::atomic<size_t>    sequence{0};
+            int                    level{0};
+            char                   text[MAX_LOG_RECORD];
+        };
+
+    private:
+        /**
+         *
+         * Claim the slot at the tail, or null if the ring is full
+         *
+         */
+        Slot* claim() {
+            size_t pos = m_tail.load(std::memory_order_relaxed);
+            while (true) {
+                Slot* slot = &m_slots[pos & m_mask];
+                intptr_t diff = (intptr_t) slot->sequence.load(std::memory_order_acquire) - (intptr_t) pos;
+
+                if (0 == diff) {
+                    if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        return slot;
+                    }
+                } else if (diff < 0) {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    m_unreported.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                } else {
+                    pos = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void publish(Slot* slot, int level) {
+            slot->level = level;
+            size_t pos = slot->sequence.load(std::memory_order_relaxed);
+            slot->sequence.store(pos + 1, std::memory_order_release);
+        }
+
+        /**
+         *
+         * Write all published records, returns their number
+         *
+         */
+        size_t drain() {
+            size_t head = m_head.load(std::memory_order_relaxed);
+            size_t count = 0;
+
+            while (true) {
+                Slot& slot = m_slots[head & m_mask];
+                if (slot.sequence.load(std::memory_order_acquire) != head + 1) break;
+
+                printLogRecord(m_out, slot.level, slot.text);
+                slot.sequence.store(head + m_mask + 1, std::memory_order_release);
+
+                head++;
+                count++;
+                m_head.store(head, std::memory_order_release);
+            }
+
+            m_written.fetch_add(count, std::memory_order_relaxed);
+
+            uint64_t dropped = m_unreported.exchange(0, std::memory_order_relaxed);
+            if (dropped > 0) {
+                fprintf(m_out, "[WARN]  %llu log records dropped\n", (unsigned long long) dropped);
+            }
+
+            return count;
+        }
+
+        void run() {
+            while (true) {
+                bool stopping = m_stop.load(std::memory_order_acquire);
+                if (drain() > 0) continue;
+                if (stopping) break;
+
+                fflush(m_out);
+                std::this_thread::sleep_for(std::chrono::microseconds(LOG_IDLE_SLEEP_US));
+            }
+            fflush(m_out);
+        }
+
+    private:
+        FILE*                     m_out;
+        std::unique_ptr<Slot[]>   m_slots;
+        size_t                    m_mask{0};
+        std::atomic<size_t>       m_tail{0};
+        std::atomic<size_t>       m_head{0};
+        std::atomic<uint64_t>     m_written{0};
+        std::atomic<uint64_t>     m_dropped{0};
+        std::atomic<uint64_t>     m_unreported{0};
+        std::atomic<bool>         m_stop{false};
+        std::thread               m_thread;
+
+};
+
+class Log : public LogLevels
+{
+    private:
+        static loglevel_t currentLogLevel;
+
+    public:
+        static void setLogLevel(loglevel_t logLevel) {
+            currentLogLevel = logLevel;
+        }
+
+        static loglevel_t getLogLevel() {
+            return currentLogLevel;
+        }
+
+        /**
+         *
+         * Check if a level is logged
+         *
+         * Levels below BFS_LOG_LEVEL are rejected at compile time.
+         * Arguments of direct calls are still evaluated; the LOG_*
+         * macros below skip them unless the level is enabled.
+         *
+         */
+        static bool isEnabled(int level) {
+            return level >= BFS_LOG_LEVEL && level >= (int)currentLogLevel;
+        }
+
+        /**
+         *
+         * Switch to the asynchronous writer
+         *
+         * Once enabled, records are written by a background thread (see
+         * AsyncLogWriter). Disabling flushes the queued records; the
+         * writer stays alive for threads still holding it and drains at
+         * exit.
+         *
+         */
+        static void setAsync(bool enabled) {
+            std::unique_ptr<AsyncLogWriter>& owner = asyncOwner();
+            if (enabled && nullptr == owner) {
+                owner.reset(new AsyncLogWriter());
+            }
+
+            asyncWriter().store(enabled ? owner.get() : nullptr, std::memory_order_release);
+            if (!enabled && nullptr != owner) {
+                owner->flush();
+            }
+        }
+
+        static bool isAsync() {
+            return nullptr != asyncWriter().load(std::memory_order_acquire);
+        }
+
+        /**
+         *
+         * Wait until all queued records have been written
+         *
+         */
+        static void flush() {
+            if (nullptr != asyncOwner()) {
+                asyncOwner()->flush();
+            }
+            fflush(stdout);
+        }
+
+        static uint64_t getNumDropped() {
+            return (nullptr != asyncOwner()) ? asyncOwner()->getNumDropped() : 0;
+        }
+
+    public:
+        static void log(int level, const char* str) {
+            write(level, str);
+        }
+
+        static void log(int level, const std::string& str) {
+            write(level, str.c_str());
+        }
+
+        static void logf(int level, const char* format, ...) {
+            if (!isEnabled(level)) return;
+            va_list args; va_start(args, format);
+            writef(level, format, args);
+            va_end(args);
+        }
+
+    public:
+        static void debug(const char* str) {
+            write(LevelDebug, str);
+        }
+
+        static void debug(const std::string& str) {
+            write(LevelDebug, str.c_str());
+        }
+
+        static void debugf(const char* format, ...) {
+            if (!isEnabled(LevelDebug)) return;
+            va_list args; va_start(args, format);
+            writef(LevelDebug, format, args);
+            va_end(args);
+        }
+
+        static void info(const char* str) {
+            write(LevelInfo, str);
+        }
+
+        static void info(const std::string& str) {
+            write(LevelInfo, str.c_str());
+        }
+
+        static void infof(const char* format, ...) {
+            if (!isEnabled(LevelInfo)) return;
+            va_list args; va_start(args, format);
+            writef(LevelInfo, format, args);
+            va_end(args);
+        }
+
+        static void warn(const char* str) {
+            write(LevelWarn, str);
+        }
+
+        static void warn(const std::string& str) {
+            write(LevelWarn, str.c_str());
+        }
+
+        static void warnf(const char* format, ...) {
+            if (!isEnabled(LevelWarn)) return;
+            va_list args; va_start(args, format);
+            writef(LevelWarn, format, args);
+            va_end(args);
+        }
+
+        static void error(const char* str) {
+            write(LevelError, str);
+        }
+
+        static void error(const std::string& str) {
+            write(LevelError, str.c_str());
+        }
+
+        static void errorf(const char* format, ...) {
+            if (!isEnabled(LevelError)) return;
+            va_list args; va_start(args, format);
+            writef(LevelError, format, args);
+            va_end(args);
+        }
+
+        static void test(const char* str) {
+            write(LevelTest, str);
+        }
+
+        static void test(const std::string& str) {
+            write(LevelTest, str.c_str());
+        }
+
+        static void testf(const char* format, ...) {
+            if (!isEnabled(LevelTest)) return;
+            va_list args; va_start(args, format);
+            writef(LevelTest, format, args);
+            va_end(args);
+        }
+
+    private:
+        /**
+         *
+         * Asynchronous writer and the pointer the log calls read
+         *
+         * Both live in one static so the pointer is cleared before the
+         * writer is destroyed at exit; log calls from later static
+         * destructors then fall back to direct writes.
+         *
+         */
+        struct AsyncState {
+            std::atomic<AsyncLogWriter*> writer{nullptr};
+            std::unique_ptr<AsyncLogWriter> owner;
+
+            ~AsyncState() {
+                writer.store(nullptr, std::memory_order_release);
+                owner.reset();
+            }
+        };
+
+        static AsyncState& asyncState() {
+            static AsyncState state;
+            return state;
+        }
+
+        static std::atomic<AsyncLogWriter*>& asyncWriter() {
+            return asyncState().writer;
+        }
+
+        static std::unique_ptr<AsyncLogWriter>& asyncOwner() {
+            return asyncState().owner;
+        }
+
+        static void write(int level, const char* str) {
+            if (!isEnabled(level)) return;
+
+            AsyncLogWriter* writer = asyncWriter().load(std::memory_order_acquire);
+            if (nullptr != writer) {
+                writer->write(level, str);
+                return;
+            }
+
+            printLogRecord(stdout, level, str);
+        }
+
+        static void writef(int level, const char* format, va_list args) {
+            if (!isEnabled(level)) return;
+
+            AsyncLogWriter* writer = asyncWriter().load(std::memory_order_acquire);
+            if (nullptr != writer) {
+                writer->writef(level, format, args);
+                return;
+            }
+
+            vsnprintf(__logbuffer, MAX_LOG_BUFFER, format, args);
+            printLogRecord(stdout, level, __logbuffer);
+        }
+
+};
+
+Log::loglevel_t Log::currentLogLevel = Log::LevelDebug;
+
+/*
+ * Level-checked logging: the arguments, e.g. concatenated strings, are
+ * only evaluated if the level is enabled, and the whole statement
+ * compiles to nothing below BFS_LOG_LEVEL.
+ */
+#define LOG_AT(level, call) do { if ((level) >= BFS_LOG_LEVEL && Log::isEnabled(level)) call; } while (0)
+
+#define LOG_DEBUG(...)   LOG_AT(Log::LevelDebug, Log::debug(__VA_ARGS__))
+#define LOG_DEBUGF(...)  LOG_AT(Log::LevelDebug, Log::debugf(__VA_ARGS__))
+#define LOG_INFO(...)    LOG_AT(Log::LevelInfo, Log::info(__VA_ARGS__))
+#define LOG_INFOF(...)   LOG_AT(Log::LevelInfo, Log::infof(__VA_ARGS__))
+#define LOG_WARN(...)    LOG_AT(Log::LevelWarn, Log::warn(__VA_ARGS__))
+#define LOG_WARNF(...)   LOG_AT(Log::LevelWarn, Log::warnf(__VA_ARGS__))
+#define LOG_ERROR(...)   LOG_AT(Log::LevelError, Log::error(__VA_ARGS__))
+#define LOG_ERRORF(...)  LOG_AT(Log::LevelError, Log::errorf(__VA_ARGS__))
@@ -0,0 +1,242 @@
+/**
+ *
+ * SIMD Key Scan
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#  define SIMD_X86 1
+#  include <immintrin.h>
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  endif
+#endif
+
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#  define SIMD_TARGET_SSE2 __attribute__((target("sse2")))
+#  define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#  define SIMD_TARGET_SSE2
+#  define SIMD_TARGET_AVX2
+#endif
+
+/**
+ *
+ * SIMD key scan
+ *
+ * This class finds the first occurrence of a 32-bit key in an array,
+ * either stored contiguously or gathered through an index array (e.g. the
+ * identifier handles of a frontier of nodes). The instruction set is
+ * selected at runtime: AVX2 compares and gathers eight keys at once,
+ * SSE2 compares four, and a scalar loop covers other CPUs and the tail
+ * of every scan.
+ *
+ */
+class Simd {
+
+	public:
+		/**
+		 *
+		 * Instruction set level
+		 *
+		 */
+		typedef enum {
+			LevelScalar = 0,    ///< Plain loop
+			LevelSse2 = 1,      ///< Four keys per compare
+			LevelAvx2 = 2       ///< Eight keys per compare and gather
+		} level_t;
+
+	public:
+		/**
+		 *
+		 * Get best level supported by the CPU
+		 *
+		 */
+		static level_t supportedLevel() {
+#if defined(SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+			if (__builtin_cpu_supports("avx2")) return LevelAvx2;
+			if (__builtin_cpu_supports("sse2")) return LevelSse2;
+#elif defined(SIMD_X86) && defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] >= 7) {
+				__cpuidex(info, 7, 0);
+				if (info[1] & (1 << 5)) return LevelAvx2;
+			}
+			__cpuid(info, 1);
+			if (info[3] & (1 << 26)) return LevelSse2;
+#endif
+			return LevelScalar;
+		}
+
+		/**
+		 *
+		 * Get level used by the scans
+		 *
+		 */
+		static level_t getLevel() {
+			return current().load(std::memory_order_relaxed);
+		}
+
+		/**
+		 *
+		 * Set level used by the scans
+		 *
+		 * @param level Requested level, capped at supportedLevel()
+		 *
+		 */
+		static void setLevel(level_t level) {
+			current().store((level < supportedLevel()) ? level : supportedLevel(), std::memory_order_relaxed);
+		}
+
+		/**
+		 *
+		 * Find a key in an array
+		 *
+		 * @param values Array to be scanned
+		 * @param count Number of values
+		 * @param key Key to be found
+		 * @return Returns the position of the first value equal to the
+		 * key, or count if there is none.
+		 *
+		 */
+		static size_t find(const uint32_t* values, size_t count, uint32_t key) {
+			size_t pos = 0;
+
+#ifdef SIMD_X86
+			level_t level = current().load(std::memory_order_relaxed);
+			if (LevelAvx2 == level) {
+				pos = findAvx2(values, count, key);
+			} else if (LevelSse2 == level) {
+				pos = findSse2(values, count, key);
+			}
+#endif
+
+			for (; pos < count; pos++) {
+				if (values[pos] == key) break;
+			}
+			return pos;
+		}
+
+		/**
+		 *
+		 * Find a key in an array gathered through indices
+		 *
+		 * @param table Array holding the values
+		 * @param tableSize Number of entries of the table
+		 * @param indices Positions in the table to be checked
+		 * @param count Number of indices
+		 * @param key Key to be found
+		 * @return Returns the first i with table[indices[i]] equal to the
+		 * key, or count if there is none.
+		 *
+		 */
+		static size_t findIndexed(const uint32_t* table, size_t tableSize, const uint32_t* indices, size_t count, uint32_t key) {
+			size_t pos = 0;
+
+#ifdef SIMD_X86
+			// the gather takes signed 32-bit offsets
+			if (LevelAvx2 == current().load(std::memory_order_relaxed) && tableSize <= (size_t) INT32_MAX) {
+				pos = findIndexedAvx2(table, indices, count, key);
+			}
+#else
+			(void) tableSize;
+#endif
+
+			for (; pos < count; pos++) {
+				if (table[indices[pos]] == key) break;
+			}
+			return pos;
+		}
+
+	private:
+		/**
+		 *
+		 * Level shared by all threads, setLevel() may run concurrently with scans
+		 *
+		 */
+		static std::atomic<level_t>& current() {
+			static std::atomic<level_t> level{supportedLevel()};
+			return level;
+		}
+
+		static unsigned firstBit(unsigned mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return (unsigned) index;
+#else
+			return (unsigned) __builtin_ctz(mask);
+#endif
+		}
+
+#ifdef SIMD_X86
+		/**
+		 *
+		 * Scan full blocks of four values, returns the match or the start of the tail
+		 *
+		 */
+		SIMD_TARGET_SSE2
+		static size_t findSse2(const uint32_t* values, size_t count, uint32_t key) {
+			__m128i needle = _mm_set1_epi32((int) key);
+
+			size_t pos = 0;
+			for (; pos + 4 <= count; pos += 4) {
+				__m128i block = _mm_loadu_si128((const __m128i*) (values + pos));
+				int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, needle)));
+				if (0 != mask) {
+					return pos + firstBit((unsigned) mask);
+				}
+			}
+			return pos;
+		}
+
+		/**
+		 *
+		 * Scan full blocks of eight values, returns the match or the start of the tail
+		 *
+		 */
+		SIMD_TARGET_AVX2
+		static size_t findAvx2(const uint32_t* values, size_t count, uint32_t key) {
+			__m256i needle = _mm256_set1_epi32((int) key);
+
+			size_t pos = 0;
+			for (; pos + 8 <= count; pos += 8) {
+				__m256i block = _mm256_loadu_si256((const __m256i*) (values + pos));
+				int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle)));
+				if (0 != mask) {
+					return pos + firstBit((unsigned) mask);
+				}
+			}
+			return pos;
+		}
+
+		/**
+		 *
+		 * Gather and scan full blocks of eight values, returns the match or the start of the tail
+		 *
+		 */
+		SIMD_TARGET_AVX2
+		static size_t findIndexedAvx2(const uint32_t* table, const uint32_t* indices, size_t count, uint32_t key) {
+			__m256i needle = _mm256_set1_epi32((int) key);
+
+			size_t pos = 0;
+			for (; pos + 8 <= count; pos += 8) {
+				__m256i offsets = _mm256_loadu_si256((const __m256i*) (indices + pos));
+				__m256i block = _mm256_i32gather_epi32((const int*) table, offsets, 4);
+				int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle)));
+				if (0 != mask) {
+					return pos + firstBit((unsigned) mask);
+				}
+			}
+			return pos;
+		}
+#endif
+
+};
@@ -0,0 +1,259 @@
+/**
+ *
+ * String Pool
+ *
+ */
+
+#pragma once
+
+#include <auxiliary/hashindex.h>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef uint32_t StringHandle;                                  ///< Offset of an interned string in its pool
+static const StringHandle INVALID_STRING_HANDLE = UINT32_MAX;   ///< Marker for "not interned"
+
+class StringPool;
+typedef std::shared_ptr<StringPool> StringPoolRef;
+
+/**
+ *
+ * String pool
+ *
+ * This class interns strings into one contiguous arena. Every distinct
+ * string is stored once as [32-bit length][characters][terminating zero]
+ * and referenced by its byte offset (handle). Two strings of the same
+ * pool are equal exactly if their handles are equal, so comparisons on
+ * hot paths become integer compares.
+ *
+ * Handles stay valid while the pool grows; pointers returned by c_str()
+ * are invalidated by the next intern(). As handles are 32-bit offsets a
+ * pool holds less than 4 GiB; intern() fails once that would overflow.
+ *
+ */
+class StringPool {
+
+	public:
+		StringPool() {
+			clear();
+		}
+
+	public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @return Returns a reference to the created pool
+		 *
+		 */
+		static StringPoolRef createInstance() {
+			return std::make_shared<StringPool>();
+		}
+
+	public:
+		/**
+		 *
+		 * Intern a string
+		 *
+		 * @param str String to be interned
+		 * @return Returns the handle of the pooled copy of the string, or
+		 * INVALID_STRING_HANDLE if the pool is full.
+		 *
+		 */
+		StringHandle intern(const std::string& str) {
+			return intern(str.data(), str.size());
+		}
+
+		/**
+		 *
+		 * Intern a string given by its characters
+		 *
+		 * @param data Pointer to the characters
+		 * @param length Number of characters
+		 * @return Returns the handle of the pooled copy of the string, or
+		 * INVALID_STRING_HANDLE if the pool is full.
+		 *
+		 */
+		StringHandle intern(const char* data, size_t length) {
+			// offsets and lengths have 32 bits, checked before the characters are read
+			if ((uint64_t) length >= INVALID_STRING_HANDLE) {
+				return INVALID_STRING_HANDLE;
+			}
+
+			uint64_t hash = HashIndex::hashKey(data, length);
+
+			StringHandle handle = m_index.find(hash, Match{this, data, length});
+			if (INVALID_STRING_HANDLE != handle) {
+				return handle;
+			}
+
+			uint32_t size = (uint32_t) length;
+			if ((uint64_t) m_data.size() + sizeof(size) + size + 1 >= INVALID_STRING_HANDLE) {
+				return INVALID_STRING_HANDLE;
+			}
+
+			handle = (StringHandle) m_data.size();
+
+			m_data.resize(m_data.size() + sizeof(size) + size + 1);
+			std::memcpy(&m_data[handle], &size, sizeof(size));
+			std::memcpy(&m_data[handle + sizeof(size)], data, size);
+			m_data[handle + sizeof(size) + size] = '\0';
+
+			m_index.insert(hash, handle, Match{this, data, length});
+			m_count++;
+
+			return handle;
+		}
+
+		/**
+		 *
+		 * Look up a string without interning it
+		 *
+		 * @param str String to be found
+		 * @return Returns the handle of the string, or INVALID_STRING_HANDLE
+		 * if it has never been interned.
+		 *
+		 */
+		StringHandle lookup(const std::string& str) const {
+			return m_index.find(HashIndex::hashKey(str), Match{this, str.data(), str.size()});
+		}
+
+		/**
+		 *
+		 * Get string length
+		 *
+		 * @param handle Handle of an interned string
+		 * @return Returns the number of characters.
+		 *
+		 */
+		size_t length(StringHandle handle) const {
+			return length(m_data.data(), handle);
+		}
+
+		/**
+		 *
+		 * Get string characters
+		 *
+		 * @param handle Handle of an interned string
+		 * @return Returns a pointer to the zero terminated characters.
+		 *
+		 */
+		const char* c_str(StringHandle handle) const {
+			return c_str(m_data.data(), handle);
+		}
+
+		/**
+		 *
+		 * Get string copy
+		 *
+		 * @param handle Handle of an interned string
+		 * @return Returns a copy of the string.
+		 *
+		 */
+		std::string str(StringHandle handle) const {
+			return std::string(c_str(handle), length(handle));
+		}
+
+		/**
+		 *
+		 * Compare an interned string with a given one
+		 *
+		 * @param handle Handle of an interned string
+		 * @param str String to compare with
+		 * @return Returns true if both are equal, false otherwise.
+		 *
+		 */
+		bool equals(StringHandle handle, const std::string& str) const {
+			return length(handle) == str.size() && 0 == std::memcmp(c_str(handle), str.data(), str.size());
+		}
+
+		/**
+		 *
+		 * Get raw pool bytes
+		 *
+		 * @return Returns a pointer to bytes() bytes in the layout
+		 * described above, valid until the next intern().
+		 *
+		 */
+		const char* data() const {
+			return m_data.data();
+		}
+
+		/**
+		 *
+		 * Get string length from raw pool bytes
+		 *
+		 * @param data Pool bytes, see data()
+		 * @param handle Handle of a string stored in data
+		 * @return Returns the number of characters.
+		 *
+		 */
+		static size_t length(const char* data, StringHandle handle) {
+			uint32_t length;
+			std::memcpy(&length, data + handle, sizeof(length));
+			return length;
+		}
+
+		/**
+		 *
+		 * Get string characters from raw pool bytes
+		 *
+		 * @param data Pool bytes, see data()
+		 * @param handle Handle of a string stored in data
+		 * @return Returns a pointer to the zero terminated characters.
+		 *
+		 */
+		static const char* c_str(const char* data, StringHandle handle) {
+			return data + handle + sizeof(uint32_t);
+		}
+
+		/**
+		 *
+		 * Get number of distinct strings
+		 *
+		 */
+		size_t size() const {
+			return m_count;
+		}
+
+		/**
+		 *
+		 * Get arena size in bytes
+		 *
+		 */
+		size_t bytes() const {
+			return m_data.size();
+		}
+
+		/**
+		 *
+		 * Remove all strings
+		 *
+		 */
+		void clear() {
+			m_data.clear();
+			m_index.clear();
+			m_count = 0;
+		}
+
+	private:
+		struct Match {
+			const StringPool* pool;
+			const char* data;
+			size_t length;
+
+			bool operator()(uint32_t handle) const {
+				return pool->length(handle) == length && 0 == std::memcmp(pool->c_str(handle), data, length);
+			}
+		};
+
+	private:
+		std::vector<char>   m_data;
+		HashIndex           m_index;
+		size_t              m_count{0};
+
+};
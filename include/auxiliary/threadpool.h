@@ -0,0 +1,280 @@
+/**
+ *
+ * Work-Stealing Thread Pool
+ *
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool;
+typedef std::shared_ptr<ThreadPool> ThreadPoolRef;
+
+/**
+ *
+ * Thread pool
+ *
+ * Every worker owns a task deque. Workers pop their own tasks from the
+ * back and steal from the front of other deques when they run dry, so a
+ * skewed set of tasks still keeps every worker busy. Idle workers park
+ * on a condition variable and stay alive between jobs.
+ *
+ * The thread that calls parallelFor() takes part in the job, so a pool
+ * of size N runs N-1 background threads.
+ *
+ */
+class ThreadPool {
+
+	public:
+		typedef std::function<void(void)> Task;
+
+	public:
+		/**
+		 *
+		 * Constructor
+		 *
+		 * @param numThreads Number of threads including the calling
+		 * thread, zero selects the number of hardware threads
+		 *
+		 */
+		explicit ThreadPool(size_t numThreads = 0) {
+			if (0 == numThreads) {
+				numThreads = std::max(1u, std::thread::hardware_concurrency());
+			}
+
+			m_size = numThreads;
+
+			for (size_t i = 1; i < numThreads; i++) {
+				m_workers.emplace_back(new Worker());
+			}
+			for (size_t i = 0; i < m_workers.size(); i++) {
+				m_threads.emplace_back([this, i] { workerLoop(i); });
+			}
+		}
+
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(m_parkLock);
+				m_stop = true;
+			}
+			m_parkCond.notify_all();
+
+			for (auto& thread : m_threads) {
+				thread.join();
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+	public:
+		/**
+		 *
+		 * Factory method
+		 *
+		 * @param numThreads Number of threads including the calling
+		 * thread, zero selects the number of hardware threads
+		 * @return Returns a reference to the created pool
+		 *
+		 */
+		static ThreadPoolRef createInstance(size_t numThreads = 0) {
+			return std::make_shared<ThreadPool>(numThreads);
+		}
+
+	public:
+		/**
+		 *
+		 * Get pool size
+		 *
+		 * @return Returns the number of threads including the calling thread.
+		 *
+		 */
+		size_t size() const {
+			return m_size;
+		}
+
+		/**
+		 *
+		 * Submit a task
+		 *
+		 * The task runs asynchronously on one of the workers. Tasks
+		 * submitted from a worker go to the back of its own deque.
+		 *
+		 * @param task Task to be executed
+		 *
+		 */
+		void submit(Task task) {
+			if (m_workers.empty()) {
+				task();
+				return;
+			}
+
+			size_t index = (this == currentPool())
+				? currentIndex()
+				: (m_nextWorker.fetch_add(1, std::memory_order_relaxed) % m_workers.size());
+
+			push(index, std::move(task));
+		}
+
+		/**
+		 *
+		 * Run a function on a number of chunks and wait for completion
+		 *
+		 * Chunk 0 runs on the calling thread, the remaining chunks are
+		 * spread across the worker deques. While waiting the calling
+		 * thread helps out with queued tasks.
+		 *
+		 * @param numChunks Number of chunks
+		 * @param fn Function called once per chunk index
+		 *
+		 */
+		template <typename Fn>
+		void parallelFor(size_t numChunks, const Fn& fn) {
+			if (numChunks <= 1 || m_workers.empty()) {
+				for (size_t chunk = 0; chunk < numChunks; chunk++) {
+					fn(chunk);
+				}
+				return;
+			}
+
+			std::atomic<size_t> remaining(numChunks - 1);
+
+			for (size_t chunk = numChunks - 1; chunk >= 1; chunk--) {
+				submit([&fn, &remaining, chunk] {
+					fn(chunk);
+					remaining.fetch_sub(1, std::memory_order_release);
+				});
+			}
+
+			fn(0);
+
+			while (remaining.load(std::memory_order_acquire) > 0) {
+				Task task;
+				if (take(task)) {
+					task();
+				} else {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+	private:
+		struct Worker {
+			std::mutex          lock;
+			std::deque<Task>    tasks;
+		};
+
+		static ThreadPool*& currentPool() {
+			static thread_local ThreadPool* pool = nullptr;
+			return pool;
+		}
+
+		static size_t& currentIndex() {
+			static thread_local size_t index = 0;
+			return index;
+		}
+
+		void push(size_t index, Task&& task) {
+			{
+				std::lock_guard<std::mutex> lock(m_workers[index]->lock);
+				m_workers[index]->tasks.push_back(std::move(task));
+			}
+
+			m_queued.fetch_add(1, std::memory_order_release);
+			{
+				std::lock_guard<std::mutex> lock(m_parkLock);
+			}
+			m_parkCond.notify_one();
+		}
+
+		bool popBack(size_t index, Task& task) {
+			Worker& worker = *m_workers[index];
+			std::lock_guard<std::mutex> lock(worker.lock);
+			if (worker.tasks.empty()) return false;
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+			m_queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		bool popFront(size_t index, Task& task) {
+			Worker& worker = *m_workers[index];
+			std::lock_guard<std::mutex> lock(worker.lock);
+			if (worker.tasks.empty()) return false;
+			task = std::move(worker.tasks.front());
+			worker.tasks.pop_front();
+			m_queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		/**
+		 *
+		 * Take a task, own deque first, then steal round-robin
+		 *
+		 */
+		bool take(Task& task) {
+			if (0 == m_queued.load(std::memory_order_acquire)) {
+				return false;
+			}
+
+			bool isWorker = (this == currentPool());
+			size_t self = isWorker ? currentIndex() : 0;
+
+			if (isWorker && popBack(self, task)) {
+				return true;
+			}
+
+			for (size_t i = 1; i <= m_workers.size(); i++) {
+				size_t victim = (self + i) % m_workers.size();
+				if (popFront(victim, task)) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		void workerLoop(size_t index) {
+			currentPool() = this;
+			currentIndex() = index;
+
+			while (true) {
+				Task task;
+				if (take(task)) {
+					task();
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(m_parkLock);
+				m_parkCond.wait(lock, [this] {
+					return m_stop || m_queued.load(std::memory_order_acquire) > 0;
+				});
+
+				if (m_stop && 0 == m_queued.load(std::memory_order_acquire)) {
+					return;
+				}
+			}
+		}
+
+	private:
+		size_t                                  m_size{1};
+		std::vector<std::unique_ptr<Worker>>    m_workers;
+		std::vector<std::thread>                m_threads;
+
+		std::mutex                              m_parkLock;
+		std::condition_variable                 m_parkCond;
+		std::atomic<size_t>                     m_queued{0};
+		std::atomic<size_t>                     m_nextWorker{0};
+		bool                                    m_stop{false};
+
+};
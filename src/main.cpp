@@ -1,48 +1,115 @@
-/**
- *
- * main
- *
- */
-
-#ifdef _WIN32
-#  ifndef _CRT_SECURE_NO_WARNINGS
-#    define _CRT_SECURE_NO_WARNINGS
-#  endif
-#endif
-
-#include <app/app.h>
-
-#include <auxiliary/logger.h>
-#include <auxiliary/test.h>
-
-#include <chrono>
-#include <cstring>
-
-IMPLEMENT_TESTRUNNER();
-
-int main(int argc, char* argv[]) {
-    
-    Log::setLogLevel(Log::LevelInfo);
-
-    if (argc >= 2 && 0 == std::strcmp(argv[1], "--test")) {
-        RUN_TESTS("");
-    } else {
-
-        printf("************************\n");
-        printf("* BREADTH-FIRST-SEARCH *\n");
-        printf("************************\n\n");
-        printf("Performing breadth-first-search...\n");
-
-        auto tStart = std::chrono::high_resolution_clock::now();
-
-        int result = Application().run();
-
-        auto tElapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
-
-        printf("Execution time was %0.3f seconds.\n", tElapsed);
-
-        return result;
-    }
-
-    return 0;
-}
+/**
+ *
+ * main
+ *
+ */
+
+#ifdef _WIN32
+#  ifndef _CRT_SECURE_NO_WARNINGS
+#    define _CRT_SECURE_NO_WARNINGS
+#  endif
+#endif
+
+#include <app/app.h>
+#include <app/benchmark.h>
+#include <app/partition.h>
+
+#include <auxiliary/logger.h>
+#include <auxiliary/test.h>
+
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+IMPLEMENT_TESTRUNNER();
+
+/**
+ *
+ * Parse a positive integer argument value
+ *
+ * @param name Argument name, for the error message
+ * @param value Argument value, nullptr if it is missing
+ * @param result Receives the parsed value
+ * @return Returns true if the whole value is a number above zero,
+ * false otherwise.
+ *
+ */
+static bool parsePositive(const char* name, const char* value, int& result) {
+    if (nullptr == value) {
+        LOG_ERRORF("missing value for %s", name);
+        return false;
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    long parsed = std::strtol(value, &end, 10);
+    if (end == value || '\0' != *end || ERANGE == errno || parsed <= 0 || parsed > INT_MAX) {
+        LOG_ERRORF("invalid value %s for %s, expected a positive number", value, name);
+        return false;
+    }
+
+    result = (int) parsed;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    
+    // shard processes of a PartitionedGraph, started by the program itself
+    if (argc >= 2 && 0 == std::strcmp(argv[1], PARTITION_SHARD_ARGUMENT)) {
+        return PartitionedGraph::runShard() ? 0 : -1;
+    }
+
+    Log::setLogLevel(Log::LevelInfo);
+
+    if (argc >= 2 && 0 == std::strcmp(argv[1], "--test")) {
+        RUN_TESTS("");
+    } else if (argc >= 2 && 0 == std::strcmp(argv[1], "--bench")) {
+
+        // keep the report on stdout machine-readable, and logging off the query threads
+        Log::setLogLevel(Log::LevelWarn);
+        Log::setAsync(true);
+
+        BenchmarkConfig config;
+        if (!Benchmark::parseArguments(argc - 2, argv + 2, config)) {
+            return -1;
+        }
+
+        return Benchmark(config).run() ? 0 : -1;
+
+    } else {
+
+        int levels = NUM_DATASET_LEVELS;
+        int nodes = NUM_DATASET_NODES;
+
+        for (int i = 1; i < argc; i += 2) {
+            const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            if (0 == std::strcmp(argv[i], "--levels")) {
+                if (!parsePositive(argv[i], value, levels)) return -1;
+            } else if (0 == std::strcmp(argv[i], "--fanout")) {
+                if (!parsePositive(argv[i], value, nodes)) return -1;
+            } else {
+                LOG_ERRORF("unknown argument %s", argv[i]);
+                return -1;
+            }
+        }
+
+        printf("************************\n");
+        printf("* BREADTH-FIRST-SEARCH *\n");
+        printf("************************\n\n");
+        printf("Performing breadth-first-search...\n");
+
+        auto tStart = std::chrono::high_resolution_clock::now();
+
+        int result = Application(levels, nodes).run();
+
+        auto tElapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+        printf("Execution time was %0.3f seconds.\n", tElapsed);
+
+        return result;
+    }
+
+    return 0;
+}